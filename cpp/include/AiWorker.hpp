@@ -0,0 +1,39 @@
+//
+// Runs the engine search off the GUI thread, owned by Scene.
+//
+
+#ifndef AIWORKER_H
+#define AIWORKER_H
+#include <QObject>
+#include <QMetaType>
+
+#include "game.hpp"
+
+Q_DECLARE_METATYPE(SearchProgress)
+
+class AiWorker : public QObject {
+    Q_OBJECT
+public:
+    explicit AiWorker(Game *game, QObject *parent = nullptr);
+    // Called from the GUI thread, the game must not be touched until searchFinished
+    void start(int color);
+    // Same for Game::analyze, the lines land in analysis
+    void startAnalysis(int color, int count);
+    // Called from the GUI thread, the running search finishes with its best move so far
+    void stop();
+    // Valid after searchFinished
+    Move result;
+    std::vector<RootLine> analysis;
+private:
+    Game *game;
+    SearchControl control;
+private slots:
+    void run(int color);
+    void runAnalysis(int color, int count);
+signals:
+    // Emitted on the worker thread after every root move, connections to the GUI are queued
+    void progressed(SearchProgress progress);
+    void searchFinished();
+};
+
+#endif //AIWORKER_H
@@ -0,0 +1,95 @@
+//
+// Whole board bit operations over the row bitboards of Board.
+//
+
+#ifndef GOMOKU_BITBOARD_HPP
+#define GOMOKU_BITBOARD_HPP
+#include <cstdint>
+#include <type_traits>
+
+// Row bitboard wide enough for N cells, 15x15 fits in 16 bits
+template<int N>
+using BitRow = typename std::conditional<(N <= 16), uint16_t, uint32_t>::type;
+
+// One bit per cell, row y holds cell x at bit (TOP >> x) like Board::black_board
+template<int N>
+struct BitRows
+{
+    using Row = BitRow<N>;
+    constexpr static Row FULL = (1u << N) - 1;
+    constexpr static Row TOP = 1u << (N - 1);
+
+    Row row[N]{};
+
+    static BitRows of(const Row rows[N]) {
+        BitRows b;
+        for (int y = 0; y < N; ++y)
+            b.row[y] = rows[y];
+        return b;
+    }
+    // Cells with x and y in [from, to)
+    static BitRows area(int from, int to) {
+        BitRows b;
+        for (int y = from; y < to; ++y)
+            b.row[y] = (FULL >> from) & ~(FULL >> to);
+        return b;
+    }
+
+    bool test(int x, int y) const {
+        return row[y] & (TOP >> x);
+    }
+    bool any() const {
+        Row r{0};
+        for (int y = 0; y < N; ++y)
+            r |= row[y];
+        return r;
+    }
+    int count() const {
+        int c{0};
+        for (int y = 0; y < N; ++y)
+            c += __builtin_popcount(row[y]);
+        return c;
+    }
+
+    // Cell (x, y) of the result is cell (x + dx, y + dy) of this, cells from outside the board are unset
+    BitRows shifted(int dx, int dy) const {
+        BitRows b;
+        for (int y = 0; y < N; ++y)
+        {
+            if (y + dy < 0 || y + dy >= N)
+                continue;
+            const uint32_t r = row[y + dy];
+            b.row[y] = (dx >= 0 ? r << dx : r >> -dx) & FULL;
+        }
+        return b;
+    }
+
+    BitRows operator&(const BitRows &o) const {
+        BitRows b;
+        for (int y = 0; y < N; ++y)
+            b.row[y] = row[y] & o.row[y];
+        return b;
+    }
+    BitRows operator|(const BitRows &o) const {
+        BitRows b;
+        for (int y = 0; y < N; ++y)
+            b.row[y] = row[y] | o.row[y];
+        return b;
+    }
+    BitRows operator~() const {
+        BitRows b;
+        for (int y = 0; y < N; ++y)
+            b.row[y] = ~row[y] & FULL;
+        return b;
+    }
+    BitRows &operator|=(const BitRows &o) {
+        for (int y = 0; y < N; ++y)
+            row[y] |= o.row[y];
+        return *this;
+    }
+};
+
+template<int N> constexpr typename BitRows<N>::Row BitRows<N>::FULL;
+template<int N> constexpr typename BitRows<N>::Row BitRows<N>::TOP;
+
+#endif //GOMOKU_BITBOARD_HPP
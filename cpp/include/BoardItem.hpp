@@ -0,0 +1,52 @@
+//
+// The whole board as one item, painted from the cell definitions with cached pixmaps.
+//
+
+#ifndef GOMOKU_BOARDITEM_HPP
+#define GOMOKU_BOARDITEM_HPP
+#include <QGraphicsItem>
+#include <QHash>
+#include <QPainter>
+#include <QPixmap>
+#include <QPoint>
+#include <QRectF>
+#include <QSet>
+#include <QStyleOptionGraphicsItem>
+
+#include "Scene.hpp"
+
+class BoardItem : public QGraphicsItem {
+public:
+    // pSize square cells, the pieces are scaled to it once
+    BoardItem(int pSize, const QPixmap &white, const QPixmap &black);
+    QRectF boundingRect() const override;
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
+
+    const Scene::TokenDef &def(int x, int y) const;
+    // Repaints the cell only when its definition changed
+    void setDef(int x, int y, const Scene::TokenDef &d);
+    void setColor(int x, int y, Scene::TokenColor color);
+    void setHighlight(int x, int y, const QColor &highlight);
+    // Takes the highlight and text off the cells that have one, no other cell is visited
+    void clearDecorations();
+    // The cell under pos in item coordinates, (-1, -1) outside the board
+    QPoint cellAt(const QPointF &pos) const;
+
+protected:
+    void hoverMoveEvent(QGraphicsSceneHoverEvent *event) override;
+    void hoverLeaveEvent(QGraphicsSceneHoverEvent *event) override;
+
+private:
+    const int pSize;
+    QPixmap pieces[3];
+    QHash<QRgb, QPixmap> rings;
+    Scene::TokenDef cells[GSIZE][GSIZE];
+    QSet<int> decorated;    // y * GSIZE + x of the cells with a highlight or text
+    QPoint hovered{-1, -1};
+
+    QRectF cellRect(int x, int y) const;
+    const QPixmap &ring(const QColor &color);
+    void setHovered(QPoint cell);
+};
+
+#endif //GOMOKU_BOARDITEM_HPP
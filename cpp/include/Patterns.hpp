@@ -52,22 +52,24 @@ constexpr int8_t ALL_DIRS[4][2] = {
 #endif
 class Patterns {
 public:
-    static void getFlat(int x, int y, int dx, int dy, uint8_t v, uint8_t extent, const int32_t bb[BOARD_SIZE], const int32_t bw[BOARD_SIZE], char res[BOARD_SIZE]) {
-        res[BOARD_SIZE/2] = '0' + v;
+    template<int N = BOARD_SIZE, typename Row>
+    static void getFlat(int x, int y, int dx, int dy, uint8_t v, uint8_t extent, const Row bb[N], const Row bw[N], char res[N]) {
+        constexpr Row TOP = 1u << (N - 1);
+        res[N/2] = '0' + v;
         int xx, yy;
         for (int i = 1; i <= extent; ++i) {
             xx = x + i * dx;
             yy = y + i * dy;
-            if (xx > BOARD_SIZE-1 || xx < 0 || yy > BOARD_SIZE-1 || yy < 0)
-                res[BOARD_SIZE/2 + i] = res[BOARD_SIZE/2 + i - 1] == ']' ? '.' : ']';
+            if (xx > N-1 || xx < 0 || yy > N-1 || yy < 0)
+                res[N/2 + i] = res[N/2 + i - 1] == ']' ? '.' : ']';
             else
-                res[BOARD_SIZE/2 + i] = bb[yy] & 262144 >> xx ? '1' : (bw[yy] & 262144 >> xx ? '2' : '0');
+                res[N/2 + i] = bb[yy] & TOP >> xx ? '1' : (bw[yy] & TOP >> xx ? '2' : '0');
             xx = x - i * dx;
             yy = y - i * dy;
-            if (xx > BOARD_SIZE-1 || xx < 0 || yy > BOARD_SIZE-1 || yy < 0)
-                res[BOARD_SIZE/2 - i] = res[BOARD_SIZE/2 - i + 1] == '[' ? '.' : '[';
+            if (xx > N-1 || xx < 0 || yy > N-1 || yy < 0)
+                res[N/2 - i] = res[N/2 - i + 1] == '[' ? '.' : '[';
             else
-                res[BOARD_SIZE/2 - i] = bb[yy] & 262144 >> xx ? '1' : (bw[yy] & 262144 >> xx ? '2' : '0');
+                res[N/2 - i] = bb[yy] & TOP >> xx ? '1' : (bw[yy] & TOP >> xx ? '2' : '0');
         }
     }
 
@@ -0,0 +1,49 @@
+//
+// Rule variants the board and the search are instantiated with.
+// Every member is a compile time constant, so a variant costs nothing in the search.
+//
+
+#ifndef GOMOKU_RULES_HPP
+#define GOMOKU_RULES_HPP
+
+// Pairs are captured, five captured pairs win, double three and moving into a capture are forbidden
+struct ProCaptures
+{
+    constexpr static const char *name = "pro-captures";
+    constexpr static bool captures = true;
+    constexpr static bool capture_win = true;
+    constexpr static bool double_three(bool is_black) { return (void)is_black, true; }
+    constexpr static bool exact_five(bool is_black) { return (void)is_black, false; }
+};
+
+// Five or more in a row wins, nothing else
+struct Freestyle
+{
+    constexpr static const char *name = "freestyle";
+    constexpr static bool captures = false;
+    constexpr static bool capture_win = false;
+    constexpr static bool double_three(bool is_black) { return (void)is_black, false; }
+    constexpr static bool exact_five(bool is_black) { return (void)is_black, false; }
+};
+
+// Exactly five in a row wins, overlines do not
+struct StandardGomoku
+{
+    constexpr static const char *name = "standard";
+    constexpr static bool captures = false;
+    constexpr static bool capture_win = false;
+    constexpr static bool double_three(bool is_black) { return (void)is_black, false; }
+    constexpr static bool exact_five(bool is_black) { return (void)is_black, true; }
+};
+
+// Black may not make a double three and only wins with exactly five, white plays freestyle
+struct RenjuLike
+{
+    constexpr static const char *name = "renju";
+    constexpr static bool captures = false;
+    constexpr static bool capture_win = false;
+    constexpr static bool double_three(bool is_black) { return is_black; }
+    constexpr static bool exact_five(bool is_black) { return is_black; }
+};
+
+#endif //GOMOKU_RULES_HPP
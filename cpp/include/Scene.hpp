@@ -15,12 +15,14 @@
 #include <QPoint>
 #include <QPointF>
 #include <QColor>
+#include <QThread>
 #include <utility>
 
+#include "AiWorker.hpp"
 #include "game.hpp"
 #include "windialog.hpp"
 
-class Token;
+class BoardItem;
 
 class Scene : public QGraphicsScene {
     Q_OBJECT
@@ -35,12 +37,16 @@ public:
     static int intFromTokenColor(TokenColor v);
     class TokenDef {
     public:
+        TokenDef() = default;
         TokenDef(TokenColor c, QColor h, QString t):
             color(c)
             , highlight(std::move(h))
             , text(std::move(t))
         {
         }
+        bool operator==(const TokenDef &o) const {
+            return color == o.color && highlight == o.highlight && text == o.text;
+        }
 
         TokenColor color = EMPTY;
         QColor highlight = QColor(Qt::transparent);
@@ -50,6 +56,8 @@ public:
     const int offsetX = 69;
     const int pSize = 40;
     const int pHeight = 40 / 2;
+    // Moves shown by onAnalyze
+    const int analysisLines = 10;
     bool devMode = false;
     bool showMask = false;
     bool pvpMode = false;
@@ -64,23 +72,54 @@ public:
     void setBoard(TokenDef tks[GSIZE][GSIZE]);
     void setBoard(TokenDef tks[GSIZE * GSIZE]);
     void setToken(int x, int y, TokenDef td);
-    Token* getToken(int x, int y);
+    const TokenDef &getToken(int x, int y) const;
+    // Display only, the game is not touched
+    void setHighlight(int x, int y, QColor highlight);
     void onGameFinished(Board::Result result);
+    // The AI searches on its own thread, the game is off limits to the GUI meanwhile
+    bool isThinking() const;
+    // A loaded board has no real last move, a five anywhere on it ends the game
+    void onLoaded();
 private:
-    Token* tokens[GSIZE][GSIZE]{{nullptr}};
+    BoardItem *board{nullptr};
+    QThread aiThread;
+    AiWorker *aiWorker;
+    bool thinking = false;
+    enum SearchKind {
+        AI_MOVE,
+        HINT,
+        ANALYSIS,
+    };
+    SearchKind searchKind = AI_MOVE;
+    QPoint liveBest{-1, -1};
+    uint64_t shownCaptures[2]{};    // capture counts of the last change, black then white
+    void startSearch(TokenColor color, SearchKind kind);
+    void setLiveBest(QPoint pt);
+    void showAnalysis(const std::vector<RootLine> &lines);
+    void applyChanges(const MoveChanges &changes);
+    void clearHighlights();
     QPixmap bg;
     QPoint viewPosToBoard(QPoint pt);
     QPoint boardPosToView(QPoint pt);
-    void onTokenClicked(Token *token, QGraphicsSceneMouseEvent *event);
-    bool check();
+    void onTokenClicked(int x, int y, QGraphicsSceneMouseEvent *event);
+    bool check(bool lastMoveKnown = true);
 protected:
     void drawBackground(QPainter *painter, const QRectF &rect) override;
     void mousePressEvent(QGraphicsSceneMouseEvent *event) override;
 public slots:
     void reset();
     void onHelpMove();
+    void onMoveNow();
+    void onAnalyze();
+private slots:
+    void onAiProgress(SearchProgress progress);
+    void onAiFinished();
 signals:
     void resetted();
+    // A move or takeback changed the capture counts, the board follows moves by itself
+    void capturesChanged();
     void finished();
+    void thinkingChanged(bool thinking);
+    void progressed(SearchProgress progress);
 };
 #endif //SCENE_H
@@ -0,0 +1,21 @@
+//
+// Fixed depth search over the built-in positions. The total node count is a signature of the
+// search, any functional change shows up in it; nodes per second tracks the speed.
+//
+
+#ifndef GOMOKU_BENCH_HPP
+#define GOMOKU_BENCH_HPP
+#include <cstdint>
+#include <ostream>
+
+struct BenchResult
+{
+    uint64_t nodes;
+    double seconds;
+    int positions;
+};
+
+// Per position lines go to log when given
+BenchResult runBench(int depth, std::ostream *log = nullptr);
+
+#endif //GOMOKU_BENCH_HPP
@@ -2,6 +2,7 @@
 # define BOARD_HPP
 
 # include <iostream>
+# include <array>
 # include <cstdint>
 # include <string>
 # include <cstring>
@@ -11,6 +12,13 @@
 # include <random>
 # include <unordered_map>
 # include <Patterns.hpp>
+# include <Bitboard.hpp>
+# include <Rules.hpp>
+# include <search.hpp>
+# include <tt.hpp>
+# ifdef GOMOKU_SEARCH_TRACE
+#  include <trace.hpp>
+# endif
 
 # define BOARD_SIZE 19
 # define BS BOARD_SIZE
@@ -19,6 +27,18 @@
 # define BLACK_STONE 1
 # define WHITE_STONE 2
 
+# define LINE_CACHE_LIMIT (1 << 20)
+// Approximate heap cost of one hash_map and one line_cache entry, for SearchLimits::memory
+# define HASH_MAP_ENTRY_BYTES 48
+# define LINE_CACHE_ENTRY_BYTES 64
+// Bump with every change to Eval, saved transposition tables hold its scores
+# define EVAL_VERSION 1
+
+// Every board size and rule variant the engine is instantiated for
+# define GOMOKU_FOR_EACH_VARIANT(M) \
+    M(15, ProCaptures) M(15, Freestyle) M(15, StandardGomoku) M(15, RenjuLike) \
+    M(19, ProCaptures) M(19, Freestyle) M(19, StandardGomoku) M(19, RenjuLike)
+
 // Patterns
 typedef struct SPtr
 {
@@ -76,6 +96,36 @@ constexpr static Ptr bHalf3_4{"010112", 6};
 constexpr static Ptr bHalf3_5{"210110", 6};
 constexpr static Ptr bHalf3_6{"011012", 6};
 constexpr static Ptr bZebra{"1010101", 7};
+
+// Pattern counts of a single line, [0] for black and [1] for white
+struct LineEval
+{
+    int16_t free4[2];
+    int16_t zebra[2];
+    int16_t half4[2];
+    int16_t free3[2];
+    int16_t half3[2];
+};
+// Capture shapes of both colors, [0] black [1] white
+template<int N>
+struct CaptureMap
+{
+    BitRows<N> captures[2];   // empty cells where playing captures a pair
+    BitRows<N> exposed[2];    // empty cells where the new stone would be captured right away
+    BitRows<N> threatened[2]; // stones of a pair the opponent can capture next move
+};
+// Shapes a stone played on an empty cell makes along some line, [0] black [1] white
+template<int N>
+struct ThreatMap
+{
+    BitRows<N> free_two[2];     // 0110
+    BitRows<N> free_three[2];   // 01110 011010 010110
+    BitRows<N> double_three[2]; // free threes along two lines or more
+    BitRows<N> free_four[2];    // 011110
+    BitRows<N> win[2];          // five in a row, exactly five when the rules say so
+    BitRows<N> five[2];         // stones already in a five
+};
+
 // Cache mapping from columns and diagonals
 using Pt = std::pair<int, int>;
 struct XyHash
@@ -85,29 +135,29 @@ struct XyHash
         return std::hash<int>()(x.first) ^ std::hash<int>()(x.second);
     }
 };
-static std::unordered_map<Pt, Pt, XyHash> GenColumnProjectionMapping() {
+static std::unordered_map<Pt, Pt, XyHash> GenColumnProjectionMapping(int size) {
     std::unordered_map<Pt, Pt, XyHash> map;
-    for (int xp = 0; xp < BS; ++xp)
-        for (int yp = 0; yp < BS; ++yp)
+    for (int xp = 0; xp < size; ++xp)
+        for (int yp = 0; yp < size; ++yp)
             map.insert({{yp, xp}, {xp, yp}});
     return map;
 }
-static std::unordered_map<Pt, Pt, XyHash> GenDiagonalProjectionMapping(bool up) {
+static std::unordered_map<Pt, Pt, XyHash> GenDiagonalProjectionMapping(int size, bool up) {
     std::unordered_map<Pt, Pt, XyHash> map;
-    for (int w = 1; w <= BS * 2 - 1; ++w)
+    for (int w = 1; w <= size * 2 - 1; ++w)
     {
-        int fromColumn = std::max(0, w - BS);
-        int endAt = std::min(w, std::min((BS - fromColumn), BS));
+        int fromColumn = std::max(0, w - size);
+        int endAt = std::min(w, std::min((size - fromColumn), size));
 
         for (int i = 0; i < endAt; ++i) {
             if (up)
                 map.insert({
-                                   {(std::min(BS, w) - i - 1), (fromColumn + i)},
+                                   {(std::min(size, w) - i - 1), (fromColumn + i)},
                                    {(w - 1), i}
                            });
             else
                 map.insert({
-                                   {(std::min(BS, w) - i - 1), (BS - 1 - (fromColumn + i))},
+                                   {(std::min(size, w) - i - 1), (size - 1 - (fromColumn + i))},
                                    {(w - 1), i}
                            });
         }
@@ -115,71 +165,246 @@ static std::unordered_map<Pt, Pt, XyHash> GenDiagonalProjectionMapping(bool up)
     return map;
 }
 
-const auto UP_MAP = GenDiagonalProjectionMapping(false);
-const auto DW_MAP = GenDiagonalProjectionMapping(true);
-const auto CL_MAP = GenColumnProjectionMapping();
-
 // END Cache mapping from columns and diagonals
 
-class Board
+// Size independent part of the board
+class BoardBase
 {
 public:
-    uint64_t nodes_count{0};
-    uint64_t pruned_count{0};
-    uint64_t cache_hit_count{0};
+    enum Color
+    {
+        EMPTY = EMPTY_STONE,
+        WHITE = WHITE_STONE,
+        BLACK = BLACK_STONE
+    };
+    enum Result
+    {
+        NO_RESULT = 0,
+        WHITE_WIN,
+        BLACK_WIN,
+        DRAW
+    };
+};
+
+// First stone taken for each capture bit of put_stone_on_board, the second one is twice as far
+constexpr int8_t CAPTURE_DIRS[8][2] = {
+        {0, -1}, {1, -1}, {1, 0}, {1, 1}, {0, 1}, {-1, 1}, {-1, 0}, {-1, -1},
+};
 
+// What make_move changed, unmake_move restores it without replaying anything
+struct UndoRecord
+{
+    int8_t x;
+    int8_t y;
+    bool is_black;
+    uint8_t captures;   // capture bits of put_stone_on_board
+    int8_t moveX;
+    int8_t moveY;
+    int move;
+    BoardBase::Result result;
+    bool lastMoveIsCapture;
+    uint64_t hash;
+    uint64_t black_captures_count;
+    uint64_t white_captures_count;
+    int32_t start_x, start_y;
+    int32_t end_x, end_y;
+};
+
+// Everything that makes up a position, plain data so a board is cloned with one copy of a few KB.
+// The fields the search touches on every move come first.
+template<int N>
+struct BoardState
+{
+    using Row = BitRow<N>;
+    using Line = char[N+1];
+    constexpr static int LINES_COUNT = N + N + (N+N-1) * 2;
+
+    Row black_board[N]{};
+    Row white_board[N]{};
+    uint64_t hash{0};
+    int32_t start_x{0}, start_y{0};
+    int32_t end_x{0}, end_y{0};
     uint64_t black_captures_count{0};
     uint64_t white_captures_count{0};
+    int32_t move_map[N * N]{};
+
+    int8_t moveX = 0;
+    int8_t moveY = 0;
+    int move = BoardBase::EMPTY;
+    BoardBase::Result result = BoardBase::NO_RESULT;
+    bool lastMoveIsCapture = false;
+
+    // The stones of every line as 2 bit cells and as strings for the pattern matchers
+    std::array<uint64_t, LINES_COUNT> line_keys{};
+    std::array<Line, N> rows{};
+    std::array<Line, N> columns{};
+    std::array<Line, N+N-1> down{};
+    std::array<Line, N+N-1> up{};
+};
+
+// Zobrist keys shared by every board of size N, black stones at y * N + x and white ones N * N further.
+// Seeded with N, so hashes are the same in every run.
+template<int N>
+struct ZobristKeys
+{
+    uint64_t keys[N * N * 2];
 
-    int32_t *move_map{new int32_t[BOARD_SIZE * BOARD_SIZE]()};
-    int32_t *black_board{new int32_t[BOARD_SIZE]()};
-    int32_t *white_board{new int32_t[BOARD_SIZE]()};
+    static const ZobristKeys &table() {
+        static const ZobristKeys keys;
+        return keys;
+    }
 
-    Board();
+private:
+    ZobristKeys() {
+        std::mt19937_64 rng(N);
+        for (auto &key : keys)
+            key = rng();
+    }
+};
+
+// N x N board played with Rules, instantiated for every GOMOKU_FOR_EACH_VARIANT in board.cpp
+template<int N, class Rules = ProCaptures>
+class BasicBoard : public BoardBase, private BoardState<N>
+{
+public:
+    using State = BoardState<N>;
+    using Row = BitRow<N>;
+    using Mask = BitRows<N>;
+    constexpr static Row TOP = Mask::TOP;
+    constexpr static int SIZE = N;
+    using State::LINES_COUNT;
+
+
+    SearchLimits limits;
+    SearchStats stats;
+    SearchControl *control{nullptr};    // progress and stop requests from another thread when set
+    TranspositionTable *table{nullptr}; // leaf scores go here instead of hash_map when set, kept across searches
+# ifdef GOMOKU_SEARCH_TRACE
+    TraceWriter *trace{nullptr};    // every node of the search goes here when set
+# endif
+
+    using State::black_captures_count;
+    using State::white_captures_count;
+    using State::move_map;
+    using State::black_board;
+    using State::white_board;
+
+    BasicBoard();
+    // The position alone, for handing it to another board or thread
+    const State &state() const { return *this; }
+    // Takes over the position of state, the caches and search settings stay
+    void set_state(const State &state);
     bool place_stone_on_board(int8_t x, int8_t y, bool is_black, uint8_t *captures=nullptr);
+    // captures puts back the pairs place_stone_on_board reported, in place; the search box is not touched
     bool remove_stone_from_board(int8_t x, int8_t y, bool is_black, uint8_t *captures=nullptr);
+    // Search moves: no legality checks, captures only with captures, undo gets what unmake_move needs
+    void make_move(int8_t x, int8_t y, bool is_black, bool captures, UndoRecord &undo);
+    void unmake_move(const UndoRecord &undo);
+    bool is_legal_move(int8_t x, int8_t y, bool is_black) const;
+    const Mask &forbidden_moves(bool is_black) const;
+    const CaptureMap<N> &capture_map() const;
+    // For the GUI overlays, computed on first use after the position changed
+    const ThreatMap<N> &threat_map() const;
+    int generate_moves(bool is_black, int16_t moves[N * N], int *captures_count) const;
+    // (x, y) holds the is_black stone just played, the other color moves next; scores are the root side's
     int32_t minimax(int8_t depth, int32_t alpha, int32_t beta, int8_t x, int8_t y, bool maximizer, bool is_black);
     int32_t ai_move(bool is_black);
+    // The multi_pv best root moves with their scores and lines, best first, searched in one pass
+    std::vector<RootLine> analyze(bool is_black, int multi_pv);
     void reset();
     void print();
+    bool check_invariants(std::string *error = nullptr) const;
+    uint64_t position_hash() const { return hash; }
+    uint64_t get_hash() const;
 
+    // Eval's scores by table_key, cleared by every search
     std::unordered_map<uint64_t, int32_t> hash_map;
-private:
-    uint64_t *zobrist_table{new uint64_t[BOARD_SIZE * BOARD_SIZE * 2]()};
-    uint64_t hash{0};
-
-    int32_t start_x{0}, start_y{0};
-    int32_t end_x{0}, end_y{0};
-    int32_t most_left{0}, most_right{0};
+    uint64_t hash_map_limit{std::numeric_limits<uint64_t>::max()};
 
-    void fill_zobrist_table();
-    uint64_t get_hash();
-
-    bool five_in_a_row(int32_t x, int32_t y, bool is_black);
-    bool open_four(int32_t x, int32_t y, bool is_black);
-    bool simple_four(int32_t x, int32_t y, bool is_black);
-    bool open_three(int32_t x, int32_t y, bool is_black);
-    bool simple_three(int32_t x, int32_t y, bool is_black);
-    bool open_two(int32_t x, int32_t y, bool is_black);
-    bool simple_two(int32_t x, int32_t y, bool is_black);
+    // Line contents -> pattern counts, shared by every Eval of the search
+    mutable uint64_t line_cache_hit_count{0};
+    mutable uint64_t line_cache_miss_count{0};
+    mutable std::unordered_map<uint64_t, LineEval> line_cache;
+    uint64_t line_cache_limit{LINE_CACHE_LIMIT};
+private:
+    const uint64_t *zobrist_table{ZobristKeys<N>::table().keys};
+    using State::hash;
+    using State::start_x;
+    using State::start_y;
+    using State::end_x;
+    using State::end_y;
+
+    int32_t search_root(bool is_black, int multi_pv, std::vector<RootLine> *lines);
+
+    // Triangular principal variation, row ply holds the best line found below that ply
+    int search_depth{0};
+    bool root_is_black{true};
+    int16_t pv_table[MAX_PLY][MAX_PLY];
+    int pv_length[MAX_PLY];
+
+    void update_pv(int ply, int16_t move) {
+        pv_table[ply][ply] = move;
+        for (int i = ply + 1; i < pv_length[ply + 1]; ++i)
+            pv_table[ply][i] = pv_table[ply + 1][i];
+        pv_length[ply] = pv_length[ply + 1];
+    }
+    bool record_cutoff(int ply, int move_index) {
+        ++stats.cutoffs;
+        ++stats.plies[ply].cutoffs;
+        if (move_index == 0)
+        {
+            ++stats.first_move_cutoffs;
+            ++stats.plies[ply].first_move_cutoffs;
+        }
+        return true;
+    }
+# ifdef GOMOKU_SEARCH_TRACE
+    // Nodes on the current path, written out once they have a score
+    uint32_t trace_next_id{0};
+    TraceRecord trace_open[MAX_PLY];
+
+    void trace_enter(int ply, int16_t move, int32_t alpha, int32_t beta) {
+        TraceRecord &r = trace_open[ply];
+        r.id = ply ? ++trace_next_id : (trace_next_id = 0);
+        r.parent = ply ? trace_open[ply - 1].id : std::numeric_limits<uint32_t>::max();
+        r.alpha = alpha;
+        r.beta = beta;
+        r.move = move;
+        r.ply = static_cast<uint8_t>(ply);
+    }
+    void trace_exit(int ply, int32_t score, uint8_t flags) {
+        if (!trace)
+            return;
+        TraceRecord &r = trace_open[ply];
+        r.score = score;
+        r.flags = flags;
+        trace->write(r);
+    }
+# endif
+
+    // Computed once per position on first use, [0] black [1] white
+    mutable CaptureMap<N> captures_map;
+    mutable Mask forbidden[2];
+    mutable bool maps_dirty{true};
+    // Apart from the maps above, the search never needs it
+    mutable ThreatMap<N> threats;
+    mutable bool threats_dirty{true};
+
+    bool is_double_three(int8_t x, int8_t y, bool is_black) const;
+    bool is_into_capture(int8_t x, int8_t y, bool is_black) const;
+    void put_stone_on_board(int8_t x, int8_t y, bool is_black, uint8_t *captures=nullptr);
+    void add_to_neighbours(int8_t x, int8_t y, int32_t delta);
+    void restore_captured(int8_t x, int8_t y, bool is_black, uint8_t captures);
+    int run_length(int8_t x, int8_t y, int dx, int dy, bool is_black) const;
+    void fill_maps() const;
+    void fill_capture_map(bool is_black) const;
+    void fill_forbidden(bool is_black) const;
+    void fill_threat_map(bool is_black) const;
 
 // Board v2
 public:
-    enum Color
-    {
-        EMPTY = EMPTY_STONE,
-        WHITE = WHITE_STONE,
-        BLACK = BLACK_STONE
-    };
-    enum Result
-    {
-        NO_RESULT = 0,
-        WHITE_WIN,
-        BLACK_WIN,
-        DRAW
-    };
-    bool lastMoveIsCapture = false;
-    using Line = char[BS+1];
+    using State::lastMoveIsCapture;
+    using Line = typename State::Line;
     std::chrono::time_point<std::chrono::high_resolution_clock> startTime;
 
     Color getToken(int x, int y) const {
@@ -204,17 +429,55 @@ private:
         columns[cxy.first][cxy.second] = '0' + color;
         up[uxy.first][uxy.second] = '0' + color;
         down[dxy.first][dxy.second] = '0' + color;
+        setLineCell(ROWS_AT + x, y, color);
+        setLineCell(COLUMNS_AT + cxy.first, cxy.second, color);
+        setLineCell(UP_AT + uxy.first, uxy.second, color);
+        setLineCell(DOWN_AT + dxy.first, dxy.second, color);
     }
 
+    // Lines are numbered rows, columns, up, down. Each one keeps its cells packed
+    // by 2 bits so Eval can find the lines changed since it last looked at them.
+    enum LineOffset {
+        ROWS_AT = 0,
+        COLUMNS_AT = N,
+        UP_AT = N + N,
+        DOWN_AT = N + N + N + N - 1,
+    };
+    using State::line_keys;
+    mutable std::array<uint64_t, LINES_COUNT> scored_keys{};
+    mutable std::array<LineEval, LINES_COUNT> scored_lines{};
+
+    void setLineCell(int line, int at, const Color color) {
+        line_keys[line] = (line_keys[line] & ~(3ULL << (at * 2))) | (uint64_t(color) << (at * 2));
+    }
+    // Diagonals of the same index share the match bounds of PtrGlobalMatch, so the
+    // index goes into the key next to the cells
+    uint64_t lineKey(int line) const {
+        if (line < UP_AT)
+            return line_keys[line];
+        return line_keys[line] | uint64_t((line - UP_AT) % (N+N-1) + 1) << 40;
+    }
+    const char *lineAt(int line) const {
+        if (line < COLUMNS_AT)
+            return rows[line];
+        if (line < UP_AT)
+            return columns[line - COLUMNS_AT];
+        if (line < DOWN_AT)
+            return up[line - UP_AT];
+        return down[line - DOWN_AT];
+    }
+    static LineEval ScoreLine(const char *line, bool projected, int index);
+    LineEval EvalLines() const;
+
 public:
-    int8_t moveX = 0;
-    int8_t moveY = 0;
-    int move = EMPTY;
-    Result result = NO_RESULT;
-    std::array<Line, BS> rows{};
-    std::array<Line, BS> columns{};
-    std::array<Line, BS+BS-1> down{};
-    std::array<Line, BS+BS-1> up{};
+    using State::moveX;
+    using State::moveY;
+    using State::move;
+    using State::result;
+    using State::rows;
+    using State::columns;
+    using State::down;
+    using State::up;
 
 
     int PtrLocalMatchAll(const Ptr &ptr, int x, int y) const {
@@ -224,19 +487,16 @@ public:
                + PtrLocalMatch(down, ptr, DW_MAP.at({x, y}));
     }
 
-    int PtrLocal5Match(Color color, int x, int y) const {
-        return PtrLocalMatch(rows, color == BLACK ? bFive : wFive, x, y)
-        + PtrLocalMatch(columns, color == BLACK ? bFive : wFive, CL_MAP.at({x, y}))
-        + PtrLocalMatch(up, color == BLACK ? bFive : wFive, UP_MAP.at({x, y}))
-        + PtrLocalMatch(down, color == BLACK ? bFive : wFive, DW_MAP.at({x, y}));
-    }
-
     template<typename B>
-    int PtrLocalMatch(const B &board, const Ptr &ptr, const Pt &pt) const {
-        return PtrLocalMatch(board, ptr, pt.first, pt.second);
+    int PtrLocalMatch(const B &board, const Ptr &ptr, const Pt &pt, bool exact = false) const {
+        return PtrLocalMatch(board, ptr, pt.first, pt.second, exact);
+    }
+    // Overline check for exact fives, the pattern is a run of one stone
+    static bool PtrOverline(const char *line, const char *match, const Ptr &ptr) {
+        return (match > line && match[-1] == ptr.str[0]) || match[ptr.len] == ptr.str[0];
     }
     template<typename B>
-    int PtrLocalMatch(const B &board, const Ptr &ptr, int x, int y) const {
+    int PtrLocalMatch(const B &board, const Ptr &ptr, int x, int y, bool exact = false) const {
         int count{0};
         // NOTE: x, y access here
         const char *line = board[x];
@@ -249,6 +509,10 @@ public:
         do {
             match = strstr(match, ptr.str);
             if (match && match <= line + y) {
+                if (exact && PtrOverline(board[x], match, ptr)) {
+                    match++;
+                    continue;
+                }
                 count++;
                 match += ptr.len;
             } else
@@ -261,65 +525,68 @@ public:
         END,
         BEGIN,
     };
-    template<typename B> // for tow different arrays std::array<Line, BS> and std::array<Line, BS+BS-1>
+    static int PtrLineMatch(const char *line, const Ptr &ptr, const bool projected = false, const MatchOnly only = NONE, const bool exact = false) {
+        int count{0};
+        const char *match = line;
+        if (!projected && only == END) // "............PTR\0" skip ti possible end match at
+            match += N-ptr.len;
+        do {
+            match = strstr(match, ptr.str);
+            if (exact && match != nullptr && PtrOverline(line, match, ptr)) {
+                match++;
+                continue;
+            }
+            if (match != nullptr && (only != BEGIN || match == line)) {
+                count++;
+                // start of match is returned, advance forward!
+                match += ptr.len;
+            }
+            // "PTR............\0" Do not continue if BEGIN
+        } while (only == NONE && match != nullptr && *match);
+        return count;
+    }
+    // Up/Down Diagonal, Start from suitable for ptr length length
+    // 0       1
+    // 1       11
+    // 2       111   <---- start
+    // 3       1111   if ptr len is 3 start from index 2 and end with 4
+    // 4       111   <----  end
+    // 5       11
+    // 6       1
+    static bool PtrProjectedInRange(const Ptr &ptr, int index) {
+        return index >= ptr.len-1 && index < (N+N-1) - ptr.len-1;
+    }
+    template<typename B> // for tow different arrays std::array<Line, N> and std::array<Line, N+N-1>
     int PtrGlobalMatch(const B &board, const Ptr &ptr, const bool projected = false, const MatchOnly only = NONE) const {
         int count{0};
         if (!projected) // Row/Column Match, Just strstr to the end baby! Except some only given..
         {
             for (const auto& line : board)
-            {
-                const char *match = line;
-                if (only == END) // "............PTR\0" skip ti possible end match at
-                    match += BS-ptr.len;
-                do {
-                    match = strstr(match, ptr.str);
-                    if (match != nullptr && (only != BEGIN || match == line)) {
-                        count++;
-                        match += ptr.len;
-                    }
-                    // "PTR............\0" Do not continue if BEGIN
-                } while (only == NONE && match != nullptr && *match);
-            }
-        } else { // Up/Down Diagonal, Start from suitable for ptr length length
-            // 0       1
-            // 1       11
-            // 2       111   <---- start
-            // 3       1111   if ptr len is 3 start from index 2 and end with 4
-            // 4       111   <----  end
-            // 5       11
-            // 6       1
-            const int end = (BS+BS-1) - ptr.len-1;
-            for (int i = ptr.len-1; i < end; ++i) {
-                const char *match = board[i];
-                do {
-                    match = strstr(match, ptr.str);
-                    if (match != nullptr && (only != BEGIN || match == board[i])) {
-                        count++;
-                        // start of match is returned, advance forward!
-                        match += ptr.len;
-                    }
-                } while (only == NONE && match != nullptr && *match);
-            }
+                count += PtrLineMatch(line, ptr, false, only);
+        } else {
+            for (int i = ptr.len-1; PtrProjectedInRange(ptr, i); ++i)
+                count += PtrLineMatch(board[i], ptr, true, only);
         }
 
         return (count);
     }
 
-    friend std::ostream& operator<<(std::ostream& os, const Board& board) {
-        os << board.move << std::endl;
+    // Last move x, y and color, then the rows from N-1 down, O black X white _ empty
+    friend std::ostream& operator<<(std::ostream& os, const BasicBoard& board) {
+        os << int(board.moveX) << " " << int(board.moveY) << " " << board.move << std::endl;
 
-        for (int row = BS - 1; row >= 0; --row)
+        for (int row = N - 1; row >= 0; --row)
         {
-            for (int col = 0; col < BS; ++col)
+            for (int col = 0; col < N; ++col)
             {
                 switch (board.getToken(row, col)) {
-                    case Board::EMPTY:
+                    case BoardBase::EMPTY:
                         os << "_";
                         break;
-                    case Board::WHITE:
+                    case BoardBase::WHITE:
                         os << "X";
                         break;
-                    case Board::BLACK:
+                    case BoardBase::BLACK:
                         os << "O";
                         break;
                 }
@@ -329,26 +596,26 @@ public:
         return os;
     }
 
-    friend std::istream& operator>>(std::istream& is, Board& board) {
-        board = Board();
-        int skip;
-        is >> skip >> skip >> board.move;
+    // Stones are put without captures or legality checks, capture counts start from 0
+    friend std::istream& operator>>(std::istream& is, BasicBoard& board) {
+        board.reset();
+        int moveX, moveY;
+        is >> moveX >> moveY >> board.move;
+        board.moveX = moveX;
+        board.moveY = moveY;
 
-        for (int i = BS - 1; i > -1; i--)
+        for (int i = N - 1; i > -1; i--)
         {
-            for (int j = 0; j < BS; j++) {
+            for (int j = 0; j < N; j++) {
                 char token;
                 is >> token;
 
                 switch (token) {
-                    case '_':
-                        board.setToken(i, j, Color::EMPTY);
-                        break;
                     case 'X':
-                        board.setToken(i, j, Color::WHITE);
+                        board.put_stone_on_board(i, j, false);
                         break;
                     case 'O':
-                        board.setToken(i, j, Color::BLACK);
+                        board.put_stone_on_board(i, j, true);
                         break;
                     default:
                         break;
@@ -371,7 +638,38 @@ public:
     int PtrMatchHalf4(Color color) const;
     int PtrMatchHalf3(Color color) const;
     bool PtrMatch(const Ptr &ptr) const;
+    // The is_black stone at x, y is in a five, exactly five when the rules say so; reads the 4 lines through it only
+    bool is_five(int8_t x, int8_t y, bool is_black) const;
+    // BLACK_WIN or WHITE_WIN when the stone at x, y is in a five, NO_RESULT otherwise
+    Result five_at(int8_t x, int8_t y) const;
+    // BLACK_WIN or WHITE_WIN for a five anywhere on the board, found by shifting the stone bitboards
+    Result any_five() const;
+    // Five through the last move or five captured pairs. Boards read or set up stone by stone have no
+    // real last move, pass false for those and a five anywhere counts.
+    Result winner(bool last_move_known = true) const;
     int Eval() const;
+
+    static const std::unordered_map<Pt, Pt, XyHash> CL_MAP;
+    static const std::unordered_map<Pt, Pt, XyHash> UP_MAP;
+    static const std::unordered_map<Pt, Pt, XyHash> DW_MAP;
 };
 
+template<int N, class Rules>
+const std::unordered_map<Pt, Pt, XyHash> BasicBoard<N, Rules>::UP_MAP = GenDiagonalProjectionMapping(N, false);
+template<int N, class Rules>
+const std::unordered_map<Pt, Pt, XyHash> BasicBoard<N, Rules>::DW_MAP = GenDiagonalProjectionMapping(N, true);
+template<int N, class Rules>
+const std::unordered_map<Pt, Pt, XyHash> BasicBoard<N, Rules>::CL_MAP = GenColumnProjectionMapping(N);
+template<int N, class Rules>
+constexpr typename BasicBoard<N, Rules>::Row BasicBoard<N, Rules>::TOP;
+template<int N>
+constexpr int BoardState<N>::LINES_COUNT;
+
+# define GOMOKU_EXTERN_BOARD(N, R) extern template class BasicBoard<N, R>;
+GOMOKU_FOR_EACH_VARIANT(GOMOKU_EXTERN_BOARD)
+# undef GOMOKU_EXTERN_BOARD
+
+using Board = BasicBoard<BOARD_SIZE>;
+using Board15 = BasicBoard<15>;
+
 #endif
@@ -0,0 +1,60 @@
+//
+// Qt free entry point to the engine, every board size and rule variant behind one interface.
+// Used by the GUI-less tools, the Qt app keeps working with Game directly.
+//
+
+#ifndef GOMOKU_ENGINE_HPP
+#define GOMOKU_ENGINE_HPP
+#include <memory>
+#include <string>
+#include "game.hpp"
+
+class TraceWriter;
+class TranspositionTable;
+
+class Engine
+{
+public:
+    virtual ~Engine() = default;
+
+    // nullptr when size and rules are not one of GOMOKU_FOR_EACH_VARIANT, rules is a Rules::name
+    static std::unique_ptr<Engine> create(int size = BOARD_SIZE, const std::string &rules = ProCaptures::name);
+
+    virtual int size() const = 0;
+    virtual const char *rules() const = 0;
+
+    virtual void reset() = 0;
+    virtual int8_t getToken(int8_t x, int8_t y) const = 0;
+    // Plays v at (x, y) with captures, false if the move is illegal; EMPTY_STONE removes the stone alone
+    virtual bool setToken(int8_t x, int8_t y, int8_t v) = 0;
+    // Plays v at (x, y) with captures but without our legality checks, for the moves of a manager or
+    // opponent that are authoritative; false only when the cell is taken
+    virtual bool forceToken(int8_t x, int8_t y, int8_t v) = 0;
+    // Undoes the last move when it was played at (x, y), captured stones and counts included
+    virtual bool takeBack(int8_t x, int8_t y) = 0;
+    virtual uint64_t capturedPairs(int8_t v) const = 0;
+    // Five in a row through the last move or five captured pairs, NO_RESULT while the game goes on.
+    // After readBoard or a replay of a final position pass false, a five anywhere counts then.
+    virtual BoardBase::Result winner(bool lastMoveKnown = true) const = 0;
+    // The v stone at (x, y) is in a winning five, only the 4 lines through it are read
+    virtual bool isFive(int8_t x, int8_t y, int8_t v) const = 0;
+    // Color to play, the opposite of the last move's
+    virtual int8_t toMove() const = 0;
+
+    // Text format of the board's operator<<, false when the stream fails
+    virtual bool readBoard(std::istream &in) = 0;
+    virtual void writeBoard(std::ostream &out) const = 0;
+
+    virtual Move predictMove(int8_t v, const SearchLimits &limits = SearchLimits()) = 0;
+    // The count best moves for v from one search, best first
+    virtual std::vector<RootLine> analyze(int8_t v, int count, const SearchLimits &limits = SearchLimits()) = 0;
+    // Counters of the last predictMove
+    virtual const SearchStats &stats() const = 0;
+    // Records the searched nodes to an open writer, nullptr stops; false when built without GOMOKU_SEARCH_TRACE
+    virtual bool traceTo(TraceWriter *writer) = 0;
+    // Searches keep their leaf scores in table, which other engines may share, nullptr goes back to a table
+    // per search; false when table is for another board size or rules
+    virtual bool useTable(TranspositionTable *table) = 0;
+};
+
+#endif //GOMOKU_ENGINE_HPP
@@ -2,6 +2,8 @@
 # define GAME_HPP
 
 
+# include <functional>
+# include <vector>
 # include "board.hpp"
 
 class Move {
@@ -12,18 +14,74 @@ public:
     int8_t y;
     int8_t v;
     double tookSecond;
+    SearchStats stats;
 };
 
-class Game
+// One cell a setToken or takeBack changed, a takeBack puts captured stones back as PLACED
+struct CellChange
+{
+    enum Kind : uint8_t
+    {
+        PLACED,
+        CAPTURED,
+        REMOVED
+    };
+    Kind kind;
+    int8_t x;
+    int8_t y;
+    int8_t v;       // the stone placed, or the one that was there
+};
+
+// Everything one setToken, takeBack or reset changed, what a view or a recorder follows the game with
+struct MoveChanges
+{
+    bool cleared{false};            // reset, the board is empty and nothing else is set
+    int16_t move{-1};               // x | y << 8 of the setToken, -1 after a reset
+    int16_t previous{-1};           // the move before it, where a last move marker was
+    std::vector<CellChange> cells;  // the move first, then the captured stones
+    uint64_t black_captures{0};     // counts after the change
+    uint64_t white_captures{0};
+};
+
+// Game on an N x N board played with Rules, instantiated for every GOMOKU_FOR_EACH_VARIANT in game.cpp
+template<int N, class Rules = ProCaptures>
+class BasicGame
 {
 public:
-    int8_t getToken(int8_t x, int8_t y);
+    int8_t getToken(int8_t x, int8_t y) const;
+    // Plays v at (x, y) with captures, false if the move is illegal. EMPTY_STONE removes the stone
+    // alone, an edit that also forgets the moves before it.
     bool setToken(int8_t x, int8_t y, int8_t v);
+    // Plays v at (x, y) with captures but none of the legality checks of Rules, for moves another
+    // program already judged; false only when the cell is taken
+    bool forceToken(int8_t x, int8_t y, int8_t v);
+    // Undoes the last move when it was played at (x, y): the captured stones, the counts and the last move come back
+    bool takeBack(int8_t x, int8_t y);
     Move predictMove(int8_t v);
+    Move predictMove(int8_t v, const SearchLimits &limits);
+    // The count best moves for v with scores and lines, best first
+    std::vector<RootLine> analyze(int8_t v, int count);
+    std::vector<RootLine> analyze(int8_t v, int count, const SearchLimits &limits);
+    const SearchStats &stats() const;
     void reset();
-    Board::Result result();
-    Board board{Board()};
+    BoardBase::Result result();
+    // Called on the caller's thread after every setToken that changed the board and every reset
+    void setListener(std::function<void(const MoveChanges &)> listener);
+    BasicBoard<N, Rules> board{BasicBoard<N, Rules>()};
 private:
+    std::function<void(const MoveChanges &)> listener;
+    MoveChanges changes;
+    int16_t last_move{-1};
+    std::vector<UndoRecord> history;    // one record per move since the last reset or edit
+
+    bool play(int8_t x, int8_t y, int8_t v, bool checked);
 };
 
+# define GOMOKU_EXTERN_GAME(N, R) extern template class BasicGame<N, R>;
+GOMOKU_FOR_EACH_VARIANT(GOMOKU_EXTERN_GAME)
+# undef GOMOKU_EXTERN_GAME
+
+using Game = BasicGame<BOARD_SIZE>;
+using Game15 = BasicGame<15>;
+
 #endif
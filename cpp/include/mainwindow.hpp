@@ -10,7 +10,6 @@
 #include <QUrl>
 #include <QPixmap>
 
-#include "Token.hpp"
 #include "Scene.hpp"
 #include "game.hpp"
 
@@ -35,6 +34,7 @@ public:
 private:
     Ui::MainWindow *ui;
     bool isDevMode();
+    void showCells(const BitRows<GSIZE> &cells, QColor color, bool stones = false);
 public slots:
     void onActionExit();
     void onActionRestart();
@@ -50,7 +50,10 @@ public slots:
     void onActionShowCapture();
     void onActionShowUnderCapture();
     void onActionShowTowFreeThree();
+    void onActionShowForbidden();
     void onActionHelpWithMove();
+    void onThinkingChanged(bool thinking);
+    void onSearchProgress(SearchProgress progress);
     void reset();
     void quit();
 };
@@ -0,0 +1,103 @@
+//
+// Position database, fixed size entries sorted by key in one file that lookups map in place.
+// A file is a PositionDbHeader followed by count PackedPositions in key order, duplicates merged.
+// Keys are Zobrist hashes over a fixed table, so they stay the same across runs and builds.
+//
+
+#ifndef GOMOKU_POSDB_HPP
+#define GOMOKU_POSDB_HPP
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+class Engine;
+
+#define POSDB_VERSION 1
+#define POSDB_MAX_SIZE 19
+#define POSDB_CELL_BYTES ((POSDB_MAX_SIZE * POSDB_MAX_SIZE * 2 + 7) / 8)
+
+#pragma pack(push, 1)
+struct PositionDbHeader
+{
+    char magic[4];          // "GPDB"
+    uint16_t version;
+    uint8_t board_size;
+    uint8_t reserved;
+    uint64_t count;
+};
+
+struct PackedPosition
+{
+    uint64_t key;
+    uint8_t cells[POSDB_CELL_BYTES];    // 2 bits per cell y * size + x, EMPTY_STONE, BLACK_STONE or WHITE_STONE
+    uint8_t to_move;
+    uint8_t black_captures;             // pairs taken by black
+    uint8_t white_captures;
+    uint32_t count;                     // times added, summed when duplicates merge
+    uint8_t reserved[6];
+
+    int cell(int x, int y, int size) const {
+        const int i = y * size + x;
+        return cells[i >> 2] >> ((i & 3) * 2) & 3;
+    }
+    // Same position, the key and count aside
+    bool same(const PackedPosition &other) const;
+};
+#pragma pack(pop)
+
+// Packs the engine's position with its key, count 1
+PackedPosition pack_position(const Engine &engine);
+// cells[y * size + x], the key is computed here
+PackedPosition pack_position(int size, const int8_t *cells, int8_t to_move, int black_captures, int white_captures);
+
+// Collects positions in memory, then sorts, merges and writes them in one go
+class PositionDbBuilder
+{
+public:
+    explicit PositionDbBuilder(int size) : size(size) {}
+
+    int board_size() const { return size; }
+    void add(const PackedPosition &position) { positions.push_back(position); }
+    size_t added() const { return positions.size(); }
+    // Writes to a temporary file renamed over path, so readers never see half a database
+    bool write(const std::string &path, uint64_t *unique = nullptr);
+
+private:
+    int size;
+    std::vector<PackedPosition> positions;
+};
+
+// A database mapped read only, lookups are binary searches over the file
+class PositionDb
+{
+public:
+    PositionDb() = default;
+    ~PositionDb();
+    PositionDb(const PositionDb &) = delete;
+    PositionDb &operator=(const PositionDb &) = delete;
+
+    bool open(const std::string &path);
+    void close();
+    const std::string &error() const { return last_error; }
+
+    int board_size() const { return size; }
+    uint64_t count() const { return entries_count; }
+    const PackedPosition *begin() const { return entries; }
+    const PackedPosition *end() const { return entries + entries_count; }
+
+    // Every entry with the key, more than one only for hash collisions
+    std::pair<const PackedPosition *, const PackedPosition *> equal_range(uint64_t key) const;
+    // The entry of exactly this position, nullptr if it was never added
+    const PackedPosition *find(const PackedPosition &position) const;
+
+private:
+    const uint8_t *data{nullptr};
+    size_t length{0};
+    const PackedPosition *entries{nullptr};
+    uint64_t entries_count{0};
+    int size{0};
+    std::string last_error;
+};
+
+#endif //GOMOKU_POSDB_HPP
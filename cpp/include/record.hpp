@@ -0,0 +1,137 @@
+//
+// Binary game records, any number of games per file, written by RecordWriter and read in place by RecordReader.
+// A file is a RecordFileHeader followed by games back to back, every game 8 byte aligned:
+//   RecordGameHeader
+//   uint64_t nodes[moves]      with RECORD_NODES
+//   uint32_t micros[moves]     with RECORD_TIME, microseconds spent on the move
+//   int32_t scores[moves]      with RECORD_SCORE
+//   the moves as 9 bit cells y * size + x, first move in the lowest bits, black moves first
+//   zero padding to a multiple of 8 bytes
+// Everything is little endian. Captures are not stored, replaying the moves with the rules restores them.
+//
+
+#ifndef GOMOKU_RECORD_HPP
+#define GOMOKU_RECORD_HPP
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "board.hpp"
+
+#define RECORD_VERSION 1
+#define RECORD_MAX_SIZE 22      // 9 bit cells
+
+// Optional per move columns, RecordGameHeader::flags
+#define RECORD_NODES 0x1
+#define RECORD_TIME 0x2
+#define RECORD_SCORE 0x4
+
+#pragma pack(push, 1)
+struct RecordFileHeader
+{
+    char magic[4];          // "GREC"
+    uint16_t version;
+    uint16_t reserved;
+};
+
+struct RecordGameHeader
+{
+    uint32_t bytes;         // the whole game with this header and the padding
+    uint16_t moves;
+    uint8_t board_size;
+    uint8_t rules;          // index in the variants table of record.cpp, fixed for the format
+    uint8_t flags;
+    uint8_t result;         // BoardBase::Result
+    uint8_t reserved[6];
+};
+#pragma pack(pop)
+
+// A game in memory, what RecordWriter takes and RecordView::decode gives
+struct GameRecord
+{
+    int size{BOARD_SIZE};
+    std::string rules{ProCaptures::name};
+    BoardBase::Result result{BoardBase::NO_RESULT};
+    std::vector<int16_t> moves;     // x | y << 8, black first
+    std::vector<double> seconds;    // empty, or one per move like scores and nodes
+    std::vector<int32_t> scores;
+    std::vector<uint64_t> nodes;
+};
+
+// A game inside a RecordReader's mapping, valid while the reader stays open
+class RecordView
+{
+public:
+    int size() const { return header().board_size; }
+    const char *rules() const;
+    BoardBase::Result result() const { return static_cast<BoardBase::Result>(header().result); }
+    int moves() const { return header().moves; }
+    // x | y << 8
+    int16_t move(int i) const {
+        const unsigned bit = i * 9;
+        const unsigned cell = (packed()[bit >> 3] | packed()[(bit >> 3) + 1] << 8) >> (bit & 7) & 0x1FF;
+        return static_cast<int16_t>(cell % size() | cell / size() << 8);
+    }
+    // nullptr when the game has no such column
+    const uint64_t *nodes() const;
+    const uint32_t *micros() const;
+    const int32_t *scores() const;
+
+    GameRecord decode() const;
+
+private:
+    friend class RecordReader;
+    const uint8_t *data{nullptr};
+
+    const RecordGameHeader &header() const { return *reinterpret_cast<const RecordGameHeader *>(data); }
+    const uint8_t *packed() const;
+};
+
+// Maps a record file and walks its games without copying them
+class RecordReader
+{
+public:
+    RecordReader() = default;
+    ~RecordReader();
+    RecordReader(const RecordReader &) = delete;
+    RecordReader &operator=(const RecordReader &) = delete;
+
+    bool open(const std::string &path);
+    void close();
+    // false after the last game or at a damaged one, error() is empty in the first case
+    bool next(RecordView &game);
+    void rewind();
+    const std::string &error() const { return last_error; }
+
+private:
+    const uint8_t *data{nullptr};
+    size_t length{0};
+    size_t offset{0};
+    std::string last_error;
+};
+
+// Appends games to a record file, creating it when missing
+class RecordWriter
+{
+public:
+    RecordWriter() = default;
+    ~RecordWriter();
+    RecordWriter(const RecordWriter &) = delete;
+    RecordWriter &operator=(const RecordWriter &) = delete;
+
+    // false when the file can not be written or is not a complete record file
+    bool open(const std::string &path);
+    void close();
+    // false when the game does not fit the format or the write failed, the file is unchanged in the first case
+    bool write(const GameRecord &game);
+    bool flush();
+
+private:
+    std::FILE *file{nullptr};
+    std::vector<uint8_t> buffer;
+};
+
+// Bytes game takes in a record file, 0 when it can not be stored
+size_t record_game_bytes(const GameRecord &game);
+
+#endif //GOMOKU_RECORD_HPP
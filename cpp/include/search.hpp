@@ -0,0 +1,97 @@
+//
+// Search limits and statistics, shared by the board, the engine API and the tools.
+//
+
+#ifndef GOMOKU_SEARCH_HPP
+#define GOMOKU_SEARCH_HPP
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Deepest ply the search keeps statistics and a principal variation for
+#define MAX_PLY 64
+// Score of a win for the root side, a win ply plies from the root scores WIN_SCORE - ply so the
+// quickest win and the slowest loss rank first
+#define WIN_SCORE 1000000
+
+// How far ai_move may go, the defaults are what the game has always played with
+struct SearchLimits
+{
+    int depth{3};           // plies searched below every root move
+    double seconds{0.49};   // nodes reached after this are evaluated as leaves
+    uint64_t memory{0};     // bytes for the transposition table and the line cache, 0 for no limit
+};
+
+// Counters of one ply from the root, the root moves are ply 1
+struct PlyStats
+{
+    uint64_t nodes{0};
+    uint64_t cutoffs{0};
+    uint64_t first_move_cutoffs{0};   // cutoffs by the first move searched
+};
+
+// One pass of the search over all root moves
+struct IterationStats
+{
+    int depth{0};
+    uint64_t nodes{0};
+    double seconds{0};
+};
+
+// What the last search did, filled by ai_move
+struct SearchStats
+{
+    uint64_t nodes{0};
+    uint64_t cutoffs{0};
+    uint64_t first_move_cutoffs{0};
+    uint64_t eval_calls{0};
+    uint64_t tt_probes{0};
+    uint64_t tt_hits{0};
+    uint64_t tt_stores{0};
+    uint64_t tt_size{0};
+    uint64_t line_cache_hits{0};
+    uint64_t line_cache_misses{0};
+    int32_t score{0};
+    double seconds{0};
+    std::vector<PlyStats> plies;            // [0] is the root position
+    std::vector<IterationStats> iterations;
+    std::vector<int16_t> pv;                // x | y << 8 like ai_move, root move first
+
+    // Nodes of the deepest ply to the power of one over its depth
+    double effective_branching_factor() const;
+    double first_move_cutoff_rate() const;
+    std::string to_json() const;
+};
+
+// A root move of an analysis, see BasicBoard::analyze
+struct RootLine
+{
+    int16_t move{0};            // x | y << 8
+    int32_t score{0};
+    std::vector<int16_t> pv;    // starts with move
+};
+
+// Where a running search is, reported after every root move
+struct SearchProgress
+{
+    int depth{0};
+    int root_moves{0};
+    int root_moves_done{0};
+    uint64_t nodes{0};
+    double seconds{0};
+    int32_t score{0};
+    int16_t best_move{0};   // x | y << 8, valid once root_moves_done > 0
+};
+
+// Lets another thread follow and end a search, set on the board before ai_move and kept alive until it returns
+struct SearchControl
+{
+    // Ends the search at the next node, ai_move returns the best of the root moves searched so far
+    std::atomic<bool> stop{false};
+    // Called on the searching thread
+    std::function<void(const SearchProgress &)> progress;
+};
+
+#endif //GOMOKU_SEARCH_HPP
@@ -0,0 +1,96 @@
+//
+// Binary trace of the search tree, one fixed size record per node.
+// Recording is compiled in only with GOMOKU_SEARCH_TRACE (cmake -DGOMOKU_SEARCH_TRACE=ON),
+// without it the search has no trace code at all. tools/trace_reader.cpp reads the files.
+//
+
+#ifndef GOMOKU_TRACE_HPP
+#define GOMOKU_TRACE_HPP
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define TRACE_VERSION 1
+
+// Why a node returned, the low nibble of TraceRecord::flags
+enum TraceReason : uint8_t
+{
+    TRACE_DEPTH = 0,        // leaf at the depth limit
+    TRACE_TIME,             // leaf past the time limit
+    TRACE_FIVE,             // leaf after a five
+    TRACE_CAPTURE_WIN,      // leaf after the winning capture
+    TRACE_CUTOFF,           // alpha-beta cutoff
+    TRACE_ALL_MOVES,        // every move searched
+    TRACE_ROOT,             // the root, last record of a search
+};
+#define TRACE_REASON_MASK 0x0F
+#define TRACE_TT_HIT 0x10       // leaf score came from the transposition table
+#define TRACE_MAXIMIZER 0x20
+
+#pragma pack(push, 1)
+struct TraceHeader
+{
+    char magic[4];          // "GTRC"
+    uint16_t version;
+    uint16_t record_size;
+    uint16_t board_size;
+    uint16_t reserved;
+};
+
+// Written when the node returns, so children come before their parent. Ids restart with
+// every search, the root is 0 and its record closes the search.
+struct TraceRecord
+{
+    uint32_t id;
+    uint32_t parent;
+    int32_t alpha;          // window on entry
+    int32_t beta;
+    int32_t score;
+    int16_t move;           // x | y << 8 of the move leading here, the best move for the root
+    uint8_t ply;
+    uint8_t flags;
+};
+#pragma pack(pop)
+
+// Appends records to a file, a background thread writes full buffers while the search fills the other
+class TraceWriter
+{
+public:
+    static constexpr size_t BUFFER_RECORDS = 1 << 16;
+
+    TraceWriter() = default;
+    ~TraceWriter();
+    TraceWriter(const TraceWriter &) = delete;
+    TraceWriter &operator=(const TraceWriter &) = delete;
+
+    bool open(const std::string &path, int board_size);
+    void close();
+    bool is_open() const { return file != nullptr; }
+
+    void write(const TraceRecord &record) {
+        buffers[active][filled++] = record;
+        if (filled == BUFFER_RECORDS)
+            flush();
+    }
+    void flush();
+
+private:
+    std::FILE *file{nullptr};
+    std::vector<TraceRecord> buffers[2];
+    int active{0};
+    size_t filled{0};
+
+    std::thread writer;
+    std::mutex mutex;
+    std::condition_variable changed;
+    size_t pending{0};      // records of the other buffer still to be written
+    bool stopping{false};
+
+    void run();
+};
+
+#endif //GOMOKU_TRACE_HPP
@@ -0,0 +1,122 @@
+//
+// Transposition table of fixed size in one mapping, kept across searches and saved to a file between sessions.
+// A file is a TableHeader followed by capacity TableEntries in table order, the checksum covers the entries.
+// Scores are Eval's, positive for white, so searches for either color share the entries. Keys are the boards'
+// Zobrist hashes, a file only loads for the board size, rules, keys and EVAL_VERSION it was saved with.
+//
+
+#ifndef GOMOKU_TT_HPP
+#define GOMOKU_TT_HPP
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#define TT_VERSION 1
+// Entries of one probe, a cache line
+#define TT_BUCKET 4
+
+#pragma pack(push, 1)
+struct TableHeader
+{
+    char magic[4];          // "GTTF"
+    uint32_t version;
+    uint32_t eval_version;  // EVAL_VERSION of the scores
+    uint8_t board_size;
+    uint8_t reserved[3];
+    char rules[16];         // Rules::name, zero padded
+    uint64_t keys;          // fingerprint of the Zobrist keys of the board size
+    uint64_t capacity;      // entries, a power of two
+    uint64_t checksum;      // of the entries
+    uint64_t used;          // entries holding a score
+};
+#pragma pack(pop)
+
+// The board hash with what else Eval reads, the color to play and the capture counts
+inline uint64_t table_key(uint64_t hash, bool white_to_move, uint64_t black_captures, uint64_t white_captures)
+{
+    return hash ^ (white_to_move ? 0x9E3779B97F4A7C15ull : 0)
+           ^ black_captures * 0xBF58476D1CE4E5B9ull ^ white_captures * 0x94D049BB133111EBull;
+}
+
+// Written and read without locks by every search sharing the table. check is the key xor data,
+// so an entry torn by two writers no longer matches its key and reads as a miss.
+struct TableEntry
+{
+    std::atomic<uint64_t> check;
+    std::atomic<uint64_t> data;     // the score in the low 32 bits, 0 while the entry is free
+};
+
+class TranspositionTable
+{
+public:
+    TranspositionTable() = default;
+    ~TranspositionTable();
+    TranspositionTable(const TranspositionTable &) = delete;
+    TranspositionTable &operator=(const TranspositionTable &) = delete;
+
+    // An empty table of at most bytes for boards of size and rules, rules is a Rules::name
+    bool create(int size, const std::string &rules, uint64_t bytes);
+    // Maps a saved table privately and reads it once front to back for the checksum,
+    // the file itself is never written through the mapping
+    bool load(const std::string &path);
+    // Writes the table front to back to a temporary file renamed over path; not while a search uses it
+    bool save(const std::string &path) const;
+    void close();
+    const std::string &error() const { return last_error; }
+
+    bool is_open() const { return entries != nullptr; }
+    int board_size() const { return size; }
+    const std::string &rules() const { return rules_name; }
+    uint64_t capacity() const { return entries_count; }
+    // Exact after load, searches racing for the same free entry may count it twice
+    uint64_t used() const { return used_count.load(std::memory_order_relaxed); }
+
+    bool probe(uint64_t key, int32_t &score) const {
+        const TableEntry *bucket = entries + (key & mask);
+        for (int i = 0; i < TT_BUCKET; ++i) {
+            const uint64_t data = bucket[i].data.load(std::memory_order_relaxed);
+            if ((bucket[i].check.load(std::memory_order_relaxed) ^ data) == key && data) {
+                score = static_cast<int32_t>(static_cast<uint32_t>(data));
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Takes the entry of the key or the first free one, in a full bucket one picked by the key is replaced
+    void store(uint64_t key, int32_t score) {
+        TableEntry *bucket = entries + (key & mask);
+        // Bit 32 marks the entry used, a score of 0 is still data
+        const uint64_t data = static_cast<uint32_t>(score) | 1ull << 32;
+        TableEntry *slot = &bucket[(key >> 32) % TT_BUCKET];
+        for (int i = 0; i < TT_BUCKET; ++i) {
+            const uint64_t old = bucket[i].data.load(std::memory_order_relaxed);
+            if (!old) {
+                used_count.fetch_add(1, std::memory_order_relaxed);
+                slot = &bucket[i];
+                break;
+            }
+            if ((bucket[i].check.load(std::memory_order_relaxed) ^ old) == key) {
+                slot = &bucket[i];
+                break;
+            }
+        }
+        slot->check.store(key ^ data, std::memory_order_relaxed);
+        slot->data.store(data, std::memory_order_relaxed);
+    }
+
+private:
+    uint8_t *base{nullptr};
+    size_t length{0};
+    TableEntry *entries{nullptr};
+    uint64_t entries_count{0};
+    uint64_t mask{0};               // of the first entry of a bucket
+    std::atomic<uint64_t> used_count{0};
+    int size{0};
+    std::string rules_name;
+    mutable std::string last_error;
+
+    void attach(int size, const std::string &rules, void *mapped, size_t bytes, uint64_t capacity);
+};
+
+#endif //GOMOKU_TT_HPP
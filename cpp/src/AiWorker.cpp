@@ -0,0 +1,41 @@
+#include "AiWorker.hpp"
+
+AiWorker::AiWorker(Game *game, QObject *parent)
+    : QObject(parent)
+    , result(false)
+    , game(game)
+{
+    qRegisterMetaType<SearchProgress>("SearchProgress");
+    control.progress = [this](const SearchProgress &progress) {
+        emit progressed(progress);
+    };
+}
+
+void AiWorker::start(int color) {
+    // Cleared here rather than in run so a stop right after start is not lost
+    control.stop = false;
+    QMetaObject::invokeMethod(this, "run", Qt::QueuedConnection, Q_ARG(int, color));
+}
+
+void AiWorker::startAnalysis(int color, int count) {
+    control.stop = false;
+    QMetaObject::invokeMethod(this, "runAnalysis", Qt::QueuedConnection, Q_ARG(int, color), Q_ARG(int, count));
+}
+
+void AiWorker::stop() {
+    control.stop = true;
+}
+
+void AiWorker::run(int color) {
+    game->board.control = &control;
+    result = game->predictMove(static_cast<int8_t>(color));
+    game->board.control = nullptr;
+    emit searchFinished();
+}
+
+void AiWorker::runAnalysis(int color, int count) {
+    game->board.control = &control;
+    analysis = game->analyze(static_cast<int8_t>(color), count);
+    game->board.control = nullptr;
+    emit searchFinished();
+}
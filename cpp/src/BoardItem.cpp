@@ -0,0 +1,128 @@
+#include <algorithm>
+#include <QGraphicsSceneHoverEvent>
+#include <QPen>
+
+#include "BoardItem.hpp"
+
+BoardItem::BoardItem(int pSize, const QPixmap &white, const QPixmap &black)
+    : QGraphicsItem()
+    , pSize(pSize)
+{
+    pieces[Scene::WHITE] = white.scaled(pSize, pSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    pieces[Scene::BLACK] = black.scaled(pSize, pSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    setAcceptHoverEvents(true);
+    // exposedRect tells paint which cells to draw
+    setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
+}
+
+QRectF BoardItem::boundingRect() const {
+    return {0, 0, static_cast<qreal>(GSIZE * pSize), static_cast<qreal>(GSIZE * pSize)};
+}
+
+QRectF BoardItem::cellRect(int x, int y) const {
+    return {static_cast<qreal>(x * pSize), static_cast<qreal>(y * pSize),
+            static_cast<qreal>(pSize), static_cast<qreal>(pSize)};
+}
+
+QPoint BoardItem::cellAt(const QPointF &pos) const {
+    const int x = static_cast<int>(pos.x()) / pSize;
+    const int y = static_cast<int>(pos.y()) / pSize;
+    if (pos.x() < 0 || pos.y() < 0 || x >= GSIZE || y >= GSIZE)
+        return {-1, -1};
+    return {x, y};
+}
+
+const QPixmap &BoardItem::ring(const QColor &color) {
+    auto it = rings.find(color.rgba());
+    if (it != rings.end())
+        return *it;
+    QPixmap pixmap(pSize, pSize);
+    pixmap.fill(Qt::transparent);
+    QPainter painter(&pixmap);
+    QPen pen;
+    pen.setWidth(3);
+    pen.setColor(color);
+    painter.setPen(pen);
+    painter.drawEllipse(0, 0, pSize - 2, pSize - 2);
+    return *rings.insert(color.rgba(), pixmap);
+}
+
+void BoardItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) {
+    (void)widget;
+    const QRectF exposed = option->exposedRect;
+    const int fromX = std::max(0, static_cast<int>(exposed.left()) / pSize);
+    const int fromY = std::max(0, static_cast<int>(exposed.top()) / pSize);
+    const int toX = std::min(GSIZE - 1, static_cast<int>(exposed.right()) / pSize);
+    const int toY = std::min(GSIZE - 1, static_cast<int>(exposed.bottom()) / pSize);
+    QFont font;
+    font.setBold(true);
+    font.setPixelSize(20);
+    painter->setFont(font);
+    painter->setPen(QColor(Qt::white));
+    for (int y = fromY; y <= toY; ++y) {
+        for (int x = fromX; x <= toX; ++x) {
+            const auto &d = cells[y][x];
+            const int sx = x * pSize, sy = y * pSize;
+            if (d.color != Scene::EMPTY)
+                painter->drawPixmap(sx, sy, pieces[d.color]);
+            if (d.highlight != QColor(Qt::transparent))
+                painter->drawPixmap(sx, sy, ring(d.highlight));
+            if (hovered == QPoint(x, y))
+                painter->drawPixmap(sx, sy, ring(Qt::green));
+            if (!d.text.isNull())
+                painter->drawText(sx, sy + 15, d.text);
+        }
+    }
+}
+
+const Scene::TokenDef &BoardItem::def(int x, int y) const {
+    return cells[y][x];
+}
+
+void BoardItem::setDef(int x, int y, const Scene::TokenDef &d) {
+    if (cells[y][x] == d)
+        return;
+    cells[y][x] = d;
+    if (d.highlight != QColor(Qt::transparent) || !d.text.isNull())
+        decorated.insert(y * GSIZE + x);
+    else
+        decorated.remove(y * GSIZE + x);
+    update(cellRect(x, y));
+}
+
+void BoardItem::setColor(int x, int y, Scene::TokenColor color) {
+    setDef(x, y, {color, cells[y][x].highlight, cells[y][x].text});
+}
+
+void BoardItem::setHighlight(int x, int y, const QColor &highlight) {
+    setDef(x, y, {cells[y][x].color, highlight, cells[y][x].text});
+}
+
+void BoardItem::setHovered(QPoint cell) {
+    if (hovered == cell)
+        return;
+    if (hovered.x() >= 0)
+        update(cellRect(hovered.x(), hovered.y()));
+    hovered = cell;
+    if (hovered.x() >= 0)
+        update(cellRect(hovered.x(), hovered.y()));
+}
+
+void BoardItem::clearDecorations() {
+    // setDef takes the cells out of the set
+    const QSet<int> cleared = decorated;
+    for (int cell : cleared) {
+        const int x = cell % GSIZE, y = cell / GSIZE;
+        setDef(x, y, {cells[y][x].color, QColor(Qt::transparent), QString()});
+    }
+}
+
+void BoardItem::hoverMoveEvent(QGraphicsSceneHoverEvent *event) {
+    QGraphicsItem::hoverMoveEvent(event);
+    setHovered(cellAt(event->pos()));
+}
+
+void BoardItem::hoverLeaveEvent(QGraphicsSceneHoverEvent *event) {
+    QGraphicsItem::hoverLeaveEvent(event);
+    setHovered(QPoint(-1, -1));
+}
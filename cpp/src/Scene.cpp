@@ -1,14 +1,20 @@
-#include "Token.hpp"
+#include "BoardItem.hpp"
 #include "Scene.hpp"
 #include "Patterns.hpp"
 #include <QApplication>
+#include <cstdlib>
 
 void Scene::drawBackground(QPainter *painter, const QRectF &rect) {
     QGraphicsScene::drawBackground(painter, rect);
-    painter->drawPixmap(QRectF(bg.rect()), bg, QRectF(bg.rect()));
+    // Only the exposed part, a changed cell repaints little more than itself
+    const QRectF bgRect = rect & QRectF(bg.rect());
+    if (!bgRect.isEmpty())
+        painter->drawPixmap(bgRect, bg, bgRect);
     QRectF pr(imPanel.rect());
     pr.moveLeft(bg.rect().width());
-    painter->drawPixmap(pr, imPanel, QRectF(imPanel.rect()));
+    const QRectF panelRect = rect & pr;
+    if (!panelRect.isEmpty())
+        painter->drawPixmap(panelRect, imPanel, panelRect.translated(-pr.left(), 0));
 //    qDebug() << "drawBackground" << "bg valid: " << !bg.isNull();
 }
 
@@ -19,21 +25,26 @@ Scene::Scene(Game *game, QObject *parent)
     , imWhitePeace(QPixmap(QString().fromStdString("images/whitePiece.png")))
     , imBlackPeace(QPixmap(QString().fromStdString("images/blackPiece.png")))
     , imPanel(QPixmap(QString().fromStdString("images/panel.jpg")))
+    , aiWorker(new AiWorker(game))
     , bg(QPixmap(QString().fromStdString("images/board.jpg")))
     {
-    for (int y = 0; y < GSIZE; ++y) {
-        for (int x = 0; x < GSIZE; ++x) {
-            auto t = new Token(x, y);
-            this->addItem(t);
-//            qDebug() << "xy: " << x << y;
-            t->setPos(this->boardPosToView(QPoint(x, y)));
-            tokens[y][x] = t;
-        }
-    }
+    board = new BoardItem(pSize, imWhitePeace, imBlackPeace);
+    board->setPos(this->boardPosToView(QPoint(0, 0)));
+    this->addItem(board);
+    aiWorker->moveToThread(&aiThread);
+    connect(&aiThread, &QThread::finished, aiWorker, &QObject::deleteLater);
+    connect(aiWorker, &AiWorker::progressed, this, &Scene::onAiProgress);
+    connect(aiWorker, &AiWorker::searchFinished, this, &Scene::onAiFinished);
+    aiThread.start();
+    game->setListener([this](const MoveChanges &changes) { applyChanges(changes); });
     reset();
 }
 
 Scene::~Scene() {
+    game->setListener(nullptr);
+    aiWorker->stop();
+    aiThread.quit();
+    aiThread.wait();
     for (const auto &item : items()) {
         removeItem(item);
         delete item;
@@ -56,16 +67,20 @@ QPoint Scene::boardPosToView(QPoint pt) {
     return p;
 }
 
-Token *Scene::getToken(int x, int y) {
+const Scene::TokenDef &Scene::getToken(int x, int y) const {
+    return board->def(x, y);
+}
+
+void Scene::setHighlight(int x, int y, QColor highlight) {
     if (x >= GSIZE || x < 0 || y >= GSIZE || y < 0)
-        return nullptr;
-    return tokens[y][x];
+        return;
+    board->setHighlight(x, y, highlight);
 }
 
 void Scene::setBoard(TokenDef tks[GSIZE][GSIZE]) {
     for (int y = 0; y < GSIZE; ++y) {
         for (int x = 0; x < GSIZE; ++x) {
-            getToken(x,y)->setDef(tks[y][x]);
+            board->setDef(x, y, tks[y][x]);
         }
     }
 }
@@ -73,17 +88,16 @@ void Scene::setBoard(TokenDef tks[GSIZE][GSIZE]) {
 void Scene::setBoard(TokenDef tks[GSIZE*GSIZE]) {
     for (int y = 0; y < GSIZE; ++y) {
         for (int x = 0; x < GSIZE; ++x) {
-            getToken(x,y)->setDef(tks[y * GSIZE + x]);
+            board->setDef(x, y, tks[y * GSIZE + x]);
         }
     }
 }
 
 void Scene::setToken(int x, int y, Scene::TokenDef td) {
-    auto tk = getToken(x, y);
-    if (!tk)
+    if (x >= GSIZE || x < 0 || y >= GSIZE || y < 0)
         return;
-    tk->setDef(td);
-    game->setToken(tk->x, tk->y, tk->def.color);
+    board->setDef(x, y, td);
+    game->setToken(x, y, td.color);
 }
 
 Scene::TokenColor Scene::tokenColorFromInt(int v) {
@@ -103,15 +117,14 @@ void Scene::mousePressEvent(QGraphicsSceneMouseEvent *event) {
     QGraphicsScene::mousePressEvent(event);
     if (event->button() == Qt::LeftButton)
     {
-        auto *item = itemAt(event->scenePos(), QTransform());// it is your clicked item, you can do everything what you want. for example send it somewhere
-        auto *ell = qgraphicsitem_cast<Token *>(item);
-        if(ell)
+        const QPoint cell = board->cellAt(board->mapFromScene(event->scenePos()));
+        if (cell.x() >= 0)
         {
-            qDebug() << "clicked token at" << ell->x << ell->y;
-            onTokenClicked(ell, event);
+            qDebug() << "clicked token at" << cell.x() << cell.y();
+            onTokenClicked(cell.x(), cell.y(), event);
         }
         else
-            qDebug() << "not ell" << event->scenePos();
+            qDebug() << "not on the board" << event->scenePos();
     }
 }
 
@@ -119,65 +132,51 @@ int Scene::intFromTokenColor(Scene::TokenColor v) {
     return v;
 }
 
-void Scene::onTokenClicked(Token *token, QGraphicsSceneMouseEvent *event) {
+void Scene::onTokenClicked(int x, int y, QGraphicsSceneMouseEvent *event) {
+    if (thinking)
+        return;
     if (devMode){
+        TokenColor color = getToken(x, y).color;
         switch (event->modifiers())
         {
             case Qt::Modifier::SHIFT:
-                token->def.color = BLACK;
+                color = BLACK;
                 break;
             case Qt::Modifier::ALT:
-                token->def.color = WHITE;
+                color = WHITE;
                 break;
             case 0:
-                token->def.color = EMPTY;
+                color = EMPTY;
                 break;
         }
-        game->setToken(token->x, token->y, token->def.color);
-        token->update();
-        reset();
+        game->setToken(x, y, color);
         return;
     } else if (pvpMode && game->result() == Board::NO_RESULT) {
-        if (!game->getToken(token->x, token->y))
+        if (!game->getToken(x, y))
         {
             TokenColor color;
             if (lastPredictedMove.v == BLACK)
                 color = WHITE;
             else
                 color = BLACK;
-            if (game->setToken(token->x, token->y, color)) {
-                token->def.color = color;
-                token->update();
-                Move move{true, static_cast<int8_t>(token->x), static_cast<int8_t>(token->y),
-                          static_cast<int8_t>(token->def.color), 0};
-                if (lastPredictedMove.valid)
-                    getToken(lastPredictedMove.x, lastPredictedMove.y)->def.highlight = Qt::transparent;
+            if (game->setToken(x, y, color)) {
+                clearHighlights();
+                Move move{true, static_cast<int8_t>(x), static_cast<int8_t>(y),
+                          static_cast<int8_t>(color), 0};
                 lastPredictedMove = move;
-                reset();
-                getToken(lastPredictedMove.x, lastPredictedMove.y)->def.highlight = Qt::darkRed;
+                setHighlight(lastPredictedMove.x, lastPredictedMove.y, Qt::darkRed);
                 check();
             }
         }
     } else if (game->result() == Board::NO_RESULT) {
-        if (!game->getToken(token->x, token->y))
+        if (!game->getToken(x, y))
         {
 
-            if (!game->setToken(token->x, token->y, playAs))
+            if (!game->setToken(x, y, playAs))
                 return;
-            token->def.color = playAs;
-            token->update();
             if (check())
                 return;
-            auto move  = game->predictMove(playAs == BLACK ? WHITE : BLACK);
-            if (move.valid) {
-                if (lastPredictedMove.valid)
-                    getToken(lastPredictedMove.x, lastPredictedMove.y)->def.highlight = Qt::transparent;
-                lastPredictedMove = move;
-                game->setToken(move.x, move.y, move.v);
-                reset();
-                getToken(lastPredictedMove.x, lastPredictedMove.y)->def.highlight = Qt::darkRed;
-                check();
-            }
+            startSearch(playAs == BLACK ? WHITE : BLACK, AI_MOVE);
         }
     }
 }
@@ -187,35 +186,57 @@ void Scene::reset() {
         return;
     for (int y = 0; y < GSIZE; ++y) {
         for (int x = 0; x < GSIZE; ++x) {
-            auto second = game->board.getToken(x, y);
+            const auto stone = game->getToken(x, y);
             QColor secondColor;
-            switch (second) {
-                case Board::BLACK:
+            switch (stone) {
+                case BLACK_STONE:
                     secondColor = Qt::darkBlue;
                     break;
-                case Board::WHITE:
+                case WHITE_STONE:
                     secondColor = Qt::darkRed;
                     break;
                 default:
                     secondColor = Qt::transparent;
                     break;
             }
-            getToken(x, y)->setDef({
-              Scene::tokenColorFromInt(game->getToken(x, y)),
+            board->setDef(x, y, {
+              Scene::tokenColorFromInt(stone),
               QColor(!showMask ? Qt::transparent : secondColor),
               showMask && game->board.move_map[GSIZE * y + x] ? QString::number(game->board.move_map[GSIZE * y + x]) : QString()
             });
         }
     }
-    update();
+    shownCaptures[0] = game->board.black_captures_count;
+    shownCaptures[1] = game->board.white_captures_count;
     emit resetted();
 }
 
+// Follows the game move by move, only the cells that changed are repainted
+void Scene::applyChanges(const MoveChanges &changes) {
+    // The mask shows move_map counts around every stone, only a full pass keeps them right
+    if (changes.cleared || showMask) {
+        reset();
+        return;
+    }
+    for (const auto &cell : changes.cells)
+        board->setColor(cell.x, cell.y, cell.kind == CellChange::PLACED ? tokenColorFromInt(cell.v) : EMPTY);
+    if (changes.black_captures != shownCaptures[0] || changes.white_captures != shownCaptures[1]) {
+        shownCaptures[0] = changes.black_captures;
+        shownCaptures[1] = changes.white_captures;
+        emit capturesChanged();
+    }
+}
+
+// Overlays, hints and analysis go away after a move, the stones stay
+void Scene::clearHighlights() {
+    if (showMask)
+        return;
+    board->clearDecorations();
+}
+
 void Scene::startGame() {
     if (playAs == WHITE && !pvpMode) {
         game->setToken(BOARD_SIZE/2, BOARD_SIZE/2, BLACK);
-        getToken(BOARD_SIZE/2, BOARD_SIZE/2)->def.color = BLACK;
-        getToken(BOARD_SIZE/2, BOARD_SIZE/2)->update();
     }
 }
 
@@ -239,36 +260,120 @@ void Scene::onGameFinished(Board::Result result) {
     emit finished();
 }
 
-bool Scene::check() {
-    bool b5 = game->board.PtrMatch(bFive);
-    auto c5b = game->board.black_captures_count >= 5;
+bool Scene::check(bool lastMoveKnown) {
+    auto result = game->board.winner(lastMoveKnown);
+    if (result == Board::NO_RESULT)
+        return false;
+    onGameFinished(result);
+    game->board.result = result;
+    return true;
+}
 
-    bool w5 = game->board.PtrMatch(wFive);
-    auto c5w = game->board.white_captures_count >= 5;
-    if (b5 || c5b)
-    {
-        onGameFinished(Board::BLACK_WIN);
-        game->board.result = Board::BLACK_WIN;
-        return true;
-    }
-    if (w5 || c5w)
-    {
-        onGameFinished(Board::WHITE_WIN);
-        game->board.result = Board::WHITE_WIN;
-        return true;
-    }
-    return false;
+void Scene::onLoaded() {
+    check(false);
 }
 
 void Scene::onHelpMove() {
     qDebug() << "onHelpMove";
-    if (!pvpMode)
+    if (!pvpMode || thinking)
         return;
-    auto move  = game->predictMove(lastPredictedMove.v == BLACK ? WHITE : BLACK);
-    qDebug() << move.x << ":" << move.y;
-    if (!move.valid)
+    startSearch(lastPredictedMove.v == BLACK ? WHITE : BLACK, HINT);
+}
+
+void Scene::onAnalyze() {
+    qDebug() << "onAnalyze";
+    if (thinking || game->result() != Board::NO_RESULT)
+        return;
+    startSearch(game->board.move == BLACK ? WHITE : BLACK, ANALYSIS);
+}
+
+bool Scene::isThinking() const {
+    return thinking;
+}
+
+void Scene::startSearch(TokenColor color, SearchKind kind) {
+    thinking = true;
+    searchKind = kind;
+    emit thinkingChanged(true);
+    if (kind == ANALYSIS)
+        aiWorker->startAnalysis(color, analysisLines);
+    else
+        aiWorker->start(color);
+}
+
+void Scene::onMoveNow() {
+    if (thinking)
+        aiWorker->stop();
+}
+
+void Scene::setLiveBest(QPoint pt) {
+    if (liveBest == pt)
+        return;
+    setHighlight(liveBest.x(), liveBest.y(), Qt::transparent);
+    liveBest = pt;
+    setHighlight(liveBest.x(), liveBest.y(), Qt::darkYellow);
+}
+
+void Scene::onAiProgress(SearchProgress progress) {
+    if (!thinking)
         return;
-    getToken(move.x, move.y)->def.highlight = lastPredictedMove.v == BLACK ? Qt::white : Qt::black;
-    getToken(move.x, move.y)->update();
-    update();
+    if (progress.root_moves_done)
+        setLiveBest(QPoint(progress.best_move & 0xFF, progress.best_move >> 8));
+    emit progressed(progress);
+}
+
+void Scene::onAiFinished() {
+    setLiveBest(QPoint(-1, -1));
+    thinking = false;
+    if (searchKind == ANALYSIS) {
+        emit thinkingChanged(false);
+        showAnalysis(aiWorker->analysis);
+        return;
+    }
+    auto move = aiWorker->result;
+    qDebug() << "ai move" << move.x << ":" << move.y << "in" << move.tookSecond << "s";
+    if (searchKind == HINT) {
+        emit thinkingChanged(false);
+        if (!move.valid)
+            return;
+        setHighlight(move.x, move.y, lastPredictedMove.v == BLACK ? Qt::white : Qt::black);
+        return;
+    }
+    if (move.valid) {
+        lastPredictedMove = move;
+        game->setToken(move.x, move.y, move.v);
+        clearHighlights();
+        setHighlight(lastPredictedMove.x, lastPredictedMove.y, Qt::darkRed);
+    }
+    emit thinkingChanged(false);
+    if (move.valid)
+        check();
+}
+
+static QString shortScore(int32_t score) {
+    if (std::abs(score) < 1000)
+        return QString::number(score);
+    if (std::abs(score) < 1000000)
+        return QString::number(score / 1000) + "k";
+    return score > 0 ? "W" : "L";
+}
+
+// Score heatmap from green for the best move to red for the worst shown
+void Scene::showAnalysis(const std::vector<RootLine> &lines) {
+    reset();
+    if (lines.empty())
+        return;
+    const double best = lines.front().score;
+    const double range = best - lines.back().score;
+    for (const auto &line : lines) {
+        QString pv;
+        for (auto m : line.pv)
+            pv += QString(" %1,%2").arg(m & 0xFF).arg(m >> 8);
+        qDebug() << "analysis" << line.score << "pv" << pv;
+        const int x = line.move & 0xFF, y = line.move >> 8;
+        if (x >= GSIZE || y >= GSIZE)
+            continue;
+        const int hue = range > 0 ? static_cast<int>(120 * (1 - (best - line.score) / range)) : 120;
+        board->setDef(x, y, {getToken(x, y).color, QColor::fromHsv(hue, 255, 230), shortScore(line.score)});
+    }
 }
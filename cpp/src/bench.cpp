@@ -0,0 +1,877 @@
+#include "bench.hpp"
+#include <limits>
+#include <sstream>
+#include "engine.hpp"
+
+namespace {
+
+// Middle game positions from self-play on 19x19 with pro-captures, no pair captured yet.
+// The first line is the last move x, y and its color, the side to move is the other one.
+const char *const BENCH_POSITIONS[] = {
+        "11 12 2\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "________O__________\n"
+        "_______O___________\n"
+        "______O_____X______\n"
+        "______X____X_______\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n",
+
+        "10 13 2\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "_____________O_____\n"
+        "____________O______\n"
+        "___________O_______\n"
+        "______O____XX______\n"
+        "_____________X_____\n"
+        "___________________\n"
+        "___________________\n"
+        "____________X______\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n",
+
+        "11 16 2\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "_______________OX__\n"
+        "___________X__O____\n"
+        "_____________O_____\n"
+        "____________O______\n"
+        "________OXX________\n"
+        "_________X_________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n",
+
+        "9 16 2\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "______O____X_______\n"
+        "___________________\n"
+        "___________________\n"
+        "__________X___XOX__\n"
+        "______________O____\n"
+        "___________O_O_____\n"
+        "____________O______\n"
+        "____________X______\n"
+        "_____________X_____\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n",
+
+        "6 13 2\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "_________O__O______\n"
+        "_________X_O_______\n"
+        "_________OOXX______\n"
+        "___________X_X_____\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n",
+
+        "9 10 1\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "______OO_OO________\n"
+        "_______X___X_______\n"
+        "__________X________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n",
+
+        "12 12 1\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "__________O_O______\n"
+        "____________XO_____\n"
+        "_________O__X______\n"
+        "___________X_______\n"
+        "___________X_______\n"
+        "______O____________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n",
+
+        "12 13 1\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "__________OOOOX____\n"
+        "___________XXO_____\n"
+        "_________O__X______\n"
+        "___________X_______\n"
+        "___________X_______\n"
+        "______O____________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n",
+
+        "11 15 2\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "______________OX___\n"
+        "_____________O_____\n"
+        "____________O______\n"
+        "___________O_______\n"
+        "_______X___XX______\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n",
+
+        "10 15 2\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "_______O___________\n"
+        "______________OX___\n"
+        "______X______O_____\n"
+        "____________O______\n"
+        "___________OXX_____\n"
+        "______________X____\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n",
+
+        "11 13 2\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "______________O____\n"
+        "_____________O_____\n"
+        "____________O______\n"
+        "_____________X_____\n"
+        "______X____________\n"
+        "______X____________\n"
+        "______O____________\n"
+        "______X____________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n",
+
+        "6 12 2\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "______O____________\n"
+        "_______X___________\n"
+        "___________________\n"
+        "___________________\n"
+        "______OOOO_________\n"
+        "_______X__X_X______\n"
+        "___________X_______\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n",
+
+        "9 15 2\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "________O__________\n"
+        "___________X_______\n"
+        "_______O___________\n"
+        "______________OX___\n"
+        "__________X__O_____\n"
+        "______X_____O______\n"
+        "___________O_______\n"
+        "___________XX______\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n",
+
+        "12 12 1\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "____________X______\n"
+        "________OO_OO______\n"
+        "___________X_______\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "_________X_________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n",
+
+        "12 12 1\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "__________O_O______\n"
+        "______O___XX_______\n"
+        "___________________\n"
+        "_________O_________\n"
+        "_________O_________\n"
+        "________X__________\n"
+        "_______X___________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n",
+
+        "13 15 2\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "_____________X_X___\n"
+        "__________OOO_O____\n"
+        "______O___XXX______\n"
+        "___________________\n"
+        "_________O_________\n"
+        "_________O_________\n"
+        "________X__________\n"
+        "_______X___________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n",
+
+        "8 12 2\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________X_______\n"
+        "_____________O_____\n"
+        "____________O______\n"
+        "___________O_______\n"
+        "___________XX______\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n",
+
+        "7 13 2\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "________O__________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "____________OOO____\n"
+        "____________XX_____\n"
+        "___________XX______\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n",
+
+        "5 12 2\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "_____________O_____\n"
+        "____________XXO____\n"
+        "_____________X_O___\n"
+        "___________________\n"
+        "_________O_________\n"
+        "___________X_______\n"
+        "___________O_______\n"
+        "____________X______\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n",
+
+        "11 13 2\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "____________X_____O\n"
+        "_____________O___O_\n"
+        "____________XXO_O__\n"
+        "_____________X_O___\n"
+        "_______________X___\n"
+        "_________O_________\n"
+        "___________X_______\n"
+        "___________O_______\n"
+        "____________X______\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n",
+
+        "9 12 2\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "_________X_________\n"
+        "____________O______\n"
+        "______O____O_______\n"
+        "________XXO_X______\n"
+        "_______O___________\n"
+        "______X____________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n",
+
+        "13 6 1\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "______O____________\n"
+        "______O____________\n"
+        "_____XO____________\n"
+        "______O____________\n"
+        "_________X_________\n"
+        "___________________\n"
+        "______X____________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n",
+
+        "7 16 1\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "____________X______\n"
+        "___________________\n"
+        "_______________X___\n"
+        "_______O____OOO_O__\n"
+        "____________X______\n"
+        "____________X______\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n",
+
+        "6 16 1\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "______X____________\n"
+        "________X__________\n"
+        "________________X__\n"
+        "____________OX_X___\n"
+        "______________O____\n"
+        "__________O____OO__\n"
+        "_________O_________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n",
+
+        "14 18 2\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "__________________X\n"
+        "_________________O_\n"
+        "__________________X\n"
+        "______X___________X\n"
+        "________X________X_\n"
+        "________________X__\n"
+        "____________OX_X___\n"
+        "______________O_O__\n"
+        "__________O_____OO_\n"
+        "_________O_________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n",
+
+        "18 18 1\n"
+        "__________________O\n"
+        "__________________X\n"
+        "_________________O_\n"
+        "_________________OX\n"
+        "__________________X\n"
+        "_________________O_\n"
+        "_________________OX\n"
+        "______X___________X\n"
+        "________X________X_\n"
+        "________________X_X\n"
+        "____________OX_X___\n"
+        "______________O_O__\n"
+        "__________O_____OO_\n"
+        "_________O_________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n",
+
+        "8 12 1\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "________O__________\n"
+        "______OXX___O______\n"
+        "________X___O______\n"
+        "____________O______\n"
+        "___________X_______\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n",
+
+        "15 16 2\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "_______________OX__\n"
+        "______________O____\n"
+        "_____________O_____\n"
+        "__________X_OXX____\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n",
+
+        "15 13 2\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "____________OX_____\n"
+        "___________O_______\n"
+        "__________O________\n"
+        "_________O_X_______\n"
+        "_______X_X_________\n"
+        "__________X________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "________O__________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n",
+
+        "8 12 2\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "____________X______\n"
+        "___________XX______\n"
+        "________OOO_O______\n"
+        "_______X___________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n",
+
+        "7 13 2\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "_________XO________\n"
+        "___________O_______\n"
+        "______________O____\n"
+        "____________OO_____\n"
+        "______X_____XX_____\n"
+        "____________X______\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n",
+
+        "16 17 1\n"
+        "___________________\n"
+        "___________________\n"
+        "_________________O_\n"
+        "________________X__\n"
+        "_______________O___\n"
+        "____________O_X____\n"
+        "___________O_X_____\n"
+        "___________________\n"
+        "_________O_________\n"
+        "__________X________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n",
+
+        "13 18 2\n"
+        "_________________OO\n"
+        "__________________X\n"
+        "_________________OX\n"
+        "________________X_X\n"
+        "_______________O__O\n"
+        "____________O_X___X\n"
+        "___________O_X_____\n"
+        "___________________\n"
+        "_________O_________\n"
+        "__________X________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n",
+
+        "8 18 1\n"
+        "_________________OO\n"
+        "_________________OX\n"
+        "_________________OX\n"
+        "________________XOX\n"
+        "_______________O__O\n"
+        "____________O_X___X\n"
+        "___________O_X____X\n"
+        "__________________X\n"
+        "_________O________O\n"
+        "__________X_______X\n"
+        "__________________O\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n",
+
+        "1 18 2\n"
+        "_________________OO\n"
+        "_________________OX\n"
+        "_________________OX\n"
+        "________________XOX\n"
+        "_______________O__O\n"
+        "____________O_X___X\n"
+        "___________O_X____X\n"
+        "__________________X\n"
+        "_________O________O\n"
+        "__________X_______X\n"
+        "__________________O\n"
+        "__________________X\n"
+        "__________________O\n"
+        "__________________X\n"
+        "__________________O\n"
+        "__________________X\n"
+        "__________________O\n"
+        "__________________X\n"
+        "___________________\n",
+
+        "11 14 1\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "_______O____X_X____\n"
+        "__________OO_OO____\n"
+        "___________________\n"
+        "________X__________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________X_______\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n",
+
+        "7 15 1\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "_________X_________\n"
+        "___________________\n"
+        "_______O_______X___\n"
+        "___________OX_X____\n"
+        "_____________O_____\n"
+        "_______X_OX___OO___\n"
+        "________O__________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n",
+
+        "14 18 2\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "__________________X\n"
+        "__________________O\n"
+        "_________X________X\n"
+        "________________XX_\n"
+        "_______O_______X___\n"
+        "___________OX_X____\n"
+        "_____________O_____\n"
+        "_______X_OX____OOO_\n"
+        "________O__________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n",
+
+        "7 18 1\n"
+        "__________________X\n"
+        "__________________O\n"
+        "__________________X\n"
+        "__________________O\n"
+        "__________________X\n"
+        "__________________O\n"
+        "_________X________X\n"
+        "________________XXO\n"
+        "_______O_______X__X\n"
+        "___________OX_X____\n"
+        "_____________O_____\n"
+        "_______X_OX____OOOO\n"
+        "________O__________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n",
+
+        "9 11 2\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________O_______\n"
+        "__________O________\n"
+        "_________O_________\n"
+        "_________X_________\n"
+        "___________X_______\n"
+        "__________X________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+        "___________________\n"
+};
+
+}
+
+BenchResult runBench(int depth, std::ostream *log)
+{
+    BenchResult result{};
+    SearchLimits limits;
+    limits.depth = depth;
+    // The time cutoff would make the node count depend on the machine
+    limits.seconds = std::numeric_limits<double>::infinity();
+
+    auto engine = Engine::create(19, ProCaptures::name);
+    for (const char *position : BENCH_POSITIONS) {
+        std::istringstream in(position);
+        if (!engine->readBoard(in))
+            continue;
+        const Move move = engine->predictMove(engine->toMove(), limits);
+        const SearchStats stats = engine->stats();
+        result.nodes += stats.nodes;
+        result.seconds += stats.seconds;
+        if (log)
+            *log << "position " << result.positions << " move " << int(move.x) << "," << int(move.y)
+                 << " nodes " << stats.nodes << std::endl;
+        ++result.positions;
+    }
+    return result;
+}
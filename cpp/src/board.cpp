@@ -1,552 +1,970 @@
 #include "board.hpp"
 #include "Patterns.hpp"
+#include <algorithm>
 #include <cstdlib>
 #include <limits>
 #include <ostream>
 
-Board::Board()
+#ifdef GOMOKU_SEARCH_TRACE
+# define GOMOKU_TRACE_ENTER(ply, x, y, alpha, beta) trace_enter(ply, static_cast<int16_t>((x) | (y) << 8), alpha, beta)
+# define GOMOKU_TRACE_EXIT(ply, score, flags) trace_exit(ply, score, flags)
+# define GOMOKU_TRACE_ROOT(move, score) (trace_open[0].move = static_cast<int16_t>(move), trace_exit(0, score, TRACE_ROOT))
+#else
+# define GOMOKU_TRACE_ENTER(ply, x, y, alpha, beta) ((void)0)
+# define GOMOKU_TRACE_EXIT(ply, score, flags) ((void)0)
+# define GOMOKU_TRACE_ROOT(move, score) ((void)0)
+#endif
+
+static_assert(std::is_trivially_copyable<BoardState<BOARD_SIZE>>::value, "BoardState is copied as plain data");
+
+template<int N, class Rules>
+BasicBoard<N, Rules>::BasicBoard()
 {
     reset();
 }
 
-bool Board::place_stone_on_board(int8_t x, int8_t y, bool is_black, uint8_t *captures)
+template<int N, class Rules>
+void BasicBoard<N, Rules>::set_state(const State &state)
+{
+    static_cast<State &>(*this) = state;
+    maps_dirty = threats_dirty = true;
+}
+
+template<int N, class Rules>
+bool BasicBoard<N, Rules>::place_stone_on_board(int8_t x, int8_t y, bool is_black, uint8_t *captures)
+{
+    if (!is_legal_move(x, y, is_black))
+        return (false);
+    put_stone_on_board(x, y, is_black, captures);
+    return (true);
+}
+
+// Double three and moving into a capture as far as Rules forbid them, the cell itself is not checked
+template<int N, class Rules>
+bool BasicBoard<N, Rules>::is_legal_move(int8_t x, int8_t y, bool is_black) const
+{
+    if (Rules::double_three(is_black) && is_double_three(x, y, is_black))
+        return (false);
+    if (Rules::captures && is_into_capture(x, y, is_black))
+        return (false);
+    return (true);
+}
+
+template<int N, class Rules>
+bool BasicBoard<N, Rules>::is_double_three(int8_t x, int8_t y, bool is_black) const
 {
     int32_t open_three_count{0};
     bool v{false}, h{false}, dl{false}, dr{false};
     if (is_black)
     {
-        if (y-2 >= 0 && y+2 < BOARD_SIZE && x-2 >= 0 && x+2 < BOARD_SIZE)
+        if (y-2 >= 0 && y+2 < N && x-2 >= 0 && x+2 < N)
         {
-            if (!(black_board[y-2] & (0x40000 >> x)) && !(white_board[y-2] & (0x40000 >> x))
-                    && !(black_board[y+2] & (0x40000 >> x)) && !(white_board[y+2] & (0x40000 >> x))
-                    && black_board[y-1] & black_board[y+1] & (0x40000 >> x))
+            if (!(black_board[y-2] & (TOP >> x)) && !(white_board[y-2] & (TOP >> x))
+                    && !(black_board[y+2] & (TOP >> x)) && !(white_board[y+2] & (TOP >> x))
+                    && black_board[y-1] & black_board[y+1] & (TOP >> x))
                 if (++open_three_count >= 2)
-                    return (false);
-            if (!(black_board[y] & (0x40000 >> (x-2))) && !(white_board[y] & (0x40000 >> (x-2)))
-                    && !(black_board[y] & (0x40000 >> (x+2))) && !(white_board[y] & (0x40000 >> (x+2)))
-                    && (black_board[y] >> 1) & (black_board[y] << 1) & (0x40000 >> x))
+                    return (true);
+            if (!(black_board[y] & (TOP >> (x-2))) && !(white_board[y] & (TOP >> (x-2)))
+                    && !(black_board[y] & (TOP >> (x+2))) && !(white_board[y] & (TOP >> (x+2)))
+                    && (black_board[y] >> 1) & (black_board[y] << 1) & (TOP >> x))
                 if (++open_three_count >= 2)
-                    return (false);
-            if (!(black_board[y-2] & (0x40000 >> (x-2))) && !(white_board[y-2] & (0x40000 >> (x-2)))
-                    && !(black_board[y+2] & (0x40000 >> (x+2))) && !(white_board[y+2] & (0x40000 >> (x+2)))
-                    && (black_board[y-1] >> 1) & (black_board[y+1] << 1) & (0x40000 >> x))
+                    return (true);
+            if (!(black_board[y-2] & (TOP >> (x-2))) && !(white_board[y-2] & (TOP >> (x-2)))
+                    && !(black_board[y+2] & (TOP >> (x+2))) && !(white_board[y+2] & (TOP >> (x+2)))
+                    && (black_board[y-1] >> 1) & (black_board[y+1] << 1) & (TOP >> x))
                 if (++open_three_count >= 2)
-                    return (false);
-            if (!(black_board[y-2] & (0x40000 >> (x+2))) && !(white_board[y-2] & (0x40000 >> (x+2)))
-                    && !(black_board[y+2] & (0x40000 >> (x-2))) && !(white_board[y+2] & (0x40000 >> (x-2)))
-                    && (black_board[y-1] << 1) & (black_board[y+1] >> 1) & (0x40000 >> x))
+                    return (true);
+            if (!(black_board[y-2] & (TOP >> (x+2))) && !(white_board[y-2] & (TOP >> (x+2)))
+                    && !(black_board[y+2] & (TOP >> (x-2))) && !(white_board[y+2] & (TOP >> (x-2)))
+                    && (black_board[y-1] << 1) & (black_board[y+1] >> 1) & (TOP >> x))
                 if (++open_three_count >= 2)
-                    return (false);
+                    return (true);
         }
-        if (y-3 >= 0 && !(black_board[y-3] & (0x40000 >> x)) && !(white_board[y-3] & (0x40000 >> x))
-                && black_board[y-2] & black_board[y-1] & (0x40000 >> x))
+        if (y-3 >= 0 && !(black_board[y-3] & (TOP >> x)) && !(white_board[y-3] & (TOP >> x))
+                && black_board[y-2] & black_board[y-1] & (TOP >> x))
         {
             if (++open_three_count >= 2)
-                return (false);
+                return (true);
             v = true;
         }
-        if (y-3 >= 0 && x+3 < BOARD_SIZE && !(black_board[y-3] & (0x40000 >> (x+3))) && !(white_board[y-3] & (0x40000 >> (x+3)))
-                && (black_board[y-2] << 2) & (black_board[y-1] << 1) & (0x40000 >> x))
+        if (y-3 >= 0 && x+3 < N && !(black_board[y-3] & (TOP >> (x+3))) && !(white_board[y-3] & (TOP >> (x+3)))
+                && (black_board[y-2] << 2) & (black_board[y-1] << 1) & (TOP >> x))
         {
             if (++open_three_count >= 2)
-                return (false);
+                return (true);
             dr = true;
         }
-        if (x+3 < BOARD_SIZE && !(black_board[y] & (0x40000 >> (x+3))) && !(white_board[y] & (0x40000 >> (x+3)))
-                && (black_board[y] << 2) & (black_board[y] << 1) & (0x40000 >> x))
+        if (x+3 < N && !(black_board[y] & (TOP >> (x+3))) && !(white_board[y] & (TOP >> (x+3)))
+                && (black_board[y] << 2) & (black_board[y] << 1) & (TOP >> x))
         {
             if (++open_three_count >= 2)
-                return (false);
+                return (true);
             h = true;
         }
-        if (y+3 < BOARD_SIZE && x+3 < BOARD_SIZE && !(black_board[y+3] & (0x40000 >> (x+3))) && !(white_board[y+3] & (0x40000 >> (x+3)))
-                && (black_board[y+2] << 2) & (black_board[y+1] << 1) & (0x40000 >> x))
+        if (y+3 < N && x+3 < N && !(black_board[y+3] & (TOP >> (x+3))) && !(white_board[y+3] & (TOP >> (x+3)))
+                && (black_board[y+2] << 2) & (black_board[y+1] << 1) & (TOP >> x))
         {
             if (++open_three_count >= 2)
-                return (false);
+                return (true);
             dl = true;
         }
-        if (y+3 < BOARD_SIZE && !(black_board[y+3] & (0x40000 >> x)) && !(white_board[y+3] & (0x40000 >> x))
-                && black_board[y+2] & black_board[y+1] & (0x40000 >> x))
+        if (y+3 < N && !(black_board[y+3] & (TOP >> x)) && !(white_board[y+3] & (TOP >> x))
+                && black_board[y+2] & black_board[y+1] & (TOP >> x))
             if (!v && ++open_three_count >= 2)
-                return (false);
-        if (y+3 < BOARD_SIZE && x-3 >= 0 && !(black_board[y+3] & (0x40000 >> (x-3))) && !(white_board[y+3] & (0x40000 >> (x-3)))
-                && (black_board[y+2] >> 2) & (black_board[y+1] >> 1) & (0x40000 >> x))
+                return (true);
+        if (y+3 < N && x-3 >= 0 && !(black_board[y+3] & (TOP >> (x-3))) && !(white_board[y+3] & (TOP >> (x-3)))
+                && (black_board[y+2] >> 2) & (black_board[y+1] >> 1) & (TOP >> x))
             if (!dr && ++open_three_count >= 2)
-                return (false);
-        if (x-3 >= 0  && !(black_board[y] & (0x40000 >> (x-3))) && !(white_board[y] & (0x40000 >> (x-3)))
-                && (black_board[y] >> 2) & (black_board[y] >> 1) & (0x40000 >> x))
+                return (true);
+        if (x-3 >= 0  && !(black_board[y] & (TOP >> (x-3))) && !(white_board[y] & (TOP >> (x-3)))
+                && (black_board[y] >> 2) & (black_board[y] >> 1) & (TOP >> x))
             if (!h && ++open_three_count >= 2)
-                return (false);
-        if (y-3 >= 0 && x-3 >= 0 && !(black_board[y-3] & (0x40000 >> (x-3))) && !(white_board[y-3] & (0x40000 >> (x-3)))
-                && (black_board[y-2] >> 2) & (black_board[y-1] >> 1) & (0x40000 >> x))
+                return (true);
+        if (y-3 >= 0 && x-3 >= 0 && !(black_board[y-3] & (TOP >> (x-3))) && !(white_board[y-3] & (TOP >> (x-3)))
+                && (black_board[y-2] >> 2) & (black_board[y-1] >> 1) & (TOP >> x))
             if (!dl && ++open_three_count >= 2)
-                return (false);
-
-        if (y+1 < BOARD_SIZE && y-2 >= 0
-                && (white_board[y-2] & black_board[y-1] & white_board[y+1] & (0x40000 >> x)))
-            return (false);
-        if (y+1 < BOARD_SIZE && y-2 >= 0 && x+2 < BOARD_SIZE && x-1 >= 0
-                && ((white_board [y-2] << 2) & (black_board[y-1] << 1) & (white_board [y+1] >> 1) & (0x40000 >> x)))
-            return (false);
-        if (x+2 < BOARD_SIZE && x-1 >= 0
-                && ((white_board[y] << 2) & (black_board[y] << 1) & (white_board[y] >> 1) & (0x40000 >> x)))
-            return (false);
-        if (y+2 < BOARD_SIZE && y-1 >= 0 && x+2 < BOARD_SIZE && x-1 >= 0
-                && ((white_board[y+2] << 2) & (black_board[y+1] << 1) & (white_board[y-1] >> 1) & (0x40000 >> x)))
-            return (false);
-        if (y+2 < BOARD_SIZE && y-1 >= 0
-                && (white_board[y+2] & black_board[y+1] & white_board[y-1] & (0x40000 >> x)))
-            return (false);
-        if (y+2 < BOARD_SIZE && y-1 >= 0 && x+1 < BOARD_SIZE && x-2 >= 0
-                && ((white_board[y+2] >> 2) & (black_board[y+1] >> 1) & (white_board[y-1] << 1) & (0x40000 >> x)))
-            return (false);
-        if (x+1 < BOARD_SIZE && x-2 >= 0
-                && ((white_board[y] >> 2) & (black_board[y] >> 1) & (white_board[y] << 1) & (0x40000 >> x)))
-            return (false);
-        if (y+1 < BOARD_SIZE && y-2 >= 0 && x+1 < BOARD_SIZE && x-2 >= 0
-                && ((white_board[y-2] >> 2) & (black_board[y-1] >> 1) & (white_board[y+1] << 1) & (0x40000 >> x)))
-            return (false);
-        setToken(x, y, is_black ? BLACK : WHITE);
-        black_board[y] |= 0x40000 >> x;
-        hash ^= zobrist_table[y * BOARD_SIZE + x];
-        if (captures)
-        {
-            if (y-3 >= 0 && (black_board[y-3] & white_board[y-2] & white_board[y-1] & (0x40000 >> x)))
-                remove_stone_from_board(x,y-1,false), remove_stone_from_board(x,y-2,false), *captures |= 0x1, ++black_captures_count;
-            if (y-3 >= 0 && x+3 < BOARD_SIZE && ((black_board[y-3] << 3) & (white_board[y-2] << 2) & (white_board[y-1] << 1) & (0x40000 >> x)))
-                remove_stone_from_board(x+1,y-1,false), remove_stone_from_board(x+2,y-2,false), *captures |= 0x2, ++black_captures_count;
-            if (x+3 < BOARD_SIZE && ((black_board[y] << 3) & (white_board[y] << 2) & (white_board[y] << 1) & (0x40000 >> x)))
-                remove_stone_from_board(x+1,y,false), remove_stone_from_board(x+2,y,false), *captures |= 0x4, ++black_captures_count;
-            if (y+3 < BOARD_SIZE && x+3 < BOARD_SIZE && ((black_board[y+3] << 3) & (white_board[y+2] << 2) & (white_board[y+1] << 1) & (0x40000 >> x)))
-                remove_stone_from_board(x+1,y+1,false), remove_stone_from_board(x+2,y+2,false), *captures |= 0x8, ++black_captures_count;
-            if (y+3 < BOARD_SIZE && (black_board[y+3] & white_board[y+2] & white_board[y+1] & (0x40000 >> x)))
-                remove_stone_from_board(x,y+1,false), remove_stone_from_board(x,y+2,false), *captures |= 0x10, ++black_captures_count;
-            if (y+3 < BOARD_SIZE && x-3 >= 0 && ((black_board[y+3] >> 3) & (white_board[y+2] >> 2) & (white_board[y+1] >> 1) & (0x40000 >> x)))
-                remove_stone_from_board(x-1,y+1,false), remove_stone_from_board(x-2,y+2,false), *captures |= 0x20, ++black_captures_count;
-            if (x-3 >= 0 && ((black_board[y] >> 3) & (white_board[y] >> 2) & (white_board[y] >> 1) & (0x40000 >> x)))
-                remove_stone_from_board(x-1,y,false), remove_stone_from_board(x-2,y,false), *captures |= 0x40, ++black_captures_count;
-            if (y-3 >= 0 && x-3 >= 0 && ((black_board[y-3] >> 3) & (white_board[y-2] >> 2) & (white_board[y-1] >> 1) & (0x40000 >> x)))
-                remove_stone_from_board(x-1,y-1,false), remove_stone_from_board(x-2,y-2,false), *captures |= 0x80, ++black_captures_count;
-        }
+                return (true);
     }
     else
     {
-        if (y-2 >= 0 && y+2 < BOARD_SIZE && x-2 >= 0 && x+2 < BOARD_SIZE)
+        if (y-2 >= 0 && y+2 < N && x-2 >= 0 && x+2 < N)
         {
-            if (!(black_board[y-2] & (0x40000 >> x)) && !(white_board[y-2] & (0x40000 >> x))
-                    && !(black_board[y+2] & (0x40000 >> x)) && !(white_board[y+2] & (0x40000 >> x))
-                    && white_board[y-1] & white_board[y+1] & (0x40000 >> x))
+            if (!(black_board[y-2] & (TOP >> x)) && !(white_board[y-2] & (TOP >> x))
+                    && !(black_board[y+2] & (TOP >> x)) && !(white_board[y+2] & (TOP >> x))
+                    && white_board[y-1] & white_board[y+1] & (TOP >> x))
                 if (++open_three_count >= 2)
-                    return (false);
-            if (!(black_board[y] & (0x40000 >> (x-2))) && !(white_board[y] & (0x40000 >> (x-2)))
-                    && !(black_board[y] & (0x40000 >> (x+2))) && !(white_board[y] & (0x40000 >> (x+2)))
-                    && (white_board[y] >> 1) & (white_board[y] << 1) & (0x40000 >> x))
+                    return (true);
+            if (!(black_board[y] & (TOP >> (x-2))) && !(white_board[y] & (TOP >> (x-2)))
+                    && !(black_board[y] & (TOP >> (x+2))) && !(white_board[y] & (TOP >> (x+2)))
+                    && (white_board[y] >> 1) & (white_board[y] << 1) & (TOP >> x))
                 if (++open_three_count >= 2)
-                    return (false);
-            if (!(black_board[y-2] & (0x40000 >> (x-2))) && !(white_board[y-2] & (0x40000 >> (x-2)))
-                    && !(black_board[y+2] & (0x40000 >> (x+2))) && !(white_board[y+2] & (0x40000 >> (x+2)))
-                    && (white_board[y-1] >> 1) & (white_board[y+1] << 1) & (0x40000 >> x))
+                    return (true);
+            if (!(black_board[y-2] & (TOP >> (x-2))) && !(white_board[y-2] & (TOP >> (x-2)))
+                    && !(black_board[y+2] & (TOP >> (x+2))) && !(white_board[y+2] & (TOP >> (x+2)))
+                    && (white_board[y-1] >> 1) & (white_board[y+1] << 1) & (TOP >> x))
                 if (++open_three_count >= 2)
-                    return (false);
-            if (!(black_board[y-2] & (0x40000 >> (x+2))) && !(white_board[y-2] & (0x40000 >> (x+2)))
-                    && !(black_board[y+2] & (0x40000 >> (x-2))) && !(white_board[y+2] & (0x40000 >> (x-2)))
-                    && (white_board[y-1] << 1) & (white_board[y+1] >> 1) & (0x40000 >> x))
+                    return (true);
+            if (!(black_board[y-2] & (TOP >> (x+2))) && !(white_board[y-2] & (TOP >> (x+2)))
+                    && !(black_board[y+2] & (TOP >> (x-2))) && !(white_board[y+2] & (TOP >> (x-2)))
+                    && (white_board[y-1] << 1) & (white_board[y+1] >> 1) & (TOP >> x))
                 if (++open_three_count >= 2)
-                    return (false);
+                    return (true);
         }
-        if (y-3 >= 0 && !(black_board[y-3] & (0x40000 >> x)) && !(white_board[y-3] & (0x40000 >> x))
-                && white_board[y-2] & white_board[y-1] & (0x40000 >> x))
+        if (y-3 >= 0 && !(black_board[y-3] & (TOP >> x)) && !(white_board[y-3] & (TOP >> x))
+                && white_board[y-2] & white_board[y-1] & (TOP >> x))
         {
             if (++open_three_count >= 2)
-                return (false);
+                return (true);
             v = true;
         }
-        if (y-3 >= 0 && x+3 < BOARD_SIZE && !(black_board[y-3] & (0x40000 >> (x+3))) && !(white_board[y-3] & (0x40000 >> (x+3)))
-                && (white_board[y-2] << 2) & (white_board[y-1] << 1) & (0x40000 >> x))
+        if (y-3 >= 0 && x+3 < N && !(black_board[y-3] & (TOP >> (x+3))) && !(white_board[y-3] & (TOP >> (x+3)))
+                && (white_board[y-2] << 2) & (white_board[y-1] << 1) & (TOP >> x))
         {
             if (++open_three_count >= 2)
-                return (false);
+                return (true);
             dr = true;
         }
-        if (x+3 < BOARD_SIZE && !(black_board[y] & (0x40000 >> (x+3))) && !(white_board[y] & (0x40000 >> (x+3)))
-                && (white_board[y] << 2) & (white_board[y] << 1) & (0x40000 >> x))
+        if (x+3 < N && !(black_board[y] & (TOP >> (x+3))) && !(white_board[y] & (TOP >> (x+3)))
+                && (white_board[y] << 2) & (white_board[y] << 1) & (TOP >> x))
         {
             if (++open_three_count >= 2)
-                return (false);
+                return (true);
             h = true;
         }
-        if (y+3 < BOARD_SIZE && x+3 < BOARD_SIZE && !(black_board[y+3] & (0x40000 >> (x+3))) && !(white_board[y+3] & (0x40000 >> (x+3)))
-                && (white_board[y+2] << 2) & (white_board[y+1] << 1) & (0x40000 >> x))
+        if (y+3 < N && x+3 < N && !(black_board[y+3] & (TOP >> (x+3))) && !(white_board[y+3] & (TOP >> (x+3)))
+                && (white_board[y+2] << 2) & (white_board[y+1] << 1) & (TOP >> x))
         {
             if (++open_three_count >= 2)
-                return (false);
+                return (true);
             dl = true;
         }
-        if (y+3 < BOARD_SIZE && !(black_board[y+3] & (0x40000 >> x)) && !(white_board[y+3] & (0x40000 >> x))
-                && white_board[y+2] & white_board[y+1] & (0x40000 >> x))
+        if (y+3 < N && !(black_board[y+3] & (TOP >> x)) && !(white_board[y+3] & (TOP >> x))
+                && white_board[y+2] & white_board[y+1] & (TOP >> x))
             if (!v && ++open_three_count >= 2)
-                return (false);
-        if (y+3 < BOARD_SIZE && x-3 >= 0 && !(black_board[y+3] & (0x40000 >> (x-3))) && !(white_board[y+3] & (0x40000 >> (x-3)))
-                && (white_board[y+2] >> 2) & (white_board[y+1] >> 1) & (0x40000 >> x))
+                return (true);
+        if (y+3 < N && x-3 >= 0 && !(black_board[y+3] & (TOP >> (x-3))) && !(white_board[y+3] & (TOP >> (x-3)))
+                && (white_board[y+2] >> 2) & (white_board[y+1] >> 1) & (TOP >> x))
             if (!dr && ++open_three_count >= 2)
-                return (false);
-        if (x-3 >= 0  && !(black_board[y] & (0x40000 >> (x-3))) && !(white_board[y] & (0x40000 >> (x-3)))
-                && (white_board[y] >> 2) & (white_board[y] >> 1) & (0x40000 >> x))
+                return (true);
+        if (x-3 >= 0  && !(black_board[y] & (TOP >> (x-3))) && !(white_board[y] & (TOP >> (x-3)))
+                && (white_board[y] >> 2) & (white_board[y] >> 1) & (TOP >> x))
             if (!h && ++open_three_count >= 2)
-                return (false);
-        if (y-3 >= 0 && x-3 >= 0 && !(black_board[y-3] & (0x40000 >> (x-3))) && !(white_board[y-3] & (0x40000 >> (x-3)))
-                && (white_board[y-2] >> 2) & (white_board[y-1] >> 1) & (0x40000 >> x))
+                return (true);
+        if (y-3 >= 0 && x-3 >= 0 && !(black_board[y-3] & (TOP >> (x-3))) && !(white_board[y-3] & (TOP >> (x-3)))
+                && (white_board[y-2] >> 2) & (white_board[y-1] >> 1) & (TOP >> x))
             if (!dl && ++open_three_count >= 2)
-                return (false);
-
-        if (y+1 < BOARD_SIZE && y-2 >= 0
-                && (black_board[y-2] & white_board[y-1] & black_board[y+1] & (0x40000 >> x)))
-            return (false);
-        if (y+1 < BOARD_SIZE && y-2 >= 0 && x+2 < BOARD_SIZE && x-1 >= 0
-                && ((black_board [y-2] << 2) & (white_board[y-1] << 1) & (black_board [y+1] >> 1) & (0x40000 >> x)))
-            return (false);
-        if (x+2 < BOARD_SIZE && x-1 >= 0
-                && ((black_board[y] << 2) & (white_board[y] << 1) & (black_board[y] >> 1) & (0x40000 >> x)))
-            return (false);
-        if (y+2 < BOARD_SIZE && y-1 >= 0 && x+2 < BOARD_SIZE && x-1 >= 0
-                && ((black_board[y+2] << 2) & (white_board[y+1] << 1) & (black_board[y-1] >> 1) & (0x40000 >> x)))
-            return (false);
-        if (y+2 < BOARD_SIZE && y-1 >= 0
-                && (black_board[y+2] & white_board[y+1] & black_board[y-1] & (0x40000 >> x)))
-            return (false);
-        if (y+2 < BOARD_SIZE && y-1 >= 0 && x+1 < BOARD_SIZE && x-2 >= 0
-                && ((black_board[y+2] >> 2) & (white_board[y+1] >> 1) & (black_board[y-1] << 1) & (0x40000 >> x)))
-            return (false);
-        if (x+1 < BOARD_SIZE && x-2 >= 0
-                && ((black_board[y] >> 2) & (white_board[y] >> 1) & (black_board[y] << 1) & (0x40000 >> x)))
-            return (false);
-        if (y+1 < BOARD_SIZE && y-2 >= 0 && x+1 < BOARD_SIZE && x-2 >= 0
-                && ((black_board[y-2] >> 2) & (white_board[y-1] >> 1) & (black_board[y+1] << 1) & (0x40000 >> x)))
-            return (false);
+                return (true);
+    }
+    return (false);
+}
+
+// opp own [new] opp, the new stone would be captured right away
+template<int N, class Rules>
+bool BasicBoard<N, Rules>::is_into_capture(int8_t x, int8_t y, bool is_black) const
+{
+    if (is_black)
+    {
+        if (y+1 < N && y-2 >= 0
+                && (white_board[y-2] & black_board[y-1] & white_board[y+1] & (TOP >> x)))
+            return (true);
+        if (y+1 < N && y-2 >= 0 && x+2 < N && x-1 >= 0
+                && ((white_board [y-2] << 2) & (black_board[y-1] << 1) & (white_board [y+1] >> 1) & (TOP >> x)))
+            return (true);
+        if (x+2 < N && x-1 >= 0
+                && ((white_board[y] << 2) & (black_board[y] << 1) & (white_board[y] >> 1) & (TOP >> x)))
+            return (true);
+        if (y+2 < N && y-1 >= 0 && x+2 < N && x-1 >= 0
+                && ((white_board[y+2] << 2) & (black_board[y+1] << 1) & (white_board[y-1] >> 1) & (TOP >> x)))
+            return (true);
+        if (y+2 < N && y-1 >= 0
+                && (white_board[y+2] & black_board[y+1] & white_board[y-1] & (TOP >> x)))
+            return (true);
+        if (y+2 < N && y-1 >= 0 && x+1 < N && x-2 >= 0
+                && ((white_board[y+2] >> 2) & (black_board[y+1] >> 1) & (white_board[y-1] << 1) & (TOP >> x)))
+            return (true);
+        if (x+1 < N && x-2 >= 0
+                && ((white_board[y] >> 2) & (black_board[y] >> 1) & (white_board[y] << 1) & (TOP >> x)))
+            return (true);
+        if (y+1 < N && y-2 >= 0 && x+1 < N && x-2 >= 0
+                && ((white_board[y-2] >> 2) & (black_board[y-1] >> 1) & (white_board[y+1] << 1) & (TOP >> x)))
+            return (true);
+    }
+    else
+    {
+        if (y+1 < N && y-2 >= 0
+                && (black_board[y-2] & white_board[y-1] & black_board[y+1] & (TOP >> x)))
+            return (true);
+        if (y+1 < N && y-2 >= 0 && x+2 < N && x-1 >= 0
+                && ((black_board [y-2] << 2) & (white_board[y-1] << 1) & (black_board [y+1] >> 1) & (TOP >> x)))
+            return (true);
+        if (x+2 < N && x-1 >= 0
+                && ((black_board[y] << 2) & (white_board[y] << 1) & (black_board[y] >> 1) & (TOP >> x)))
+            return (true);
+        if (y+2 < N && y-1 >= 0 && x+2 < N && x-1 >= 0
+                && ((black_board[y+2] << 2) & (white_board[y+1] << 1) & (black_board[y-1] >> 1) & (TOP >> x)))
+            return (true);
+        if (y+2 < N && y-1 >= 0
+                && (black_board[y+2] & white_board[y+1] & black_board[y-1] & (TOP >> x)))
+            return (true);
+        if (y+2 < N && y-1 >= 0 && x+1 < N && x-2 >= 0
+                && ((black_board[y+2] >> 2) & (white_board[y+1] >> 1) & (black_board[y-1] << 1) & (TOP >> x)))
+            return (true);
+        if (x+1 < N && x-2 >= 0
+                && ((black_board[y] >> 2) & (white_board[y] >> 1) & (black_board[y] << 1) & (TOP >> x)))
+            return (true);
+        if (y+1 < N && y-2 >= 0 && x+1 < N && x-2 >= 0
+                && ((black_board[y-2] >> 2) & (white_board[y-1] >> 1) & (black_board[y+1] << 1) & (TOP >> x)))
+            return (true);
+    }
+    return (false);
+}
+
+// Places the stone without legality checks, captures when captures is given
+template<int N, class Rules>
+void BasicBoard<N, Rules>::put_stone_on_board(int8_t x, int8_t y, bool is_black, uint8_t *captures)
+{
+    if (is_black)
+    {
+        setToken(x, y, is_black ? BLACK : WHITE);
+        black_board[y] |= TOP >> x;
+        hash ^= zobrist_table[y * N + x];
+        if (Rules::captures && captures)
+        {
+            if (y-3 >= 0 && (black_board[y-3] & white_board[y-2] & white_board[y-1] & (TOP >> x)))
+                remove_stone_from_board(x,y-1,false), remove_stone_from_board(x,y-2,false), *captures |= 0x1, ++black_captures_count;
+            if (y-3 >= 0 && x+3 < N && ((black_board[y-3] << 3) & (white_board[y-2] << 2) & (white_board[y-1] << 1) & (TOP >> x)))
+                remove_stone_from_board(x+1,y-1,false), remove_stone_from_board(x+2,y-2,false), *captures |= 0x2, ++black_captures_count;
+            if (x+3 < N && ((black_board[y] << 3) & (white_board[y] << 2) & (white_board[y] << 1) & (TOP >> x)))
+                remove_stone_from_board(x+1,y,false), remove_stone_from_board(x+2,y,false), *captures |= 0x4, ++black_captures_count;
+            if (y+3 < N && x+3 < N && ((black_board[y+3] << 3) & (white_board[y+2] << 2) & (white_board[y+1] << 1) & (TOP >> x)))
+                remove_stone_from_board(x+1,y+1,false), remove_stone_from_board(x+2,y+2,false), *captures |= 0x8, ++black_captures_count;
+            if (y+3 < N && (black_board[y+3] & white_board[y+2] & white_board[y+1] & (TOP >> x)))
+                remove_stone_from_board(x,y+1,false), remove_stone_from_board(x,y+2,false), *captures |= 0x10, ++black_captures_count;
+            if (y+3 < N && x-3 >= 0 && ((black_board[y+3] >> 3) & (white_board[y+2] >> 2) & (white_board[y+1] >> 1) & (TOP >> x)))
+                remove_stone_from_board(x-1,y+1,false), remove_stone_from_board(x-2,y+2,false), *captures |= 0x20, ++black_captures_count;
+            if (x-3 >= 0 && ((black_board[y] >> 3) & (white_board[y] >> 2) & (white_board[y] >> 1) & (TOP >> x)))
+                remove_stone_from_board(x-1,y,false), remove_stone_from_board(x-2,y,false), *captures |= 0x40, ++black_captures_count;
+            if (y-3 >= 0 && x-3 >= 0 && ((black_board[y-3] >> 3) & (white_board[y-2] >> 2) & (white_board[y-1] >> 1) & (TOP >> x)))
+                remove_stone_from_board(x-1,y-1,false), remove_stone_from_board(x-2,y-2,false), *captures |= 0x80, ++black_captures_count;
+        }
+    }
+    else
+    {
         setToken(x, y, is_black ? BLACK : WHITE);
-        white_board[y] |= 0x40000 >> x;
-        hash ^= zobrist_table[(2 + y) * BOARD_SIZE + x];
-        if (captures)
+        white_board[y] |= TOP >> x;
+        hash ^= zobrist_table[N * N + y * N + x];
+        if (Rules::captures && captures)
         {
-            if (y-3 >= 0 && (white_board[y-3] & black_board[y-2] & black_board[y-1] & (0x40000 >> x)))
+            if (y-3 >= 0 && (white_board[y-3] & black_board[y-2] & black_board[y-1] & (TOP >> x)))
                 remove_stone_from_board(x,y-1,true), remove_stone_from_board(x,y-2,true), *captures |= 0x1, ++white_captures_count;
-            if (y-3 >= 0 && x+3 < BOARD_SIZE && ((white_board[y-3] << 3) & (black_board[y-2] << 2) & (black_board[y-1] << 1) & (0x40000 >> x)))
+            if (y-3 >= 0 && x+3 < N && ((white_board[y-3] << 3) & (black_board[y-2] << 2) & (black_board[y-1] << 1) & (TOP >> x)))
                 remove_stone_from_board(x+1,y-1,true), remove_stone_from_board(x+2,y-2,true), *captures |= 0x2, ++white_captures_count;
-            if (x+3 < BOARD_SIZE && ((white_board[y] << 3) & (black_board[y] << 2) & (black_board[y] << 1) & (0x40000 >> x)))
+            if (x+3 < N && ((white_board[y] << 3) & (black_board[y] << 2) & (black_board[y] << 1) & (TOP >> x)))
                 remove_stone_from_board(x+1,y,true), remove_stone_from_board(x+2,y,true), *captures |= 0x4, ++white_captures_count;
-            if (y+3 < BOARD_SIZE && x+3 < BOARD_SIZE && ((white_board[y+3] << 3) & (black_board[y+2] << 2) & (black_board[y+1] << 1) & (0x40000 >> x)))
+            if (y+3 < N && x+3 < N && ((white_board[y+3] << 3) & (black_board[y+2] << 2) & (black_board[y+1] << 1) & (TOP >> x)))
                 remove_stone_from_board(x+1,y+1,true), remove_stone_from_board(x+2,y+2,true), *captures |= 0x8, ++white_captures_count;
-            if (y+3 < BOARD_SIZE && (white_board[y+3] & black_board[y+2] & black_board[y+1] & (0x40000 >> x)))
+            if (y+3 < N && (white_board[y+3] & black_board[y+2] & black_board[y+1] & (TOP >> x)))
                 remove_stone_from_board(x,y+1,true), remove_stone_from_board(x,y+2,true), *captures |= 0x10, ++white_captures_count;
-            if (y+3 < BOARD_SIZE && x-3 >= 0 && ((white_board[y+3] >> 3) & (black_board[y+2] >> 2) & (black_board[y+1] >> 1) & (0x40000 >> x)))
+            if (y+3 < N && x-3 >= 0 && ((white_board[y+3] >> 3) & (black_board[y+2] >> 2) & (black_board[y+1] >> 1) & (TOP >> x)))
                 remove_stone_from_board(x-1,y+1,true), remove_stone_from_board(x-2,y+2,true), *captures |= 0x20, ++white_captures_count;
-            if (x-3 >= 0 && ((white_board[y] >> 3) & (black_board[y] >> 2) & (black_board[y] >> 1) & (0x40000 >> x)))
+            if (x-3 >= 0 && ((white_board[y] >> 3) & (black_board[y] >> 2) & (black_board[y] >> 1) & (TOP >> x)))
                 remove_stone_from_board(x-1,y,true), remove_stone_from_board(x-2,y,true), *captures |= 0x40, ++white_captures_count;
-            if (y-3 >= 0 && x-3 >= 0 && ((white_board[y-3] >> 3) & (black_board[y-2] >> 2) & (black_board[y-1] >> 1) & (0x40000 >> x)))
+            if (y-3 >= 0 && x-3 >= 0 && ((white_board[y-3] >> 3) & (black_board[y-2] >> 2) & (black_board[y-1] >> 1) & (TOP >> x)))
                 remove_stone_from_board(x-1,y-1,true), remove_stone_from_board(x-2,y-2,true), *captures |= 0x80, ++white_captures_count;
         }
     }
     if (y-1 >= 0)
-        ++move_map[(y-1) * BOARD_SIZE + x];
-    if (y-1 >= 0 && x+1 < BOARD_SIZE)
-        ++move_map[(y-1) * BOARD_SIZE + (x+1)];
-    if (x+1 < BOARD_SIZE)
-        ++move_map[y * BOARD_SIZE + (x+1)];
-    if (y+1 < BOARD_SIZE && x+1 < BOARD_SIZE)
-    {
-        ++move_map[(y+1) * BOARD_SIZE + (x+1)];
-        if (y+1 > end_y || x+1 > end_x)
-            end_y = y+1, end_x = x+1;
-        if (x+1 > most_right)
-            most_right = x+1;
-    }
-    if (y+1 < BOARD_SIZE)
-        ++move_map[(y+1) * BOARD_SIZE + x];
-    if (y+1 < BOARD_SIZE && x-1 >= 0)
-        ++move_map[(y+1) * BOARD_SIZE + (x-1)];
+        ++move_map[(y-1) * N + x];
+    if (y-1 >= 0 && x+1 < N)
+        ++move_map[(y-1) * N + (x+1)];
+    if (x+1 < N)
+        ++move_map[y * N + (x+1)];
+    if (y+1 < N && x+1 < N)
+        ++move_map[(y+1) * N + (x+1)];
+    if (y+1 < N)
+        ++move_map[(y+1) * N + x];
+    if (y+1 < N && x-1 >= 0)
+        ++move_map[(y+1) * N + (x-1)];
     if (x-1 >= 0)
-        ++move_map[y * BOARD_SIZE + (x-1)];
+        ++move_map[y * N + (x-1)];
     if (y-1 >= 0 && x-1 >= 0)
-    {
-        ++move_map[(y-1) * BOARD_SIZE + (x-1)];
-        if (y-1 < start_y || x-1 < start_x)
-            start_y = y-1, start_x = x-1;
-        if (x-1 < most_left)
-            most_left = x-1;
-    }
-    return (true);
+        ++move_map[(y-1) * N + (x-1)];
+    // The search box covers the neighbours of every stone placed since the search started, end exclusive
+    start_x = std::min(start_x, std::max(x - 1, 0));
+    start_y = std::min(start_y, std::max(y - 1, 0));
+    end_x = std::max(end_x, std::min(x + 2, N));
+    end_y = std::max(end_y, std::min(y + 2, N));
+    maps_dirty = threats_dirty = true;
 }
 
 
-bool Board::remove_stone_from_board(int8_t x, int8_t y, bool is_black, uint8_t *captures)
+// Takes the stone off without legality checks. With captures, the bits put_stone_on_board reported for it,
+// the captured pairs go back in place the way unmake_move puts them; the search box stays as it is.
+template<int N, class Rules>
+bool BasicBoard<N, Rules>::remove_stone_from_board(int8_t x, int8_t y, bool is_black, uint8_t *captures)
 {
     setToken(x, y, EMPTY);
-    if (is_black)
+    (is_black ? black_board : white_board)[y] &= ~(TOP >> x);
+    hash ^= zobrist_table[(is_black ? 0 : N * N) + y * N + x];
+    add_to_neighbours(x, y, -1);
+    if (captures && *captures)
     {
-        black_board[y] &= ~(0x40000 >> x);
-        hash ^= zobrist_table[y * BOARD_SIZE + x];
-        if (captures)
-        {
-            if (*captures & 0x1)
-                place_stone_on_board(x,y-1,!is_black), place_stone_on_board(x,y-2,!is_black), --black_captures_count;
-            if (*captures & 0x2)
-                place_stone_on_board(x+1,y-1,!is_black), place_stone_on_board(x+2,y-2,!is_black), --black_captures_count;
-            if (*captures & 0x4)
-                place_stone_on_board(x+1,y,!is_black), place_stone_on_board(x+2,y,!is_black), --black_captures_count;
-            if (*captures & 0x8)
-                place_stone_on_board(x+1,y+1,!is_black), place_stone_on_board(x+2,y+2,!is_black), --black_captures_count;
-            if (*captures & 0x10)
-                place_stone_on_board(x,y+1,!is_black), place_stone_on_board(x,y+2,!is_black), --black_captures_count;
-            if (*captures & 0x20)
-                place_stone_on_board(x-1,y+1,!is_black), place_stone_on_board(x-2,y+2,!is_black), --black_captures_count;
-            if (*captures & 0x40)
-                place_stone_on_board(x-1,y,!is_black), place_stone_on_board(x-2,y,!is_black), --black_captures_count;
-            if (*captures & 0x80)
-                place_stone_on_board(x-1,y-1,!is_black), place_stone_on_board(x-2,y-2,!is_black), --black_captures_count;
-        }
-    }
-    else
-    {
-        white_board[y] &= ~(0x40000 >> x);
-        hash ^= zobrist_table[(2 + y) * BOARD_SIZE + x];
-        if (captures)
-        {
-            if (*captures & 0x1)
-                place_stone_on_board(x,y-1,!is_black), place_stone_on_board(x,y-2,!is_black), --white_captures_count;
-            if (*captures & 0x2)
-                place_stone_on_board(x+1,y-1,!is_black), place_stone_on_board(x+2,y-2,!is_black), --white_captures_count;
-            if (*captures & 0x4)
-                place_stone_on_board(x+1,y,!is_black), place_stone_on_board(x+2,y,!is_black), --white_captures_count;
-            if (*captures & 0x8)
-                place_stone_on_board(x+1,y+1,!is_black), place_stone_on_board(x+2,y+2,!is_black), --white_captures_count;
-            if (*captures & 0x10)
-                place_stone_on_board(x,y+1,!is_black), place_stone_on_board(x,y+2,!is_black), --white_captures_count;
-            if (*captures & 0x20)
-                place_stone_on_board(x-1,y+1,!is_black), place_stone_on_board(x-2,y+2,!is_black), --white_captures_count;
-            if (*captures & 0x40)
-                place_stone_on_board(x-1,y,!is_black), place_stone_on_board(x-2,y,!is_black), --white_captures_count;
-            if (*captures & 0x80)
-                place_stone_on_board(x-1,y-1,!is_black), place_stone_on_board(x-2,y-2,!is_black), --white_captures_count;
-        }
+        restore_captured(x, y, is_black, *captures);
+        (is_black ? black_captures_count : white_captures_count) -= __builtin_popcount(*captures);
     }
-    if (y-1 >= 0 && x-1 >= 0)
-        --move_map[(y-1) * BOARD_SIZE + (x-1)];
-    if (x-1 >= 0)
-        --move_map[y * BOARD_SIZE + (x-1)];
-    if (y+1 < BOARD_SIZE && x-1 >= 0)
-        --move_map[(y+1) * BOARD_SIZE + (x-1)];
-    if (y+1 < BOARD_SIZE)
-        --move_map[(y+1) * BOARD_SIZE + x];
-    if (y+1 < BOARD_SIZE && x+1 < BOARD_SIZE)
-        --move_map[(y+1) * BOARD_SIZE + (x+1)];
-    if (x+1 < BOARD_SIZE)
-        --move_map[y * BOARD_SIZE + (x+1)];
-    if (y-1 >= 0 && x+1 < BOARD_SIZE)
-        --move_map[(y-1) * BOARD_SIZE + (x+1)];
-    if (y-1 >= 0)
-        --move_map[(y-1) * BOARD_SIZE + x];
+    maps_dirty = threats_dirty = true;
     return (true);
 }
 
-int32_t Board::minimax(int8_t depth, int32_t alpha, int32_t beta, int8_t x, int8_t y, bool maximizer, bool is_black)
+// The pairs the is_black stone at x, y took, one per capture bit, back on the board
+template<int N, class Rules>
+void BasicBoard<N, Rules>::restore_captured(int8_t x, int8_t y, bool is_black, uint8_t captures)
+{
+    Row *opp = is_black ? white_board : black_board;
+    const uint64_t *keys = zobrist_table + (is_black ? N * N : 0);
+    for (int i = 0; i < 8; ++i)
+        if (captures & 1 << i)
+            for (int k = 1; k <= 2; ++k)
+            {
+                const int8_t cx = x + CAPTURE_DIRS[i][0] * k, cy = y + CAPTURE_DIRS[i][1] * k;
+                setToken(cx, cy, is_black ? WHITE : BLACK);
+                opp[cy] |= TOP >> cx;
+                hash ^= keys[cy * N + cx];
+                add_to_neighbours(cx, cy, 1);
+            }
+}
+
+template<int N, class Rules>
+void BasicBoard<N, Rules>::add_to_neighbours(int8_t x, int8_t y, int32_t delta)
 {
-    ++nodes_count;
+    for (int dy = -1; dy <= 1; ++dy)
+        for (int dx = -1; dx <= 1; ++dx)
+            if ((dx || dy) && x + dx >= 0 && x + dx < N && y + dy >= 0 && y + dy < N)
+                move_map[(y + dy) * N + x + dx] += delta;
+}
+
+template<int N, class Rules>
+void BasicBoard<N, Rules>::make_move(int8_t x, int8_t y, bool is_black, bool captures, UndoRecord &undo)
+{
+    undo.x = x;
+    undo.y = y;
+    undo.is_black = is_black;
+    undo.captures = 0;
+    undo.moveX = moveX;
+    undo.moveY = moveY;
+    undo.move = move;
+    undo.result = result;
+    undo.lastMoveIsCapture = lastMoveIsCapture;
+    undo.hash = hash;
+    undo.black_captures_count = black_captures_count;
+    undo.white_captures_count = white_captures_count;
+    undo.start_x = start_x;
+    undo.start_y = start_y;
+    undo.end_x = end_x;
+    undo.end_y = end_y;
+    put_stone_on_board(x, y, is_black, captures ? &undo.captures : nullptr);
+    lastMoveIsCapture = undo.captures != 0;
+}
+
+// The inverse of make_move cell by cell, the counters and the search box come back from the record
+template<int N, class Rules>
+void BasicBoard<N, Rules>::unmake_move(const UndoRecord &undo)
+{
+    const int8_t x = undo.x, y = undo.y;
+
+    setToken(x, y, EMPTY);
+    (undo.is_black ? black_board : white_board)[y] &= ~(TOP >> x);
+    add_to_neighbours(x, y, -1);
+    if (undo.captures)
+        restore_captured(x, y, undo.is_black, undo.captures);
+
+    moveX = undo.moveX;
+    moveY = undo.moveY;
+    move = undo.move;
+    result = undo.result;
+    lastMoveIsCapture = undo.lastMoveIsCapture;
+    hash = undo.hash;
+    black_captures_count = undo.black_captures_count;
+    white_captures_count = undo.white_captures_count;
+    start_x = undo.start_x;
+    start_y = undo.start_y;
+    end_x = undo.end_x;
+    end_y = undo.end_y;
+    maps_dirty = threats_dirty = true;
+}
+
+template<int N, class Rules>
+int32_t BasicBoard<N, Rules>::minimax(int8_t depth, int32_t alpha, int32_t beta, int8_t x, int8_t y, bool maximizer, bool is_black)
+{
+    const int ply = search_depth - depth + 1;
+    ++stats.nodes;
+    ++stats.plies[ply].nodes;
+    pv_length[ply] = ply;
+    GOMOKU_TRACE_ENTER(ply, x, y, alpha, beta);
     std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now()- startTime;
-    bool five = PtrLocal5Match(is_black ? BLACK : WHITE, x, y);
-    bool winByCapture = is_black ? black_captures_count >= 5 : white_captures_count >= 5;
-    if (depth == 0 || elapsed.count() > 0.49 || five || winByCapture)
+    const bool five = is_five(x, y, is_black);
+    bool winByCapture = Rules::capture_win && (is_black ? black_captures_count >= 5 : white_captures_count >= 5);
+    const bool stopped = elapsed.count() > limits.seconds
+            || (control && control->stop.load(std::memory_order_relaxed));
+    if (depth == 0 || stopped || five || winByCapture)
     {
         auto prevResult = result;
-        move = is_black ? BLACK : WHITE;
+        // Eval reads move as the color to play
+        move = is_black ? WHITE : BLACK;
         moveX = x;
         moveY = y;
-        result = five ? (is_black ? BLACK_WIN : WHITE_WIN) : result;
-        int32_t score;
-        if (hash_map.find(hash) != hash_map.end() && ++cache_hit_count)
-            score = hash_map[hash];
+        result = five || winByCapture ? (is_black ? BLACK_WIN : WHITE_WIN) : result;
+        // Eval's own score, positive for white, so the entries do not depend on the root side
+        const uint64_t key = table_key(hash, move == WHITE, black_captures_count, white_captures_count);
+        int32_t eval{0};
+        bool tt_hit;
+        ++stats.tt_probes;
+        if (table)
+            tt_hit = table->probe(key, eval);
+        else
+        {
+            const auto cached = hash_map.find(key);
+            tt_hit = cached != hash_map.end();
+            if (tt_hit)
+                eval = cached->second;
+        }
+        if (tt_hit)
+            ++stats.tt_hits;
         else
         {
 //            std::clog << *this;
-            score = -Eval(); // WHITE BLACK SWAPPED
-            hash_map[hash] = score;
+            eval = Eval();
+            ++stats.eval_calls;
+            if (table && ++stats.tt_stores)
+                table->store(key, eval);
+            else if (!table && hash_map.size() < hash_map_limit && ++stats.tt_stores)
+                hash_map[key] = eval;
         }
+        int32_t score = root_is_black ? -eval : eval;
+        if (five || winByCapture)
+            score = is_black == root_is_black ? WIN_SCORE - ply : ply - WIN_SCORE;
         result = prevResult;
+        GOMOKU_TRACE_EXIT(ply, score,
+                          (five ? TRACE_FIVE : winByCapture ? TRACE_CAPTURE_WIN : depth == 0 ? TRACE_DEPTH : TRACE_TIME)
+                          | (tt_hit ? TRACE_TT_HIT : 0) | (maximizer ? TRACE_MAXIMIZER : 0));
         return (score);
     }
+    int16_t moves[N * N];
+    int captures_count;
+    const int moves_count = generate_moves(!is_black, moves, &captures_count);
     if (maximizer)
     {
         int32_t max_h = std::numeric_limits<int32_t>::min();
-        for (int32_t y{start_y}; y < end_y; ++y)
-            for (int32_t x{start_x}; x < end_x; ++x)
+        for (int i = 0; i < moves_count; ++i)
+        {
+            const int8_t x = moves[i] & 0xFF, y = moves[i] >> 8;
+            UndoRecord undo;
+            make_move(x, y, !is_black, i < captures_count, undo);
+            const int32_t h = minimax(depth-1, alpha, beta,x,y, false, !is_black);
+            unmake_move(undo);
+
+            if (h > max_h)
+            {
+                max_h = h;
+                update_pv(ply, moves[i]);
+            }
+            alpha = std::max(alpha, max_h);
+            if (beta <= alpha && record_cutoff(ply, i))
             {
-                if (x < most_left)
-                    x = most_left;
-                if (x > most_right)
-                    break;
-                if (move_map[y * BOARD_SIZE + x])
-                    if (!(black_board[y] & (0x40000 >> x)) && !(white_board[y] & (0x40000 >> x)))
-                    {
-                        uint8_t captures{0};
-                        if (place_stone_on_board(x, y, is_black, &captures))
-                        {
-                            auto prevResult = result;
-                            auto prevLastMoveIsCapture = lastMoveIsCapture;
-                            lastMoveIsCapture = (bool)captures;
-
-                            max_h = std::max(max_h, minimax(depth-1, alpha, beta,x,y, false, !is_black));
-                            remove_stone_from_board(x, y, is_black, &captures);
-
-                            result = prevResult;
-                            lastMoveIsCapture = prevLastMoveIsCapture;
-
-                            alpha = std::max(alpha, max_h);
-                            if (beta <= alpha && ++pruned_count)
-                                return (max_h);
-                        }
-                    }
+                GOMOKU_TRACE_EXIT(ply, max_h, TRACE_CUTOFF | TRACE_MAXIMIZER);
+                return (max_h);
             }
+        }
+        GOMOKU_TRACE_EXIT(ply, max_h, TRACE_ALL_MOVES | TRACE_MAXIMIZER);
         return (max_h);
     }
     else
     {
         int32_t min_h = std::numeric_limits<int32_t>::max();
-        for (int32_t y{start_y}; y < end_y; ++y)
-            for (int32_t x{start_x}; x < end_x; ++x)
+        for (int i = 0; i < moves_count; ++i)
+        {
+            const int8_t x = moves[i] & 0xFF, y = moves[i] >> 8;
+            UndoRecord undo;
+            make_move(x, y, !is_black, i < captures_count, undo);
+            const int32_t h = minimax(depth-1, alpha, beta, x, y, true, !is_black);
+            unmake_move(undo);
+
+            if (h < min_h)
+            {
+                min_h = h;
+                update_pv(ply, moves[i]);
+            }
+            beta = std::min(beta, min_h);
+            if (beta <= alpha && record_cutoff(ply, i))
             {
-                if (x < most_left)
-                    x = most_left;
-                if (x > most_right)
-                    break;
-                if (move_map[y * BOARD_SIZE + x])
-                    if (!(black_board[y] & (0x40000 >> x)) && !(white_board[y] & (0x40000 >> x)))
-                    {
-                        uint8_t captures{0};
-                        if (place_stone_on_board(x, y, is_black, &captures))
-                        {
-                            auto prevResult = result;
-                            auto prevLastMoveIsCapture = lastMoveIsCapture;
-                            lastMoveIsCapture = (bool)captures;
-
-                            min_h = std::min(min_h, minimax(depth-1, alpha, beta, true,x,y, !is_black));
-                            remove_stone_from_board(x, y, is_black, &captures);
-
-                            result = prevResult;
-                            lastMoveIsCapture = prevLastMoveIsCapture;
-
-                            beta = std::min(beta, min_h);
-                            if (beta <= alpha && ++pruned_count)
-                                return (min_h);
-                        }
-                    }
+                GOMOKU_TRACE_EXIT(ply, min_h, TRACE_CUTOFF);
+                return (min_h);
             }
+        }
+        GOMOKU_TRACE_EXIT(ply, min_h, TRACE_ALL_MOVES);
         return (min_h);
     }
 }
 
-int32_t Board::ai_move(bool is_black)
+template<int N, class Rules>
+int32_t BasicBoard<N, Rules>::ai_move(bool is_black)
+{
+    return search_root(is_black, 0, nullptr);
+}
+
+template<int N, class Rules>
+std::vector<RootLine> BasicBoard<N, Rules>::analyze(bool is_black, int multi_pv)
+{
+    std::vector<RootLine> lines;
+    search_root(is_black, std::max(multi_pv, 1), &lines);
+    return lines;
+}
+
+// Without multi_pv every root move gets the full window and the last of the best wins, as ai_move always did.
+// With it the root alpha is the score of the multi_pv-th line, so the rest only prove they can not enter.
+template<int N, class Rules>
+int32_t BasicBoard<N, Rules>::search_root(bool is_black, int multi_pv, std::vector<RootLine> *lines)
 {
     int32_t max_h{std::numeric_limits<int32_t>::min()};
     int32_t move{0};
     int32_t h{0};
+    // Leaves set the last move for Eval, the position's own is put back at the end
+    const int prevMove = this->move;
+    const int8_t prevMoveX = moveX, prevMoveY = moveY;
     startTime = std::chrono::high_resolution_clock::now();
+    root_is_black = is_black;
 
-    cache_hit_count = 0;
-    pruned_count = 0;
-    nodes_count = 0;
+    stats = SearchStats();
+    search_depth = std::min(limits.depth, MAX_PLY - 2);
+    stats.plies.resize(search_depth + 2);
+    stats.plies[0].nodes = 1;
+    pv_length[0] = 0;
+    GOMOKU_TRACE_ENTER(0, 0, 0, std::numeric_limits<int32_t>::min(), std::numeric_limits<int32_t>::max());
+    line_cache_hit_count = 0;
+    line_cache_miss_count = 0;
 
     hash = get_hash();
     hash_map.clear();
 
-    start_x = 9;
-    start_y = 9;
-    end_x = 9;
-    end_y = 9;
+    hash_map_limit = std::numeric_limits<uint64_t>::max();
+    line_cache_limit = LINE_CACHE_LIMIT;
+    if (limits.memory)
+    {
+        // A quarter for the line cache, the rest for the transposition table
+        line_cache_limit = std::min<uint64_t>(LINE_CACHE_LIMIT, limits.memory / 4 / LINE_CACHE_ENTRY_BYTES);
+        hash_map_limit = (limits.memory - line_cache_limit * LINE_CACHE_ENTRY_BYTES) / HASH_MAP_ENTRY_BYTES;
+        if (line_cache.size() > line_cache_limit)
+            line_cache.clear();
+    }
+
+    // The search box starts as the stones' bounding box one cell wider, clamped to the board, end exclusive;
+    // make_move grows it from there and unmake_move puts it back
+    start_x = start_y = N;
+    end_x = end_y = 0;
+    for (int32_t y{0}; y < N; ++y)
+    {
+        const Row stones = black_board[y] | white_board[y];
+        if (!stones)
+            continue;
+        start_y = std::min(start_y, std::max(y - 1, 0));
+        end_y = std::max(end_y, std::min(y + 2, N));
+        // TOP >> x, so the highest bit set is the leftmost stone
+        start_x = std::min(start_x, std::max(N - 1 - (31 - __builtin_clz(stones)) - 1, 0));
+        end_x = std::max(end_x, std::min(N - 1 - __builtin_ctz(stones) + 2, N));
+    }
+    if (start_x > end_x)
+        start_x = start_y = end_x = end_y = N / 2;
+
+    const Mask forbidden = forbidden_moves(is_black);
+    const Mask captures_moves = capture_map().captures[is_black ? 0 : 1];
+    int16_t root_moves[N * N];
+    int root_moves_count{0};
+    for (uint16_t y{0}; y < N; ++y)
+        for (uint16_t x{0}; x < N; ++x)
+            if (!(black_board[y] & (TOP >> x)) && !(white_board[y] & (TOP >> x))
+                    && move_map[y * N + x] && !forbidden.test(x, y))
+                root_moves[root_moves_count++] = x | y << 8;
+
+    SearchProgress progress;
+    progress.depth = search_depth;
+    progress.root_moves = root_moves_count;
+    for (int i = 0; i < root_moves_count; ++i)
+    {
+        // Moves after a stop would only get a static eval, keep the ones searched properly
+        if (i && control && control->stop.load(std::memory_order_relaxed))
+            break;
+        const uint8_t x = root_moves[i] & 0xFF, y = root_moves[i] >> 8;
+        const bool full = !multi_pv || static_cast<int>(lines->size()) < multi_pv;
+        const int32_t alpha = full ? std::numeric_limits<int32_t>::min() : lines->back().score;
+        UndoRecord undo;
+        make_move(x, y, is_black, Rules::captures && captures_moves.test(x, y), undo);
+        h = minimax(search_depth, alpha, std::numeric_limits<int32_t>::max(), x, y, false, is_black);
+        unmake_move(undo);
+        // The first of equal scores stays, the moves are in search order
+        if (!multi_pv && (h > max_h || i == 0))
+        {
+            max_h = h;
+            move = root_moves[i];
+            update_pv(0, move);
+        }
+        else if (multi_pv && (full || h > alpha))
+        {
+            RootLine line;
+            line.move = root_moves[i];
+            line.score = h;
+            line.pv.push_back(line.move);
+            line.pv.insert(line.pv.end(), pv_table[1] + 1, pv_table[1] + pv_length[1]);
+            // Equal scores keep the search order
+            const auto at = std::upper_bound(lines->begin(), lines->end(), h,
+                                             [](int32_t score, const RootLine &l) { return score > l.score; });
+            lines->insert(at, std::move(line));
+            if (static_cast<int>(lines->size()) > multi_pv)
+                lines->pop_back();
+            max_h = lines->front().score;
+            move = lines->front().move;
+        }
+        if (control && control->progress)
+        {
+            const std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - startTime;
+            progress.root_moves_done = i + 1;
+            progress.nodes = stats.nodes;
+            progress.seconds = elapsed.count();
+            progress.score = max_h;
+            progress.best_move = move;
+            control->progress(progress);
+        }
+    }
+
+    const std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - startTime;
+    stats.score = max_h;
+    stats.seconds = elapsed.count();
+    stats.tt_size = table ? table->used() : hash_map.size();
+    stats.line_cache_hits = line_cache_hit_count;
+    stats.line_cache_misses = line_cache_miss_count;
+    IterationStats iteration;
+    iteration.depth = search_depth;
+    iteration.nodes = stats.nodes;
+    iteration.seconds = stats.seconds;
+    stats.iterations.push_back(iteration);
+    if (multi_pv && !lines->empty())
+        stats.pv = lines->front().pv;
+    else
+        stats.pv.assign(pv_table[0], pv_table[0] + pv_length[0]);
+    GOMOKU_TRACE_ROOT(move, max_h);
 
-    for (uint16_t y{0}; y < BOARD_SIZE; ++y)
-        for (uint16_t x{0}; x < BOARD_SIZE; ++x)
-            if (!(black_board[y] & (0x40000 >> x)) && !(white_board[y] & (0x40000 >> x)))
-                if (move_map[y * BOARD_SIZE + x])
+    this->move = prevMove;
+    moveX = prevMoveX;
+    moveY = prevMoveY;
+    return (move);
+}
+
+template<int N, class Rules>
+const typename BasicBoard<N, Rules>::Mask &BasicBoard<N, Rules>::forbidden_moves(bool is_black) const
+{
+    fill_maps();
+    return forbidden[is_black ? 0 : 1];
+}
+
+template<int N, class Rules>
+const CaptureMap<N> &BasicBoard<N, Rules>::capture_map() const
+{
+    fill_maps();
+    return captures_map;
+}
+
+template<int N, class Rules>
+void BasicBoard<N, Rules>::fill_maps() const
+{
+    if (!maps_dirty)
+        return;
+    fill_capture_map(true);
+    fill_capture_map(false);
+    fill_forbidden(true);
+    fill_forbidden(false);
+    maps_dirty = false;
+}
+
+// X O O X shapes along the 8 directions, for the whole board at once
+template<int N, class Rules>
+void BasicBoard<N, Rules>::fill_capture_map(bool is_black) const
+{
+    const Mask own = Mask::of(is_black ? black_board : white_board);
+    const Mask opp = Mask::of(is_black ? white_board : black_board);
+    const Mask empty = ~(own | opp);
+    Mask captures, exposed, threatened;
+
+    for (const auto &d : ALL_DIRS)
+        for (int sign = -1; sign <= 1; sign += 2)
+        {
+            const int dx = d[0] * sign, dy = d[1] * sign;
+            captures |= opp.shifted(dx, dy) & opp.shifted(2 * dx, 2 * dy) & own.shifted(3 * dx, 3 * dy);
+            exposed |= own.shifted(dx, dy) & opp.shifted(2 * dx, 2 * dy) & opp.shifted(-dx, -dy);
+            threatened |= own & own.shifted(dx, dy)
+                    & ((opp.shifted(-dx, -dy) & empty.shifted(2 * dx, 2 * dy))
+                        | (empty.shifted(-dx, -dy) & opp.shifted(2 * dx, 2 * dy)));
+        }
+    captures_map.captures[is_black ? 0 : 1] = captures & empty;
+    captures_map.exposed[is_black ? 0 : 1] = exposed & empty;
+    captures_map.threatened[is_black ? 0 : 1] = threatened;
+}
+
+// Same rules as is_legal_move, evaluated for every cell at once
+template<int N, class Rules>
+void BasicBoard<N, Rules>::fill_forbidden(bool is_black) const
+{
+    const Mask own = Mask::of(is_black ? black_board : white_board);
+    const Mask opp = Mask::of(is_black ? white_board : black_board);
+    const Mask empty = ~(own | opp);
+    // Open three with the new stone in the middle, only away from the edges
+    static const Mask inner = Mask::area(2, N - 2);
+    // Open three ending with the new stone, one per line
+    static const int8_t LINE_DIRS[4][2] = {{0, 1}, {1, -1}, {1, 0}, {1, 1}};
+    Mask once, twice, rules_forbidden;
+
+    auto count = [&once, &twice](const Mask &threes) {
+        twice |= once & threes;
+        once |= threes;
+    };
+    if (Rules::double_three(is_black))
+    {
+        for (const auto &d : LINE_DIRS)
+        {
+            const int dx = d[0], dy = d[1];
+            count(empty.shifted(-2 * dx, -2 * dy) & empty.shifted(2 * dx, 2 * dy)
+                    & own.shifted(-dx, -dy) & own.shifted(dx, dy) & inner);
+            count((empty.shifted(3 * dx, 3 * dy) & own.shifted(2 * dx, 2 * dy) & own.shifted(dx, dy))
+                    | (empty.shifted(-3 * dx, -3 * dy) & own.shifted(-2 * dx, -2 * dy) & own.shifted(-dx, -dy)));
+        }
+        rules_forbidden |= twice;
+    }
+    // opp own [new] opp, the new stone would be captured right away
+    if (Rules::captures)
+        rules_forbidden |= captures_map.exposed[is_black ? 0 : 1];
+    forbidden[is_black ? 0 : 1] = rules_forbidden & empty;
+}
+
+template<int N, class Rules>
+const ThreatMap<N> &BasicBoard<N, Rules>::threat_map() const
+{
+    if (threats_dirty)
+    {
+        fill_threat_map(true);
+        fill_threat_map(false);
+        threats_dirty = false;
+    }
+    return threats;
+}
+
+namespace {
+
+// Empty cells where a new stone completes pattern along (dx, dy), '0' an empty cell and any other
+// character an own stone, so the black and white patterns both work with own of either color
+template<int N>
+BitRows<N> pattern_cells(const char *pattern, const BitRows<N> &own, const BitRows<N> &empty, int dx, int dy)
+{
+    const int len = static_cast<int>(strlen(pattern));
+    BitRows<N> cells;
+    for (int at = 0; at < len; ++at)
+    {
+        if (pattern[at] == '0')
+            continue;
+        BitRows<N> match = empty;
+        for (int i = 0; i < len; ++i)
+            if (i != at)
+                match = match & (pattern[i] != '0' ? own : empty).shifted((i - at) * dx, (i - at) * dy);
+        cells |= match;
+    }
+    return cells;
+}
+
+}
+
+// The overlay shapes of Patterns.hpp with the new stone in them, for the whole board at once
+template<int N, class Rules>
+void BasicBoard<N, Rules>::fill_threat_map(bool is_black) const
+{
+    const int c = is_black ? 0 : 1;
+    const Mask own = Mask::of(is_black ? black_board : white_board);
+    const Mask opp = Mask::of(is_black ? white_board : black_board);
+    const Mask empty = ~(own | opp);
+    const bool exact = Rules::exact_five(is_black);
+    Mask two, three, once, twice, four, win, five;
+
+    for (const auto &d : ALL_DIRS)
+    {
+        const int dx = d[0], dy = d[1];
+        two |= pattern_cells(is_black ? P1_TOW_FREE_PTR : P2_TOW_FREE_PTR, own, empty, dx, dy);
+        Mask line_three;
+        for (const auto &ptr : is_black ? P1_THREE_FREE_PTR : P2_THREE_FREE_PTR)
+            line_three |= pattern_cells(ptr, own, empty, dx, dy);
+        twice |= once & line_three;
+        once |= line_three;
+        four |= pattern_cells(is_black ? P1_FOUR_FREE_PTR : P2_FOUR_FREE_PTR, own, empty, dx, dy);
+
+        // Runs of five starting k cells before the cell, stones or the new one
+        for (int k = 0; k < 5; ++k)
+        {
+            Mask run_cells = empty, run_stones = own;
+            for (int i = -k; i < 5 - k; ++i)
+                if (i)
                 {
-                    uint8_t captures{0};
-                    if (place_stone_on_board(x, y, is_black, &captures))
-                    {
-                        h = minimax(3, std::numeric_limits<int32_t>::min(), std::numeric_limits<int32_t>::max(), x, y, true, is_black);
-                        remove_stone_from_board(x, y, is_black, &captures);
-                        if (h >= max_h)
-                        {
-                            max_h = h;
-                            move = 0;
-                            move |= x;
-                            move |= (y << 8);
-                        }
-                    }
+                    run_cells = run_cells & own.shifted(i * dx, i * dy);
+                    run_stones = run_stones & own.shifted(i * dx, i * dy);
                 }
-    return (move);
+            if (exact)
+            {
+                const Mask ends = ~own.shifted((-k - 1) * dx, (-k - 1) * dy) & ~own.shifted((5 - k) * dx, (5 - k) * dy);
+                run_cells = run_cells & ends;
+                run_stones = run_stones & ends;
+            }
+            win |= run_cells;
+            five |= run_stones;
+        }
+    }
+    threats.free_two[c] = two;
+    threats.free_three[c] = once;
+    threats.double_three[c] = twice;
+    threats.free_four[c] = four;
+    threats.win[c] = win;
+    threats.five[c] = five;
 }
 
-void Board::reset()
+// Candidate cells next to the stones inside the search box, captures first
+template<int N, class Rules>
+int BasicBoard<N, Rules>::generate_moves(bool is_black, int16_t moves[N * N], int *captures_count) const
 {
-    for (int y = 0; y < BOARD_SIZE; ++y) {
-        for (int x = 0; x < BOARD_SIZE; ++x) {
+    const Mask &forbidden = forbidden_moves(is_black);
+    const Mask &captures = capture_map().captures[is_black ? 0 : 1];
+    int16_t quiet[N * N];
+    int count{0}, quiet_count{0};
+
+    for (int32_t y{start_y}; y < end_y; ++y)
+        for (int32_t x{start_x}; x < end_x; ++x)
+        {
+            if (move_map[y * N + x]
+                    && !(black_board[y] & (TOP >> x)) && !(white_board[y] & (TOP >> x))
+                    && !forbidden.test(x, y))
+            {
+                if (Rules::captures && captures.test(x, y))
+                    moves[count++] = x | (y << 8);
+                else
+                    quiet[quiet_count++] = x | (y << 8);
+            }
+        }
+    *captures_count = count;
+    for (int i = 0; i < quiet_count; ++i)
+        moves[count++] = quiet[i];
+    return count;
+}
+
+template<int N, class Rules>
+void BasicBoard<N, Rules>::reset()
+{
+    for (int y = 0; y < N; ++y) {
+        for (int x = 0; x < N; ++x) {
             setToken(x, y, EMPTY);
         }
     }
-    for (int8_t i{0}; i < BOARD_SIZE; ++i)
+    for (int8_t i{0}; i < N; ++i)
     {
         black_board[i] = 0;
         white_board[i] = 0;
-        for (int8_t j{0}; j < BOARD_SIZE; ++j)
-            move_map[i * BOARD_SIZE + j] = 0;
+        for (int8_t j{0}; j < N; ++j)
+            move_map[i * N + j] = 0;
     }
-    setToken(BOARD_SIZE / 2, BOARD_SIZE / 2, BLACK);
-    move_map[BOARD_SIZE / 2 * BOARD_SIZE + BOARD_SIZE / 2] = 1;
-    fill_zobrist_table();
+    // The center is a candidate of the empty board
+    move_map[N / 2 * N + N / 2] = 1;
+    maps_dirty = threats_dirty = true;
     hash_map.clear();
+    scored_keys.fill(std::numeric_limits<uint64_t>::max());
     hash = get_hash();
     result = NO_RESULT;
+    move = EMPTY;
+    moveX = 0;
+    moveY = 0;
     black_captures_count = 0;
     white_captures_count = 0;
     lastMoveIsCapture = false;
 }
 
-void Board::print()
+template<int N, class Rules>
+void BasicBoard<N, Rules>::print()
 {
-    for (uint16_t i{0}; i < BOARD_SIZE; ++i)
-        std::cout << std::bitset<19>(black_board[i]) << "   " << std::bitset<19>(white_board[i]) << std::endl;
-    for (uint16_t y{0}; y < BOARD_SIZE; ++y)
+    for (uint16_t i{0}; i < N; ++i)
+        std::cout << std::bitset<N>(black_board[i]) << "   " << std::bitset<N>(white_board[i]) << std::endl;
+    for (uint16_t y{0}; y < N; ++y)
     {
         std::cout << "\t   ";
-        for (uint16_t x{0}; x < BOARD_SIZE; ++x)
-            std::cout << move_map[y * BOARD_SIZE + x];
+        for (uint16_t x{0}; x < N; ++x)
+            std::cout << move_map[y * N + x];
         std::cout << "\n";
     }
     std::cout << "\nrows\n";
-    for (int col = 0; col < BS; ++col) {
-        for (int row = 0; row < BS; ++row) {
+    for (int col = 0; col < N; ++col) {
+        for (int row = 0; row < N; ++row) {
             std::cout << rows[row][col];
         }
         std::cout << std::endl;
     }
     std::cout << "\ncolumns\n";
-    for (int col = 0; col < BS; ++col) {
-        for (int row = 0; row < BS; ++row) {
+    for (int col = 0; col < N; ++col) {
+        for (int row = 0; row < N; ++row) {
             auto pt = CL_MAP.at({row, col});
             std::cout << columns[pt.first][pt.second];
         }
         std::cout << std::endl;
     }
     std::cout << "\nup\n";
-    for (int col = 0; col < BS; ++col) {
-        for (int row = 0; row < BS; ++row) {
+    for (int col = 0; col < N; ++col) {
+        for (int row = 0; row < N; ++row) {
             auto pt = UP_MAP.at({row, col});
             std::cout << up[pt.first][pt.second];
         }
         std::cout << std::endl;
     }
     std::cout << "\ndown\n";
-    for (int col = 0; col < BS; ++col) {
-        for (int row = 0; row < BS; ++row) {
+    for (int col = 0; col < N; ++col) {
+        for (int row = 0; row < N; ++row) {
             auto pt = DW_MAP.at({row, col});
             std::cout << down[pt.first][pt.second];
         }
@@ -554,657 +972,82 @@ void Board::print()
     }
 }
 
-void Board::fill_zobrist_table()
-{
-    std::random_device rd;
-    std::mt19937 rng(rd());
-    std::uniform_int_distribution<uint64_t> uni(0,std::numeric_limits<uint64_t>::max());
-
-    for (int8_t z{0}; z < 2; ++z)
-        for (int8_t y{0}; y < BOARD_SIZE; ++y)
-            for (int8_t x{0}; x < BOARD_SIZE; ++x)
-            {
-                auto r = uni(rng);
-                zobrist_table[(z * 2 + y) * BOARD_SIZE + x] = r;
-            }
-}
-
-uint64_t Board::get_hash()
+template<int N, class Rules>
+uint64_t BasicBoard<N, Rules>::get_hash() const
 {
     uint64_t hash{0};
 
-    for (int8_t y{0}; y < BOARD_SIZE; ++y)
-        for (uint8_t x{0}; x < BOARD_SIZE; ++x)
+    for (int8_t y{0}; y < N; ++y)
+        for (uint8_t x{0}; x < N; ++x)
         {
-            if (black_board[y] & (0x40000 >> x))
-                hash ^= zobrist_table[y * BOARD_SIZE +x];
-            if (white_board[y] & (0x40000 >> x))
-                hash ^= zobrist_table[(2 + y) * BOARD_SIZE + x];
+            if (black_board[y] & (TOP >> x))
+                hash ^= zobrist_table[y * N + x];
+            if (white_board[y] & (TOP >> x))
+                hash ^= zobrist_table[N * N + y * N + x];
         }
     return (hash);
 }
 
-bool Board::five_in_a_row(int32_t x, int32_t y, bool is_black)
-{
-    if (is_black && (black_board[y] & (0x40000 >> x))) // 11111
-    {
-        if (y+4 < BOARD_SIZE && (black_board[y] & black_board[y+1] & black_board[y+2] & black_board[y+3] & black_board[y+4] & (0x40000 >> x)))
-            return (true);
-        if (x+4 < BOARD_SIZE && (black_board[y] & (black_board[y] << 1) & (black_board[y] << 2) & (black_board[y] << 3) & (black_board[y] << 4) & (0x40000 >> x)))
-            return (true);
-        if (x+4 < BOARD_SIZE && y+4 < BOARD_SIZE && (black_board[y] & (black_board[y+1] << 1) & (black_board[y+2] << 2) & (black_board[y+3] << 3) & (black_board[y+4] << 4) & (0x40000 >> x)))
-            return (true);
-        if (x-4 < BOARD_SIZE && y+4 < BOARD_SIZE && (black_board[y] & (black_board[y+1] >> 1) & (black_board[y+2] >> 2) & (black_board[y+3] >> 3) & (black_board[y+4] >> 4) & (0x40000 >> x)))
-            return (true);
-    }
-    else if (!is_black && (white_board[y] & (0x40000 >> x))) // 22222
-    {
-        if (y+4 < BOARD_SIZE && (black_board[y] & black_board[y+1] & black_board[y+2] & black_board[y+3] & black_board[y+4] & (0x40000 >> x)))
-            return (true);
-        if (x+4 < BOARD_SIZE && (black_board[y] & (black_board[y] << 1) & (black_board[y] << 2) & (black_board[y] << 3) & (black_board[y] << 4) & (0x40000 >> x)))
-            return (true);
-        if (x+4 < BOARD_SIZE && y+4 < BOARD_SIZE && (black_board[y] & (black_board[y+1] << 1) & (black_board[y+2] << 2) & (black_board[y+3] << 3) & (black_board[y+4] << 4) & (0x40000 >> x)))
-            return (true);
-        if (x-4 < BOARD_SIZE && y+4 < BOARD_SIZE && (black_board[y] & (black_board[y+1] >> 1) & (black_board[y+2] >> 2) & (black_board[y+3] >> 3) & (black_board[y+4] >> 4) & (0x40000 >> x)))
-            return (true);
-    }
-    return (false);
-}
-
-bool Board::open_four(int32_t x, int32_t y, bool is_black)
-{
-    if (is_black && (!(black_board[y] & (0x40000 >> x)) && !(white_board[y] & (0x40000 >> x)))) // .1111.
-    {
-        if (y+5 < BOARD_SIZE && !(black_board[y+5] & (0x40000 >> x)) && !(white_board[y+5] & (0x40000 >> x))
-                && (black_board[y+1] & black_board[y+2] & black_board[y+3] & black_board[y+4] & (0x40000 >> x)))
-            return (true);
-        if (x+5 < BOARD_SIZE && !(black_board[y] & (0x40000 >> (x+5))) && !(white_board[y] & (0x40000 >> (x+5)))
-                && ((black_board[y] << 1) & (black_board[y] << 2) & (black_board[y] << 3) & (black_board[y] << 4) & (0x40000 >> x)))
-            return (true);
-        if (x+5 < BOARD_SIZE && y+5 < BOARD_SIZE && !(black_board[y+5] & (0x40000 >> (x+5))) && !(white_board[y+5] & (0x40000 >> (x+5)))
-                && ((black_board[y+1] << 1) & (black_board[y+2] << 2) & (black_board[y+3] << 3) & (black_board[y+4] << 4) & (0x40000 >> x)))
-            return (true);
-        if (x-5 < BOARD_SIZE && y+5 < BOARD_SIZE && !(black_board[y+5] & (0x40000 >> (x-5))) && !(white_board[y+5] & (0x40000 >> (x-5)))
-                && ((black_board[y+1] >> 1) & (black_board[y+2] >> 2) & (black_board[y+3] >> 3) & (black_board[y+4] >> 4) & (0x40000 >> x)))
-            return (true);
-    }
-    else if (!is_black && (!(black_board[y] & (0x40000 >> x)) && !(white_board[y] & (0x40000 >> x)))) // .2222.
-    {
-        if (y+5 < BOARD_SIZE && !(white_board[y+5] & (0x40000 >> x)) && !(black_board[y+5] & (0x40000 >> x))
-                && (white_board[y+1] & white_board[y+2] & white_board[y+3] & white_board[y+4] & (0x40000 >> x)))
-            return (true);
-        if (x+5 < BOARD_SIZE && !(white_board[y] & (0x40000 >> (x+5))) && !(black_board[y] & (0x40000 >> (x+5)))
-                && ((white_board[y] << 1) & (white_board[y] << 2) & (white_board[y] << 3) & (white_board[y] << 4) & (0x40000 >> x)))
-            return (true);
-        if (x+5 < BOARD_SIZE && y+5 < BOARD_SIZE && !(white_board[y+5] & (0x40000 >> (x+5))) && !(black_board[y+5] & (0x40000 >> (x+5)))
-                && ((white_board[y+1] << 1) & (white_board[y+2] << 2) & (white_board[y+3] << 3) & (white_board[y+4] << 4) & (0x40000 >> x)))
-            return (true);
-        if (x-5 < BOARD_SIZE && y+5 < BOARD_SIZE && !(white_board[y+5] & (0x40000 >> (x-5))) && !(black_board[y+5] & (0x40000 >> (x-5)))
-                && ((white_board[y+1] >> 1) & (white_board[y+2] >> 2) & (white_board[y+3] >> 3) & (white_board[y+4] >> 4) & (0x40000 >> x)))
-            return (true);
-    }
-    if (is_black && (black_board[y] & (0x40000 >> x)))
-    {
-        // 11.11.11
-        if (y+7 < BOARD_SIZE && !(black_board[y+2] & (0x40000 >> x)) && !(white_board[y+2] & (0x40000 >> x))
-                && !(black_board[y+5] & (0x40000 >> x)) && !(white_board[y+5] & (0x40000 >> x))
-                && (black_board[y+1] & black_board[y+3] & black_board[y+4] & black_board[y+6] & black_board[y+7] & (0x40000 >> x)))
-            return (true);
-        if (x+7 < BOARD_SIZE && !(black_board[y] & (0x40000 >> (x+2))) && !(white_board[y] & (0x40000 >> (x+2)))
-                && !(black_board[y] & (0x40000 >> (x+5))) && !(white_board[y] & (0x40000 >> (x+5)))
-                && ((black_board[y] << 1) & (black_board[y] << 3) & (black_board[y] << 4) & (black_board[y] << 6) & (black_board[y] << 7) & (0x40000 >> x)))
-            return (true);
-        if (x+7 < BOARD_SIZE && y+7 < BOARD_SIZE && !(black_board[y+2] & (0x40000 >> (x+2))) && !(white_board[y+2] & (0x40000 >> (x+2)))
-                && !(black_board[y+5] & (0x40000 >> (x+5))) && !(white_board[y+5] & (0x40000 >> (x+5)))
-                && ((black_board[y+1] << 1) & (black_board[y+3] << 3) & (black_board[y+4] << 4) & (black_board[y+6] << 6) & (black_board[y+7] << 7) & (0x40000 >> x)))
-            return (true);
-        if (x-7 < BOARD_SIZE && y+7 < BOARD_SIZE && !(black_board[y+2] & (0x40000 >> (x-2))) && !(white_board[y+2] & (0x40000 >> (x-2)))
-                && !(black_board[y+5] & (0x40000 >> (x-5))) && !(white_board[y+5] & (0x40000 >> (x-5)))
-                && ((black_board[y+1] >> 1) & (black_board[y+3] >> 3) & (black_board[y+4] >> 4) & (black_board[y+6] >> 6) & (black_board[y+7] >> 7) & (0x40000 >> x)))
-            return (true);
-
-        // 111.1.111
-        if (y+8 < BOARD_SIZE && !(black_board[y+3] & (0x40000 >> x)) && !(white_board[y+3] & (0x40000 >> x))
-                && !(black_board[y+5] & (0x40000 >> x)) && !(white_board[y+5] & (0x40000 >> x))
-                && (black_board[y+1] & black_board[y+2] & black_board[y+4] & black_board[y+6] & black_board[y+7] & black_board[y+8] & (0x40000 >> x)))
-            return (true);
-        if (x+8 < BOARD_SIZE && !(black_board[y] & (0x40000 >> (x+3))) && !(white_board[y] & (0x40000 >> (x+3)))
-                && !(black_board[y] & (0x40000 >> (x+5))) && !(white_board[y] & (0x40000 >> (x+5)))
-                && ((black_board[y] << 1) & (black_board[y] << 2) & (black_board[y] << 4) & (black_board[y] << 6) & (black_board[y] << 7) & (black_board[y] << 8) & (0x40000 >> x)))
-            return (true);
-        if (x+8 < BOARD_SIZE && y+8 < BOARD_SIZE && !(black_board[y+3] & (0x40000 >> (x+3))) && !(white_board[y+3] & (0x40000 >> (x+3)))
-                && !(black_board[y+5] & (0x40000 >> (x+5))) && !(white_board[y+5] & (0x40000 >> (x+5)))
-                && ((black_board[y+1] << 1) & (black_board[y+2] << 2) & (black_board[y+4] << 4) & (black_board[y+6] << 6) & (black_board[y+7] << 7) & (black_board[y+8] << 8) & (0x40000 >> x)))
-            return (true);
-        if (x-8 < BOARD_SIZE && y+8 < BOARD_SIZE && !(black_board[y+3] & (0x40000 >> (x-3))) && !(white_board[y+3] & (0x40000 >> (x-3)))
-                && !(black_board[y+5] & (0x40000 >> (x-5))) && !(white_board[y+5] & (0x40000 >> (x-5)))
-                && ((black_board[y+1] >> 1) & (black_board[y+2] >> 2) & (black_board[y+4] >> 4) & (black_board[y+6] >> 6) & (black_board[y+7] >> 7) & (black_board[y+8] >> 8) & (0x40000 >> x)))
-            return (true);
-    }
-    else if (!is_black && (white_board[y] & (0x40000 >> x)))
-    {
-        // 22.22.22
-        if (y+7 < BOARD_SIZE && !(white_board[y+2] & (0x40000 >> x)) && !(black_board[y+2] & (0x40000 >> x))
-                && !(white_board[y+5] & (0x40000 >> x)) && !(black_board[y+5] & (0x40000 >> x))
-                && (white_board[y+1] & white_board[y+3] & white_board[y+4] & white_board[y+6] & white_board[y+7] & (0x40000 >> x)))
-            return (true);
-        if (x+7 < BOARD_SIZE && !(white_board[y] & (0x40000 >> (x+2))) && !(black_board[y] & (0x40000 >> (x+2)))
-                && !(white_board[y] & (0x40000 >> (x+5))) && !(black_board[y] & (0x40000 >> (x+5)))
-                && ((white_board[y] << 1) & (white_board[y] << 3) & (white_board[y] << 4) & (white_board[y] << 6) & (white_board[y] << 7) & (0x40000 >> x)))
-            return (true);
-        if (x+7 < BOARD_SIZE && y+7 < BOARD_SIZE && !(white_board[y+2] & (0x40000 >> (x+2))) && !(black_board[y+2] & (0x40000 >> (x+2)))
-                && !(white_board[y+5] & (0x40000 >> (x+5))) && !(black_board[y+5] & (0x40000 >> (x+5)))
-                && ((white_board[y+1] << 1) & (white_board[y+3] << 3) & (white_board[y+4] << 4) & (white_board[y+6] << 6) & (white_board[y+7] << 7) & (0x40000 >> x)))
-            return (true);
-        if (x-7 < BOARD_SIZE && y+7 < BOARD_SIZE && !(white_board[y+2] & (0x40000 >> (x-2))) && !(black_board[y+2] & (0x40000 >> (x-2)))
-                && !(white_board[y+5] & (0x40000 >> (x-5))) && !(black_board[y+5] & (0x40000 >> (x-5)))
-                && ((white_board[y+1] >> 1) & (white_board[y+3] >> 3) & (white_board[y+4] >> 4) & (white_board[y+6] >> 6) & (white_board[y+7] >> 7) & (0x40000 >> x)))
-            return (true);
-
-        // 222.2.222
-        if (y+8 < BOARD_SIZE && !(white_board[y+3] & (0x40000 >> x)) && !(black_board[y+3] & (0x40000 >> x))
-                && !(white_board[y+5] & (0x40000 >> x)) && !(black_board[y+5] & (0x40000 >> x))
-                && (white_board[y+1] & white_board[y+2] & white_board[y+4] & white_board[y+6] & white_board[y+7] & white_board[y+8] & (0x40000 >> x)))
-            return (true);
-        if (x+8 < BOARD_SIZE && !(white_board[y] & (0x40000 >> (x+3))) && !(black_board[y] & (0x40000 >> (x+3)))
-                && !(white_board[y] & (0x40000 >> (x+5))) && !(black_board[y] & (0x40000 >> (x+5)))
-                && ((white_board[y] << 1) & (white_board[y] << 2) & (white_board[y] << 4) & (white_board[y] << 6) & (white_board[y] << 7) & (white_board[y] << 8) & (0x40000 >> x)))
-            return (true);
-        if (x+8 < BOARD_SIZE && y+8 < BOARD_SIZE && !(white_board[y+3] & (0x40000 >> (x+3))) && !(black_board[y+3] & (0x40000 >> (x+3)))
-                && !(white_board[y+5] & (0x40000 >> (x+5))) && !(black_board[y+5] & (0x40000 >> (x+5)))
-                && ((white_board[y+1] << 1) & (white_board[y+2] << 2) & (white_board[y+4] << 4) & (white_board[y+6] << 6) & (white_board[y+7] << 7) & (white_board[y+8] << 8) & (0x40000 >> x)))
-            return (true);
-        if (x-8 < BOARD_SIZE && y+8 < BOARD_SIZE && !(white_board[y+3] & (0x40000 >> (x-3))) && !(black_board[y+3] & (0x40000 >> (x-3)))
-                && !(white_board[y+5] & (0x40000 >> (x-5))) && !(black_board[y+5] & (0x40000 >> (x-5)))
-                && ((white_board[y+1] >> 1) & (white_board[y+2] >> 2) & (white_board[y+4] >> 4) & (white_board[y+6] >> 6) & (white_board[y+7] >> 7) & (white_board[y+8] >> 8) & (0x40000 >> x)))
-            return (true);
-    }
-    return (false);
-}
-
-bool Board::simple_four(int32_t x, int32_t y, bool is_black)
-{
-    if (is_black && (white_board[y] & (0x40000 >> x))) // 21111.
-    {
-        if (y+5 < BOARD_SIZE && !(black_board[y+5] & (0x40000 >> x)) && !(white_board[y+5] & (0x40000 >> x))
-                && (black_board[y+1] & black_board[y+2] & black_board[y+3] & black_board[y+4] & (0x40000 >> x)))
-            return (true);
-        if (x+5 < BOARD_SIZE && !(black_board[y] & (0x40000 >> (x+5))) && !(white_board[y] & (0x40000 >> (x+5)))
-                && ((black_board[y] << 1) & (black_board[y] << 2) & (black_board[y] << 3) & (black_board[y] << 4) & (0x40000 >> x)))
-            return (true);
-        if (x+5 < BOARD_SIZE && y+5 < BOARD_SIZE && !(black_board[y+5] & (0x40000 >> (x+5))) && !(white_board[y+5] & (0x40000 >> (x+5)))
-                && ((black_board[y+1] << 1) & (black_board[y+2] << 2) & (black_board[y+3] << 3) & (black_board[y+4] << 4) & (0x40000 >> x)))
-            return (true);
-        if (x-5 < BOARD_SIZE && y+5 < BOARD_SIZE && !(black_board[y+5] & (0x40000 >> (x-5))) && !(white_board[y+5] & (0x40000 >> (x-5)))
-                && ((black_board[y+1] >> 1) & (black_board[y+2] >> 2) & (black_board[y+3] >> 3) & (black_board[y+4] >> 4) & (0x40000 >> x)))
-            return (true);
-    }
-    else if (is_black && (!(black_board[y] & (0x40000 >> x)) && !(white_board[y] & (0x40000 >> x)))) // .11112
-    {
-        if (y+5 < BOARD_SIZE && (white_board[y+5] & (0x40000 >> x))
-                && (black_board[y+1] & black_board[y+2] & black_board[y+3] & black_board[y+4] & (0x40000 >> x)))
-            return (true);
-        if (x+5 < BOARD_SIZE && (white_board[y] & (0x40000 >> (x+5)))
-                && ((black_board[y] << 1) & (black_board[y] << 2) & (black_board[y] << 3) & (black_board[y] << 4) & (0x40000 >> x)))
-            return (true);
-        if (x+5 < BOARD_SIZE && y+5 < BOARD_SIZE && (white_board[y+5] & (0x40000 >> (x+5)))
-                && ((black_board[y+1] << 1) & (black_board[y+2] << 2) & (black_board[y+3] << 3) & (black_board[y+4] << 4) & (0x40000 >> x)))
-            return (true);
-        if (x-5 < BOARD_SIZE && y+5 < BOARD_SIZE && (white_board[y+5] & (0x40000 >> (x-5)))
-                && ((black_board[y+1] >> 1) & (black_board[y+2] >> 2) & (black_board[y+3] >> 3) & (black_board[y+4] >> 4) & (0x40000 >> x)))
-            return (true);
-    }
-    else if (!is_black && (black_board[y] & (0x40000 >> x))) // 12222.
-    {
-        if (y+5 < BOARD_SIZE && !(white_board[y+5] & (0x40000 >> x)) && !(black_board[y+5] & (0x40000 >> x))
-                && (white_board[y+1] & white_board[y+2] & white_board[y+3] & white_board[y+4] & (0x40000 >> x)))
-            return (true);
-        if (x+5 < BOARD_SIZE && !(white_board[y] & (0x40000 >> (x+5))) && !(black_board[y] & (0x40000 >> (x+5)))
-                && ((white_board[y] << 1) & (white_board[y] << 2) & (white_board[y] << 3) & (white_board[y] << 4) & (0x40000 >> x)))
-            return (true);
-        if (x+5 < BOARD_SIZE && y+5 < BOARD_SIZE && !(white_board[y+5] & (0x40000 >> (x+5))) && !(black_board[y+5] & (0x40000 >> (x+5)))
-                && ((white_board[y+1] << 1) & (white_board[y+2] << 2) & (white_board[y+3] << 3) & (white_board[y+4] << 4) & (0x40000 >> x)))
-            return (true);
-        if (x-5 < BOARD_SIZE && y+5 < BOARD_SIZE && !(white_board[y+5] & (0x40000 >> (x-5))) && !(black_board[y+5] & (0x40000 >> (x-5)))
-                && ((white_board[y+1] >> 1) & (white_board[y+2] >> 2) & (white_board[y+3] >> 3) & (white_board[y+4] >> 4) & (0x40000 >> x)))
-            return (true);
-    }
-    else if (!is_black && (!(black_board[y] & (0x40000 >> x)) && !(white_board[y] & (0x40000 >> x)))) // .22221
-    {
-        if (y+5 < BOARD_SIZE && (black_board[y+5] & (0x40000 >> x))
-                && (white_board[y+1] & white_board[y+2] & white_board[y+3] & white_board[y+4] & (0x40000 >> x)))
-            return (true);
-        if (x+5 < BOARD_SIZE && (black_board[y] & (0x40000 >> (x+5)))
-                && ((white_board[y] << 1) & (white_board[y] << 2) & (white_board[y] << 3) & (white_board[y] << 4) & (0x40000 >> x)))
-            return (true);
-        if (x+5 < BOARD_SIZE && y+5 < BOARD_SIZE && (black_board[y+5] & (0x40000 >> (x+5)))
-                && ((white_board[y+1] << 1) & (white_board[y+2] << 2) & (white_board[y+3] << 3) & (white_board[y+4] << 4) & (0x40000 >> x)))
-            return (true);
-        if (x-5 < BOARD_SIZE && y+5 < BOARD_SIZE && (black_board[y+5] & (0x40000 >> (x-5)))
-                && ((white_board[y+1] >> 1) & (white_board[y+2] >> 2) & (white_board[y+3] >> 3) & (white_board[y+4] >> 4) & (0x40000 >> x)))
-            return (true);
-    }
-
-    if (is_black && (black_board[y] & (0x40000 >> x)))
-    {
-        // 1.111
-        if (y+4 < BOARD_SIZE && !(black_board[y+1] & (0x40000 >> x)) && !(white_board[y+1] & (0x40000 >> x))
-                && (black_board[y+2] & black_board[y+3] & black_board[y+4] & (0x40000 >> x)))
-            return (true);
-        if (x+4 < BOARD_SIZE && !(black_board[y] & (0x40000 >> (x+1))) && !(white_board[y] & (0x40000 >> (x+1)))
-                && ((black_board[y] << 2) & (black_board[y] << 3) & (black_board[y] << 4) & (0x40000 >> x)))
-            return (true);
-        if (x+4 < BOARD_SIZE && y+4 < BOARD_SIZE && !(black_board[y+1] & (0x40000 >> (x+1))) && !(white_board[y+1] & (0x40000 >> (x+1)))
-                && ((black_board[y+2] << 2) & (black_board[y+3] << 3) & (black_board[y+4] << 4) & (0x40000 >> x)))
-            return (true);
-        if (x-4 < BOARD_SIZE && y+4 < BOARD_SIZE && !(black_board[y+1] & (0x40000 >> (x-1))) && !(white_board[y+1] & (0x40000 >> (x-1)))
-                && ((black_board[y+2] >> 2) & (black_board[y+3] >> 3) & (black_board[y+4] >> 4) & (0x40000 >> x)))
-            return (true);
-
-        // 111.1
-        if (y+4 < BOARD_SIZE && !(black_board[y+3] & (0x40000 >> x)) && !(white_board[y+3] & (0x40000 >> x))
-                && (black_board[y+1] & black_board[y+2] & black_board[y+4] & (0x40000 >> x)))
-            return (true);
-        if (x+4 < BOARD_SIZE && !(black_board[y] & (0x40000 >> (x+3))) && !(white_board[y] & (0x40000 >> (x+3)))
-                && ((black_board[y] << 1) & (black_board[y] << 2) & (black_board[y] << 4) & (0x40000 >> x)))
-            return (true);
-        if (x+4 < BOARD_SIZE && y+4 < BOARD_SIZE && !(black_board[y+3] & (0x40000 >> (x+3))) && !(white_board[y+3] & (0x40000 >> (x+3)))
-                && ((black_board[y+1] << 1) & (black_board[y+2] << 2) & (black_board[y+4] << 4) & (0x40000 >> x)))
-            return (true);
-        if (x-4 < BOARD_SIZE && y+4 < BOARD_SIZE && !(black_board[y+3] & (0x40000 >> (x-3))) && !(white_board[y+3] & (0x40000 >> (x-3)))
-                && ((black_board[y+1] >> 1) & (black_board[y+2] >> 2) & (black_board[y+4] >> 4) & (0x40000 >> x)))
-            return (true);
-    }
-    else if (!is_black && (white_board[y] & (0x40000 >> x)))
-    {
-        // 2.222
-        if (y+4 < BOARD_SIZE && !(white_board[y+1] & (0x40000 >> x)) && !(black_board[y+1] & (0x40000 >> x))
-                && (white_board[y+2] & white_board[y+3] & white_board[y+4] & (0x40000 >> x)))
-            return (true);
-        if (x+4 < BOARD_SIZE && !(white_board[y] & (0x40000 >> (x+1))) && !(black_board[y] & (0x40000 >> (x+1)))
-                && ((white_board[y] << 2) & (white_board[y] << 3) & (white_board[y] << 4) & (0x40000 >> x)))
-            return (true);
-        if (x+4 < BOARD_SIZE && y+4 < BOARD_SIZE && !(white_board[y+1] & (0x40000 >> (x+1))) && !(black_board[y+1] & (0x40000 >> (x+1)))
-                && ((white_board[y+2] << 2) & (white_board[y+3] << 3) & (white_board[y+4] << 4) & (0x40000 >> x)))
-            return (true);
-        if (x-4 < BOARD_SIZE && y+4 < BOARD_SIZE && !(white_board[y+1] & (0x40000 >> (x-1))) && !(black_board[y+1] & (0x40000 >> (x-1)))
-                && ((white_board[y+2] >> 2) & (white_board[y+3] >> 3) & (white_board[y+4] >> 4) & (0x40000 >> x)))
-            return (true);
-
-        // 222.2
-        if (y+4 < BOARD_SIZE && !(white_board[y+3] & (0x40000 >> x)) && !(black_board[y+3] & (0x40000 >> x))
-                && (white_board[y+1] & white_board[y+2] & white_board[y+4] & (0x40000 >> x)))
-            return (true);
-        if (x+4 < BOARD_SIZE && !(white_board[y] & (0x40000 >> (x+3))) && !(black_board[y] & (0x40000 >> (x+3)))
-                && ((white_board[y] << 1) & (white_board[y] << 2) & (white_board[y] << 4) & (0x40000 >> x)))
-            return (true);
-        if (x+4 < BOARD_SIZE && y+4 < BOARD_SIZE && !(white_board[y+3] & (0x40000 >> (x+3))) && !(black_board[y+3] & (0x40000 >> (x+3)))
-                && ((white_board[y+1] << 1) & (white_board[y+2] << 2) & (white_board[y+4] << 4) & (0x40000 >> x)))
-            return (true);
-        if (x-4 < BOARD_SIZE && y+4 < BOARD_SIZE && !(white_board[y+3] & (0x40000 >> (x-3))) && !(black_board[y+3] & (0x40000 >> (x-3)))
-                && ((white_board[y+1] >> 1) & (white_board[y+2] >> 2) & (white_board[y+4] >> 4) & (0x40000 >> x)))
-            return (true);
-    }
-
-    if (is_black && (black_board[y] & (0x40000 >> x)))
-    {
-        // 11.11
-        if (y+4 < BOARD_SIZE && !(black_board[y+2] & (0x40000 >> x)) && !(white_board[y+2] & (0x40000 >> x))
-                && (black_board[y+1] & black_board[y+3] & black_board[y+4] & (0x40000 >> x)))
-            return (true);
-        if (x+4 < BOARD_SIZE && !(black_board[y] & (0x40000 >> (x+2))) && !(white_board[y] & (0x40000 >> (x+2)))
-                && ((black_board[y] << 1) & (black_board[y] << 3) & (black_board[y] << 4) & (0x40000 >> x)))
-            return (true);
-        if (x+4 < BOARD_SIZE && y+4 < BOARD_SIZE && !(black_board[y+2] & (0x40000 >> (x+2))) && !(white_board[y+2] & (0x40000 >> (x+2)))
-                && ((black_board[y+1] << 1) & (black_board[y+3] << 3) & (black_board[y+4] << 4) & (0x40000 >> x)))
-            return (true);
-        if (x-4 < BOARD_SIZE && y+4 < BOARD_SIZE && !(black_board[y+2] & (0x40000 >> (x-2))) && !(white_board[y+2] & (0x40000 >> (x-2)))
-                && ((black_board[y+1] >> 1) & (black_board[y+3] >> 3) & (black_board[y+4] >> 4) & (0x40000 >> x)))
-            return (true);
-    }
-    else if (!is_black && (white_board[y] & (0x40000 >> x)))
-    {
-        // 22.22
-        if (y+4 < BOARD_SIZE && !(white_board[y+2] & (0x40000 >> x)) && !(black_board[y+2] & (0x40000 >> x))
-                && (white_board[y+1] & white_board[y+3] & white_board[y+4] & (0x40000 >> x)))
-            return (true);
-        if (x+4 < BOARD_SIZE && !(white_board[y] & (0x40000 >> (x+2))) && !(black_board[y] & (0x40000 >> (x+2)))
-                && ((white_board[y] << 1) & (white_board[y] << 3) & (white_board[y] << 4) & (0x40000 >> x)))
-            return (true);
-        if (x+4 < BOARD_SIZE && y+4 < BOARD_SIZE && !(white_board[y+2] & (0x40000 >> (x+2))) && !(black_board[y+2] & (0x40000 >> (x+2)))
-                && ((white_board[y+1] << 1) & (white_board[y+3] << 3) & (white_board[y+4] << 4) & (0x40000 >> x)))
-            return (true);
-        if (x-4 < BOARD_SIZE && y+4 < BOARD_SIZE && !(white_board[y+2] & (0x40000 >> (x-2))) && !(black_board[y+2] & (0x40000 >> (x-2)))
-                && ((white_board[y+1] >> 1) & (white_board[y+3] >> 3) & (white_board[y+4] >> 4) & (0x40000 >> x)))
-            return (true);
-    }
-    return (false);
-}
-
-bool Board::open_three(int32_t x, int32_t y, bool is_black)
+// Bitboards, string projections, line keys, move_map and hash all describe the same stones
+template<int N, class Rules>
+bool BasicBoard<N, Rules>::check_invariants(std::string *error) const
 {
-    if (is_black && (!(black_board[y] & (0x40000 >> x)) && !(white_board[y] & (0x40000 >> x)))) // .111.
-    {
-        if (y+4 < BOARD_SIZE && !(black_board[y+4] & (0x40000 >> x)) && !(white_board[y+4] & (0x40000 >> x))
-                && (black_board[y+1] & black_board[y+2] & black_board[y+3] & (0x40000 >> x)))
-            return (true);
-        if (x+4 < BOARD_SIZE && !(black_board[y] & (0x40000 >> (x+4))) && !(white_board[y] & (0x40000 >> (x+4)))
-                && ((black_board[y] << 1) & (black_board[y] << 2) & (black_board[y] << 3) & (0x40000 >> x)))
-            return (true);
-        if (x+4 < BOARD_SIZE && y+4 < BOARD_SIZE && !(black_board[y+4] & (0x40000 >> (x+4))) && !(white_board[y+4] & (0x40000 >> (x+4)))
-                && ((black_board[y+1] << 1) & (black_board[y+2] << 2) & (black_board[y+3] << 3) & (0x40000 >> x)))
-            return (true);
-        if (x-4 < BOARD_SIZE && y+4 < BOARD_SIZE && !(black_board[y+4] & (0x40000 >> (x-4))) && !(white_board[y+4] & (0x40000 >> (x-4)))
-                && ((black_board[y+1] >> 1) & (black_board[y+2] >> 2) & (black_board[y+3] >> 3) & (0x40000 >> x)))
-            return (true);
-    }
-    else if (!is_black && (!(black_board[y] & (0x40000 >> x)) && !(white_board[y] & (0x40000 >> x)))) // .222.
-    {
-        if (y+4 < BOARD_SIZE && !(white_board[y+4] & (0x40000 >> x)) && !(black_board[y+4] & (0x40000 >> x))
-                && (white_board[y+1] & white_board[y+2] & white_board[y+3] & (0x40000 >> x)))
-            return (true);
-        if (x+4 < BOARD_SIZE && !(white_board[y] & (0x40000 >> (x+4))) && !(black_board[y] & (0x40000 >> (x+4)))
-                && ((white_board[y] << 1) & (white_board[y] << 2) & (white_board[y] << 3) & (0x40000 >> x)))
-            return (true);
-        if (x+4 < BOARD_SIZE && y+4 < BOARD_SIZE && !(white_board[y+4] & (0x40000 >> (x+4))) && !(black_board[y+4] & (0x40000 >> (x+4)))
-                && ((white_board[y+1] << 1) & (white_board[y+2] << 2) & (white_board[y+3] << 3) & (0x40000 >> x)))
-            return (true);
-        if (x-4 < BOARD_SIZE && y+4 < BOARD_SIZE && !(white_board[y+4] & (0x40000 >> (x-4))) && !(black_board[y+4] & (0x40000 >> (x-4)))
-                && ((white_board[y+1] >> 1) & (white_board[y+2] >> 2) & (white_board[y+3] >> 3) & (0x40000 >> x)))
-            return (true);
+    auto fail = [error](const std::string &what, int x, int y) {
+        if (error)
+            *error = what + " at " + std::to_string(x) + "," + std::to_string(y);
+        return false;
     };
-    return (false);
-}
-
-bool Board::simple_three(int32_t x, int32_t y, bool is_black)
-{
-    if (is_black && (black_board[y] & (0x40000 >> x)))
-    {
-        // 1.11
-        if (y+3 < BOARD_SIZE && !(black_board[y+1] & (0x40000 >> x)) && !(white_board[y+1] & (0x40000 >> x))
-                && (black_board[y+2] & black_board[y+3] & (0x40000 >> x)))
-            return (true);
-        if (x+3 < BOARD_SIZE && !(black_board[y] & (0x40000 >> (x+1))) && !(white_board[y] & (0x40000 >> (x+1)))
-                && ((black_board[y] << 2) & (black_board[y] << 3) & (0x40000 >> x)))
-            return (true);
-        if (x+3 < BOARD_SIZE && y+3 < BOARD_SIZE && !(black_board[y+1] & (0x40000 >> (x+1))) && !(white_board[y+1] & (0x40000 >> (x+1)))
-                && ((black_board[y+2] << 2) & (black_board[y+3] << 3) & (0x40000 >> x)))
-            return (true);
-        if (x-3 < BOARD_SIZE && y+3 < BOARD_SIZE && !(black_board[y+1] & (0x40000 >> (x-1))) && !(white_board[y+1] & (0x40000 >> (x-1)))
-                && ((black_board[y+2] >> 2) & (black_board[y+3] >> 3) & (0x40000 >> x)))
-            return (true);
-
-        // 11.1
-        if (y+3 < BOARD_SIZE && !(black_board[y+2] & (0x40000 >> x)) && !(white_board[y+2] & (0x40000 >> x))
-                && (black_board[y+1] & black_board[y+3] & (0x40000 >> x)))
-            return (true);
-        if (x+3 < BOARD_SIZE && !(black_board[y] & (0x40000 >> (x+2))) && !(white_board[y] & (0x40000 >> (x+2)))
-                && ((black_board[y] << 1) & (black_board[y] << 3) & (0x40000 >> x)))
-            return (true);
-        if (x+3 < BOARD_SIZE && y+3 < BOARD_SIZE && !(black_board[y+2] & (0x40000 >> (x+2))) && !(white_board[y+2] & (0x40000 >> (x+2)))
-                && ((black_board[y+1] << 1) & (black_board[y+3] << 3) & (0x40000 >> x)))
-            return (true);
-        if (x-3 < BOARD_SIZE && y+3 < BOARD_SIZE && !(black_board[y+2] & (0x40000 >> (x-2))) && !(white_board[y+2] & (0x40000 >> (x-2)))
-                && ((black_board[y+1] >> 1) & (black_board[y+3] >> 3) & (0x40000 >> x)))
-            return (true);
-    }
-    else if (!is_black && (white_board[y] & (0x40000 >> x)))
-    {
-        // 2.22
-        if (y+3 < BOARD_SIZE && !(white_board[y+1] & (0x40000 >> x)) && !(black_board[y+1] & (0x40000 >> x))
-                && (white_board[y+2] & white_board[y+3] & (0x40000 >> x)))
-            return (true);
-        if (x+3 < BOARD_SIZE && !(white_board[y] & (0x40000 >> (x+1))) && !(black_board[y] & (0x40000 >> (x+1)))
-                && ((white_board[y] << 2) & (white_board[y] << 3) & (0x40000 >> x)))
-            return (true);
-        if (x+3 < BOARD_SIZE && y+3 < BOARD_SIZE && !(white_board[y+1] & (0x40000 >> (x+1))) && !(black_board[y+1] & (0x40000 >> (x+1)))
-                && ((white_board[y+2] << 2) & (white_board[y+3] << 3) & (0x40000 >> x)))
-            return (true);
-        if (x-3 < BOARD_SIZE && y+3 < BOARD_SIZE && !(white_board[y+1] & (0x40000 >> (x-1))) && !(black_board[y+1] & (0x40000 >> (x-1)))
-                && ((white_board[y+2] >> 2) & (white_board[y+3] >> 3) & (0x40000 >> x)))
-            return (true);
-
-        // 22.2
-        if (y+3 < BOARD_SIZE && !(white_board[y+2] & (0x40000 >> x)) && !(black_board[y+2] & (0x40000 >> x))
-                && (white_board[y+1] & white_board[y+3] & (0x40000 >> x)))
-            return (true);
-        if (x+3 < BOARD_SIZE && !(white_board[y] & (0x40000 >> (x+2))) && !(black_board[y] & (0x40000 >> (x+2)))
-                && ((white_board[y] << 1) & (white_board[y] << 3) & (0x40000 >> x)))
-            return (true);
-        if (x+3 < BOARD_SIZE && y+3 < BOARD_SIZE && !(white_board[y+2] & (0x40000 >> (x+2))) && !(black_board[y+2] & (0x40000 >> (x+2)))
-                && ((white_board[y+1] << 1) & (white_board[y+3] << 3) & (0x40000 >> x)))
-            return (true);
-        if (x-3 < BOARD_SIZE && y+3 < BOARD_SIZE && !(white_board[y+2] & (0x40000 >> (x-2))) && !(black_board[y+2] & (0x40000 >> (x-2)))
-                && ((white_board[y+1] >> 1) & (white_board[y+3] >> 3) & (0x40000 >> x)))
-            return (true);
-    }
-
-    if (is_black && (white_board[y] & (0x40000 >> x))) // 2111.
-    {
-        if (y+4 < BOARD_SIZE && !(black_board[y+4] & (0x40000 >> x)) && !(white_board[y+4] & (0x40000 >> x))
-                && (black_board[y+1] & black_board[y+2] & black_board[y+3] & (0x40000 >> x)))
-            return (true);
-        if (x+4 < BOARD_SIZE && !(black_board[y] & (0x40000 >> (x+4))) && !(white_board[y] & (0x40000 >> (x+4)))
-                && ((black_board[y] << 1) & (black_board[y] << 2) & (black_board[y] << 3) & (0x40000 >> x)))
-            return (true);
-        if (x+4 < BOARD_SIZE && y+4 < BOARD_SIZE && !(black_board[y+4] & (0x40000 >> (x+4))) && !(white_board[y+4] & (0x40000 >> (x+4)))
-                && ((black_board[y+1] << 1) & (black_board[y+2] << 2) & (black_board[y+3] << 3) & (0x40000 >> x)))
-            return (true);
-        if (x-4 < BOARD_SIZE && y+4 < BOARD_SIZE && !(black_board[y+4] & (0x40000 >> (x-4))) && !(white_board[y+4] & (0x40000 >> (x-4)))
-                && ((black_board[y+1] >> 1) & (black_board[y+2] >> 2) & (black_board[y+3] >> 3) & (0x40000 >> x)))
-            return (true);
-    }
-    else if (is_black && (!(black_board[y] & (0x40000 >> x)) && !(white_board[y] & (0x40000 >> x)))) // .1112
-    {
-        if (y+4 < BOARD_SIZE && (white_board[y+4] & (0x40000 >> x))
-                && (black_board[y+1] & black_board[y+2] & black_board[y+3] & (0x40000 >> x)))
-            return (true);
-        if (x+4 < BOARD_SIZE && (white_board[y] & (0x40000 >> (x+4)))
-                && ((black_board[y] << 1) & (black_board[y] << 2) & (black_board[y] << 3) & (0x40000 >> x)))
-            return (true);
-        if (x+4 < BOARD_SIZE && y+4 < BOARD_SIZE && (white_board[y+4] & (0x40000 >> (x+4)))
-                && ((black_board[y+1] << 1) & (black_board[y+2] << 2) & (black_board[y+3] << 3) & (0x40000 >> x)))
-            return (true);
-        if (x-4 < BOARD_SIZE && y+4 < BOARD_SIZE && (white_board[y+4] & (0x40000 >> (x-4)))
-                && ((black_board[y+1] >> 1) & (black_board[y+2] >> 2) & (black_board[y+3] >> 3) & (0x40000 >> x)))
-            return (true);
-    }
-    else if (!is_black && (black_board[y] & (0x40000 >> x))) // 1222.
-    {
-        if (y+4 < BOARD_SIZE && !(white_board[y+4] & (0x40000 >> x)) && !(black_board[y+4] & (0x40000 >> x))
-                && (white_board[y+1] & white_board[y+2] & white_board[y+3] & (0x40000 >> x)))
-            return (true);
-        if (x+4 < BOARD_SIZE && !(white_board[y] & (0x40000 >> (x+4))) && !(black_board[y] & (0x40000 >> (x+4)))
-                && ((white_board[y] << 1) & (white_board[y] << 2) & (white_board[y] << 3) & (0x40000 >> x)))
-            return (true);
-        if (x+4 < BOARD_SIZE && y+4 < BOARD_SIZE && !(white_board[y+4] & (0x40000 >> (x+4))) && !(black_board[y+4] & (0x40000 >> (x+4)))
-                && ((white_board[y+1] << 1) & (white_board[y+2] << 2) & (white_board[y+3] << 3) & (0x40000 >> x)))
-            return (true);
-        if (x-4 < BOARD_SIZE && y+4 < BOARD_SIZE && !(white_board[y+4] & (0x40000 >> (x-4))) && !(black_board[y+4] & (0x40000 >> (x-4)))
-                && ((white_board[y+1] >> 1) & (white_board[y+2] >> 2) & (white_board[y+3] >> 3) & (0x40000 >> x)))
-            return (true);
-    }
-    else if (!is_black && (!(black_board[y] & (0x40000 >> x)) && !(white_board[y] & (0x40000 >> x)))) // .2221
-    {
-        if (y+4 < BOARD_SIZE && (black_board[y+4] & (0x40000 >> x))
-                && (white_board[y+1] & white_board[y+2] & white_board[y+3] & (0x40000 >> x)))
-            return (true);
-        if (x+4 < BOARD_SIZE && (black_board[y] & (0x40000 >> (x+4)))
-                && ((white_board[y] << 1) & (white_board[y] << 2) & (white_board[y] << 3) & (0x40000 >> x)))
-            return (true);
-        if (x+4 < BOARD_SIZE && y+4 < BOARD_SIZE && (black_board[y+4] & (0x40000 >> (x+4)))
-                && ((white_board[y+1] << 1) & (white_board[y+2] << 2) & (white_board[y+3] << 3) & (0x40000 >> x)))
-            return (true);
-        if (x-4 < BOARD_SIZE && y+4 < BOARD_SIZE && (black_board[y+4] & (0x40000 >> (x-4)))
-                && ((white_board[y+1] >> 1) & (white_board[y+2] >> 2) & (white_board[y+3] >> 3) & (0x40000 >> x)))
-            return (true);
-    }
-
-    if (is_black && (black_board[y] & (0x40000 >> x))) // 1.112
-    {
-        if (y+4 < BOARD_SIZE && !(black_board[y+1] & (0x40000 >> x)) && !(white_board[y+1] & (0x40000 >> x))
-                && (black_board[y+2] & black_board[y+3] & white_board[y+4] & (0x40000 >> x)))
-            return (true);
-        if (x+4 < BOARD_SIZE && !(black_board[y] & (0x40000 >> (x+1))) && !(white_board[y] & (0x40000 >> (x+1)))
-                && ((black_board[y] << 2) & (black_board[y] << 3) & (white_board[y] << 4) & (0x40000 >> x)))
-            return (true);
-        if (x+4 < BOARD_SIZE && y+4 < BOARD_SIZE && !(black_board[y+1] & (0x40000 >> (x+1))) && !(white_board[y+1] & (0x40000 >> (x+1)))
-                && ((black_board[y+2] << 2) & (black_board[y+3] << 3) & (white_board[y+4] << 4) & (0x40000 >> x)))
-            return (true);
-        if (x-4 < BOARD_SIZE && y+4 < BOARD_SIZE && !(black_board[y+1] & (0x40000 >> (x-1))) && !(white_board[y+1] & (0x40000 >> (x-1)))
-                && ((black_board[y+2] >> 2) & (black_board[y+3] >> 3) & (white_board[y+4] >> 4) & (0x40000 >> x)))
-            return (true);
-    }
-    else if (is_black && (white_board[y] & (0x40000 >> x))) // 211.1
-    {
-        if (y+4 < BOARD_SIZE && !(black_board[y+3] & (0x40000 >> x)) && !(white_board[y+3] & (0x40000 >> x))
-                && (black_board[y+1] & black_board[y+2] & black_board[y+4] & (0x40000 >> x)))
-            return (true);
-        if (x+4 < BOARD_SIZE && !(black_board[y] & (0x40000 >> (x+3))) && !(white_board[y] & (0x40000 >> (x+3)))
-                && ((black_board[y] << 1) & (black_board[y] << 2) & (black_board[y] << 4) & (0x40000 >> x)))
-            return (true);
-        if (x+4 < BOARD_SIZE && y+4 < BOARD_SIZE && !(black_board[y+3] & (0x40000 >> (x+3))) && !(white_board[y+3] & (0x40000 >> (x+3)))
-                && ((black_board[y+1] << 1) & (black_board[y+2] << 2) & (black_board[y+4] << 4) & (0x40000 >> x)))
-            return (true);
-        if (x-4 < BOARD_SIZE && y+4 < BOARD_SIZE && !(black_board[y+3] & (0x40000 >> (x-3))) && !(white_board[y+3] & (0x40000 >> (x-3)))
-                && ((black_board[y+1] >> 1) & (black_board[y+2] >> 2) & (black_board[y+4] >> 4) & (0x40000 >> x)))
-            return (true);
-    }
-    else if (!is_black && (white_board[y] & (0x40000 >> x))) // 2.221
-    {
-        if (y+4 < BOARD_SIZE && !(black_board[y+1] & (0x40000 >> x)) && !(white_board[y+1] & (0x40000 >> x))
-                && (white_board[y+2] & white_board[y+3] & black_board[y+4] & (0x40000 >> x)))
-            return (true);
-        if (x+4 < BOARD_SIZE && !(black_board[y] & (0x40000 >> (x+1))) && !(white_board[y] & (0x40000 >> (x+1)))
-                && ((white_board[y] << 2) & (white_board[y] << 3) & (black_board[y] << 4) & (0x40000 >> x)))
-            return (true);
-        if (x+4 < BOARD_SIZE && y+4 < BOARD_SIZE && !(black_board[y+1] & (0x40000 >> (x+1))) && !(white_board[y+1] & (0x40000 >> (x+1)))
-                && ((white_board[y+2] << 2) & (white_board[y+3] << 3) & (black_board[y+4] << 4) & (0x40000 >> x)))
-            return (true);
-        if (x-4 < BOARD_SIZE && y+4 < BOARD_SIZE && !(black_board[y+1] & (0x40000 >> (x-1))) && !(white_board[y+1] & (0x40000 >> (x-1)))
-                && ((white_board[y+2] >> 2) & (white_board[y+3] >> 3) & (black_board[y+4] >> 4) & (0x40000 >> x)))
-            return (true);
-    }
-    else if (!is_black && (black_board[y] & (0x40000 >> x))) // 122.2
-    {
-        if (y+4 < BOARD_SIZE && !(black_board[y+3] & (0x40000 >> x)) && !(white_board[y+3] & (0x40000 >> x))
-                && (white_board[y+1] & white_board[y+2] & white_board[y+4] & (0x40000 >> x)))
-            return (true);
-        if (x+4 < BOARD_SIZE && !(black_board[y] & (0x40000 >> (x+3))) && !(white_board[y] & (0x40000 >> (x+3)))
-                && ((white_board[y] << 1) & (white_board[y] << 2) & (white_board[y] << 4) & (0x40000 >> x)))
-            return (true);
-        if (x+4 < BOARD_SIZE && y+4 < BOARD_SIZE && !(black_board[y+3] & (0x40000 >> (x+3))) && !(white_board[y+3] & (0x40000 >> (x+3)))
-                && ((white_board[y+1] << 1) & (white_board[y+2] << 2) & (white_board[y+4] << 4) & (0x40000 >> x)))
-            return (true);
-        if (x-4 < BOARD_SIZE && y+4 < BOARD_SIZE && !(black_board[y+3] & (0x40000 >> (x-3))) && !(white_board[y+3] & (0x40000 >> (x-3)))
-                && ((white_board[y+1] >> 1) & (white_board[y+2] >> 2) & (white_board[y+4] >> 4) & (0x40000 >> x)))
-            return (true);
-    }
-
-    if (is_black && (black_board[y] & (0x40000 >> x))) // 11.12
-    {
-        if (y+4 < BOARD_SIZE && !(black_board[y+2] & (0x40000 >> x)) && !(white_board[y+2] & (0x40000 >> x))
-                && (black_board[y+1] & black_board[y+3] & white_board[y+4] & (0x40000 >> x)))
-            return (true);
-        if (x+4 < BOARD_SIZE && !(black_board[y] & (0x40000 >> (x+2))) && !(white_board[y] & (0x40000 >> (x+2)))
-                && ((black_board[y] << 1) & (black_board[y] << 3) & (white_board[y] << 4) & (0x40000 >> x)))
-            return (true);
-        if (x+4 < BOARD_SIZE && y+4 < BOARD_SIZE && !(black_board[y+2] & (0x40000 >> (x+2))) && !(white_board[y+2] & (0x40000 >> (x+2)))
-                && ((black_board[y+2] << 1) & (black_board[y+3] << 3) & (white_board[y+4] << 4) & (0x40000 >> x)))
-            return (true);
-        if (x-4 < BOARD_SIZE && y+4 < BOARD_SIZE && !(black_board[y+2] & (0x40000 >> (x-2))) && !(white_board[y+2] & (0x40000 >> (x-2)))
-                && ((black_board[y+2] >> 1) & (black_board[y+3] >> 3) & (white_board[y+4] >> 4) & (0x40000 >> x)))
-            return (true);
-    }
-    else if (is_black && (white_board[y] & (0x40000 >> x))) // 21.11
-    {
-        if (y+4 < BOARD_SIZE && !(black_board[y+2] & (0x40000 >> x)) && !(white_board[y+2] & (0x40000 >> x))
-                && (black_board[y+1] & black_board[y+3] & black_board[y+4] & (0x40000 >> x)))
-            return (true);
-        if (x+4 < BOARD_SIZE && !(black_board[y] & (0x40000 >> (x+2))) && !(white_board[y] & (0x40000 >> (x+2)))
-                && ((black_board[y] << 1) & (black_board[y] << 3) & (black_board[y] << 4) & (0x40000 >> x)))
-            return (true);
-        if (x+4 < BOARD_SIZE && y+4 < BOARD_SIZE && !(black_board[y+2] & (0x40000 >> (x+2))) && !(white_board[y+2] & (0x40000 >> (x+2)))
-                && ((black_board[y+1] << 1) & (black_board[y+3] << 3) & (black_board[y+4] << 4) & (0x40000 >> x)))
-            return (true);
-        if (x-4 < BOARD_SIZE && y+4 < BOARD_SIZE && !(black_board[y+2] & (0x40000 >> (x-2))) && !(white_board[y+2] & (0x40000 >> (x-2)))
-                && ((black_board[y+1] >> 1) & (black_board[y+3] >> 3) & (black_board[y+4] >> 4) & (0x40000 >> x)))
-            return (true);
-    }
-    else if (!is_black && (white_board[y] & (0x40000 >> x))) // 22.21
-    {
-        if (y+4 < BOARD_SIZE && !(black_board[y+2] & (0x40000 >> x)) && !(white_board[y+2] & (0x40000 >> x))
-                && (white_board[y+1] & white_board[y+3] & black_board[y+4] & (0x40000 >> x)))
-            return (true);
-        if (x+4 < BOARD_SIZE && !(black_board[y] & (0x40000 >> (x+2))) && !(white_board[y] & (0x40000 >> (x+2)))
-                && ((white_board[y] << 1) & (white_board[y] << 3) & (black_board[y] << 4) & (0x40000 >> x)))
-            return (true);
-        if (x+4 < BOARD_SIZE && y+4 < BOARD_SIZE && !(black_board[y+2] & (0x40000 >> (x+2))) && !(white_board[y+2] & (0x40000 >> (x+2)))
-                && ((white_board[y+1] << 1) & (white_board[y+3] << 3) & (black_board[y+4] << 4) & (0x40000 >> x)))
-            return (true);
-        if (x-4 < BOARD_SIZE && y+4 < BOARD_SIZE && !(black_board[y+2] & (0x40000 >> (x-2))) && !(white_board[y+2] & (0x40000 >> (x-2)))
-                && ((white_board[y+1] >> 1) & (white_board[y+3] >> 3) & (black_board[y+4] >> 4) & (0x40000 >> x)))
-            return (true);
-    }
-    else if (!is_black && (black_board[y] & (0x40000 >> x))) // 12.22
-    {
-        if (y+4 < BOARD_SIZE && !(black_board[y+2] & (0x40000 >> x)) && !(white_board[y+2] & (0x40000 >> x))
-                && (white_board[y+1] & white_board[y+3] & white_board[y+4] & (0x40000 >> x)))
-            return (true);
-        if (x+4 < BOARD_SIZE && !(black_board[y] & (0x40000 >> (x+2))) && !(white_board[y] & (0x40000 >> (x+2)))
-                && ((white_board[y] << 1) & (white_board[y] << 3) & (white_board[y] << 4) & (0x40000 >> x)))
-            return (true);
-        if (x+4 < BOARD_SIZE && y+4 < BOARD_SIZE && !(black_board[y+2] & (0x40000 >> (x+2))) && !(white_board[y+2] & (0x40000 >> (x+2)))
-                && ((white_board[y+1] << 1) & (white_board[y+3] << 3) & (white_board[y+4] << 4) & (0x40000 >> x)))
-            return (true);
-        if (x-4 < BOARD_SIZE && y+4 < BOARD_SIZE && !(black_board[y+2] & (0x40000 >> (x-2))) && !(white_board[y+2] & (0x40000 >> (x-2)))
-                && ((white_board[y+1] >> 1) & (white_board[y+3] >> 3) & (white_board[y+4] >> 4) & (0x40000 >> x)))
-            return (true);
-    }
-    return (false);
-}
-
-bool Board::open_two(int32_t x, int32_t y, bool is_black)
-{
-    if (is_black && (!(black_board[y] & (0x40000 >> x)) && !(white_board[y] & (0x40000 >> x)))) // .11.
-    {
-        if (y+3 < BOARD_SIZE && !(black_board[y+3] & (0x40000 >> x)) && !(white_board[y+3] & (0x40000 >> x))
-                && (black_board[y+1] & black_board[y+2] & (0x40000 >> x)))
-            return (true);
-        if (x+3 < BOARD_SIZE && !(black_board[y] & (0x40000 >> (x+3))) && !(white_board[y] & (0x40000 >> (x+3)))
-                && ((black_board[y] << 1) & (black_board[y] << 2) & (0x40000 >> x)))
-            return (true);
-        if (x+3 < BOARD_SIZE && y+3 < BOARD_SIZE && !(black_board[y+3] & (0x40000 >> (x+3))) && !(white_board[y+3] & (0x40000 >> (x+3)))
-                && ((black_board[y+1] << 1) & (black_board[y+2] << 2) & (0x40000 >> x)))
-            return (true);
-        if (x-3 < BOARD_SIZE && y+3 < BOARD_SIZE && !(black_board[y+3] & (0x40000 >> (x-3))) && !(white_board[y+3] & (0x40000 >> (x-3)))
-                && ((black_board[y+1] >> 1) & (black_board[y+2] >> 2) & (0x40000 >> x)))
-            return (true);
-    }
-    else if (!is_black && (!(black_board[y] & (0x40000 >> x)) && !(white_board[y] & (0x40000 >> x)))) // .22.
+    auto keyCell = [this](int line, int at) {
+        return Color((line_keys[line] >> (at * 2)) & 3);
+    };
+    // Column, up and down positions of every cell, looked up once
+    static const std::array<std::array<Pt, 3>, N * N> projected = [] {
+        std::array<std::array<Pt, 3>, N * N> p;
+        for (int y = 0; y < N; ++y)
+            for (int x = 0; x < N; ++x)
+                p[y * N + x] = {{CL_MAP.at({x, y}), UP_MAP.at({x, y}), DW_MAP.at({x, y})}};
+        return p;
+    }();
+
+    for (int y = 0; y < N; ++y)
+        for (int x = 0; x < N; ++x)
+        {
+            const bool black = black_board[y] & (TOP >> x), white = white_board[y] & (TOP >> x);
+            if (black && white)
+                return fail("black and white stone", x, y);
+            const Color color = black ? BLACK : white ? WHITE : EMPTY;
+            const char cell = '0' + color;
+            const auto &cxy = projected[y * N + x][0];
+            const auto &uxy = projected[y * N + x][1];
+            const auto &dxy = projected[y * N + x][2];
+            if (rows[x][y] != cell || columns[cxy.first][cxy.second] != cell
+                    || up[uxy.first][uxy.second] != cell || down[dxy.first][dxy.second] != cell)
+                return fail("string projections differ from bitboards", x, y);
+            if (keyCell(ROWS_AT + x, y) != color || keyCell(COLUMNS_AT + cxy.first, cxy.second) != color
+                    || keyCell(UP_AT + uxy.first, uxy.second) != color || keyCell(DOWN_AT + dxy.first, dxy.second) != color)
+                return fail("line keys differ from bitboards", x, y);
+
+            int neighbours = x == N / 2 && y == N / 2;
+            for (int dy = -1; dy <= 1; ++dy)
+                for (int dx = -1; dx <= 1; ++dx)
+                    if ((dx || dy) && x + dx >= 0 && x + dx < N && y + dy >= 0 && y + dy < N
+                            && ((black_board[y + dy] | white_board[y + dy]) & (TOP >> (x + dx))))
+                        ++neighbours;
+            if (move_map[y * N + x] != neighbours)
+                return fail("move_map is " + std::to_string(move_map[y * N + x])
+                            + " instead of " + std::to_string(neighbours), x, y);
+        }
+    if (hash != get_hash())
     {
-        if (y+3 < BOARD_SIZE && !(white_board[y+3] & (0x40000 >> x)) && !(black_board[y+3] & (0x40000 >> x))
-                && (white_board[y+1] & white_board[y+2] & (0x40000 >> x)))
-            return (true);
-        if (x+3 < BOARD_SIZE && !(white_board[y] & (0x40000 >> (x+3))) && !(black_board[y] & (0x40000 >> (x+3)))
-                && ((white_board[y] << 1) & (white_board[y] << 2) & (0x40000 >> x)))
-            return (true);
-        if (x+3 < BOARD_SIZE && y+3 < BOARD_SIZE && !(white_board[y+3] & (0x40000 >> (x+3))) && !(black_board[y+3] & (0x40000 >> (x+3)))
-                && ((white_board[y+1] << 1) & (white_board[y+2] << 2) & (0x40000 >> x)))
-            return (true);
-        if (x-3 < BOARD_SIZE && y+3 < BOARD_SIZE && !(white_board[y+3] & (0x40000 >> (x-3))) && !(black_board[y+3] & (0x40000 >> (x-3)))
-                && ((white_board[y+1] >> 1) & (white_board[y+2] >> 2) & (0x40000 >> x)))
-            return (true);
+        if (error)
+            *error = "incremental hash differs from a full recompute";
+        return false;
     }
-    return (false);
+    return true;
 }
 
-bool Board::simple_two(int32_t x, int32_t y, bool is_black)
-{
-    return (false);
-}
-
-int Board::PtrMatchFree3(Board::Color color) const {
+template<int N, class Rules>
+int BasicBoard<N, Rules>::PtrMatchFree3(Color color) const {
 
     if (color == WHITE)
     {
@@ -1262,7 +1105,8 @@ int Board::PtrMatchFree3(Board::Color color) const {
     }
 }
 
-int Board::PtrMatchHalf4(Board::Color color) const {
+template<int N, class Rules>
+int BasicBoard<N, Rules>::PtrMatchHalf4(Color color) const {
     if (color == Color::WHITE)
     {
         return PtrGlobalMatch(rows, wHalf4_1) +
@@ -1340,7 +1184,8 @@ int Board::PtrMatchHalf4(Board::Color color) const {
     }
 }
 
-int Board::PtrMatchHalf3(Board::Color color) const {
+template<int N, class Rules>
+int BasicBoard<N, Rules>::PtrMatchHalf3(Color color) const {
     if (color == WHITE)
     {
         return PtrGlobalMatch(rows, wHalf3_1) +
@@ -1407,7 +1252,8 @@ int Board::PtrMatchHalf3(Board::Color color) const {
     }
 }
 
-bool Board::PtrMatch(const Ptr &ptr) const {
+template<int N, class Rules>
+bool BasicBoard<N, Rules>::PtrMatch(const Ptr &ptr) const {
     if (PtrGlobalMatch(rows, ptr))
         return true;
     else if (PtrGlobalMatch(columns, ptr))
@@ -1420,7 +1266,143 @@ bool Board::PtrMatch(const Ptr &ptr) const {
         return false;
 }
 
-int Board::Eval() const {
+template<int N, class Rules>
+LineEval BasicBoard<N, Rules>::ScoreLine(const char *line, bool projected, int index) {
+    auto match = [&](const Ptr &ptr, MatchOnly only) -> int16_t {
+        if (projected && !PtrProjectedInRange(ptr, index))
+            return 0;
+        return PtrLineMatch(line, ptr, projected, only);
+    };
+    LineEval eval{};
+
+    eval.free4[0] = match(bFree4, NONE);
+    eval.zebra[0] = match(bZebra, NONE);
+    eval.half4[0] = match(bHalf4_1, NONE) + match(bHalf4_2, NONE) + match(bHalf4_3, NONE)
+            + match(bHalf4_4, NONE) + match(bHalf4_5, NONE)
+            + match(bHalf4_6, END) + match(bHalf4_7, BEGIN);
+    eval.free3[0] = match(bFree3_2, NONE) + match(bFree3_3, NONE) - match(bFree3_1, NONE)
+            + match(bFree3_4, NONE) + match(bFree3_5, NONE);
+    eval.half3[0] = match(bHalf3_1, NONE) + match(bHalf3_2, NONE) + match(bHalf3_3, NONE)
+            + match(bHalf3_4, NONE) + match(bHalf3_5, NONE) + match(bHalf3_6, NONE);
+
+    eval.free4[1] = match(wFree4, NONE);
+    eval.zebra[1] = match(wZebra, NONE);
+    eval.half4[1] = match(wHalf4_1, NONE) + match(wHalf4_2, NONE) + match(wHalf4_3, NONE)
+            + match(wHalf4_4, NONE) + match(wHalf4_5, NONE)
+            + match(wHalf4_6, END) + match(wHalf4_7, BEGIN);
+    eval.free3[1] = match(wFree3_2, NONE) + match(wFree3_3, NONE) - match(wFree3_1, NONE)
+            + match(wFree3_4, NONE) + match(wFree3_5, NONE);
+    eval.half3[1] = match(wHalf3_1, NONE) + match(wHalf3_2, NONE) + match(wHalf3_3, NONE)
+            + match(wHalf3_4, NONE) + match(wHalf3_5, NONE) + match(wHalf3_6, NONE);
+    return eval;
+}
+
+// Sums pattern counts of all lines, rescoring only lines changed since the last call
+template<int N, class Rules>
+LineEval BasicBoard<N, Rules>::EvalLines() const {
+    LineEval total{};
+
+    for (int line = 0; line < LINES_COUNT; ++line) {
+        const uint64_t key = lineKey(line);
+        if (scored_keys[line] != key) {
+            auto cached = line_cache.find(key);
+            if (cached != line_cache.end()) {
+                ++line_cache_hit_count;
+                scored_lines[line] = cached->second;
+            } else {
+                ++line_cache_miss_count;
+                if (line_cache.size() >= line_cache_limit)
+                    line_cache.clear();
+                scored_lines[line] = ScoreLine(lineAt(line), line >= UP_AT, (line - UP_AT) % (N+N-1));
+                line_cache[key] = scored_lines[line];
+            }
+            scored_keys[line] = key;
+        }
+        const LineEval &eval = scored_lines[line];
+        for (int c = 0; c < 2; ++c) {
+            total.free4[c] += eval.free4[c];
+            total.zebra[c] += eval.zebra[c];
+            total.half4[c] += eval.half4[c];
+            total.free3[c] += eval.free3[c];
+            total.half3[c] += eval.half3[c];
+        }
+    }
+    return total;
+}
+
+// Stones of one color in a row through x, y along dx, dy, counted up to 6
+template<int N, class Rules>
+int BasicBoard<N, Rules>::run_length(int8_t x, int8_t y, int dx, int dy, bool is_black) const {
+    const Row *stones = is_black ? black_board : white_board;
+    int length{1};
+    for (int side = -1; side <= 1; side += 2)
+        for (int cx = x + side * dx, cy = y + side * dy; length < 6; cx += side * dx, cy += side * dy) {
+            if (cx < 0 || cx >= N || cy < 0 || cy >= N || !(stones[cy] & (TOP >> cx)))
+                break;
+            ++length;
+        }
+    return length;
+}
+
+template<int N, class Rules>
+bool BasicBoard<N, Rules>::is_five(int8_t x, int8_t y, bool is_black) const {
+    static const int DIRS[4][2] = {{1, 0}, {0, 1}, {1, 1}, {1, -1}};
+    if (!((is_black ? black_board : white_board)[y] & (TOP >> x)))
+        return false;
+    const bool exact = Rules::exact_five(is_black);
+    for (const auto &d : DIRS) {
+        const int length = run_length(x, y, d[0], d[1], is_black);
+        if (exact ? length == 5 : length >= 5)
+            return true;
+    }
+    return false;
+}
+
+template<int N, class Rules>
+BoardBase::Result BasicBoard<N, Rules>::five_at(int8_t x, int8_t y) const {
+    if (is_five(x, y, true))
+        return BLACK_WIN;
+    if (is_five(x, y, false))
+        return WHITE_WIN;
+    return NO_RESULT;
+}
+
+template<int N, class Rules>
+BoardBase::Result BasicBoard<N, Rules>::any_five() const {
+    static const int DIRS[4][2] = {{1, 0}, {0, 1}, {1, 1}, {1, -1}};
+    for (int color = 0; color < 2; ++color) {
+        const bool is_black = color == 0;
+        const Mask stones = Mask::of(is_black ? black_board : white_board);
+        for (const auto &d : DIRS) {
+            // Cells starting a run of at least five along d
+            Mask starts = stones;
+            for (int k = 1; k < 5; ++k)
+                starts = starts & stones.shifted(k * d[0], k * d[1]);
+            if (Rules::exact_five(is_black))
+                starts = starts & ~stones.shifted(-d[0], -d[1]) & ~stones.shifted(5 * d[0], 5 * d[1]);
+            if (starts.any())
+                return is_black ? BLACK_WIN : WHITE_WIN;
+        }
+    }
+    return NO_RESULT;
+}
+
+// Five through the last move, or five captured pairs when Rules allow it.
+// A five only appears with the move that makes it, the game is over from there.
+template<int N, class Rules>
+BoardBase::Result BasicBoard<N, Rules>::winner(bool last_move_known) const {
+    const Result five = last_move_known ? five_at(moveX, moveY) : any_five();
+    if (five != NO_RESULT)
+        return five;
+    if (Rules::capture_win && black_captures_count >= 5)
+        return BLACK_WIN;
+    if (Rules::capture_win && white_captures_count >= 5)
+        return WHITE_WIN;
+    return NO_RESULT;
+}
+
+template<int N, class Rules>
+int BasicBoard<N, Rules>::Eval() const {
     // Game ended
     switch (result) {
         case WHITE_WIN:
@@ -1432,26 +1414,32 @@ int Board::Eval() const {
         default:
             break;
     }
-    if (move == WHITE && white_captures_count >= 5)
+    if (Rules::capture_win && move == WHITE && white_captures_count >= 5)
         return +100;
-    else if (move == BLACK && black_captures_count >= 5)
+    else if (Rules::capture_win && move == BLACK && black_captures_count >= 5)
         return -100;
-    else if (PtrMatch(wFive))
-        return +50;
-    else if (PtrMatch(bFive))
-        return -50;
-    else if (move == WHITE && PtrMatch(wZebra))
+    // A five can only run through the last stone played
+    switch (five_at(moveX, moveY)) {
+        case WHITE_WIN:
+            return +50;
+        case BLACK_WIN:
+            return -50;
+        default:
+            break;
+    }
+    const LineEval lines = EvalLines();
+    if (move == WHITE && lines.zebra[1])
         return +30;
-    else if (move == BLACK && PtrMatch(bZebra))
+    else if (move == BLACK && lines.zebra[0])
         return -30;
     int evalScore{0};
 
-    auto half4sW = PtrMatchHalf4(WHITE);
-    auto half4sB = PtrMatchHalf4(BLACK);
+    auto half4sW = lines.half4[1];
+    auto half4sB = lines.half4[0];
     // Free 4 what is win or flanked four and your turn what is almost win
-    if (PtrMatch(wFree4) || (half4sW && move == WHITE))
+    if (lines.free4[1] || (half4sW && move == WHITE))
         return +40;
-    else if (PtrMatch(bFree4) || (half4sB && move == BLACK))
+    else if (lines.free4[0] || (half4sB && move == BLACK))
         return -40;
     else if (half4sW > 1)
         return +35;
@@ -1459,8 +1447,8 @@ int Board::Eval() const {
         return -35;
     evalScore += (half4sW - half4sB) * 2;
 
-    auto free3sW = PtrMatchFree3(WHITE);
-    auto free3sB = PtrMatchFree3(BLACK);
+    auto free3sW = lines.free3[1];
+    auto free3sB = lines.free3[0];
     // Free 3 what is win or flanked four and your turn what is almost win
     if (free3sW && move == WHITE)
         return +15;
@@ -1473,12 +1461,20 @@ int Board::Eval() const {
     evalScore += (free3sW - free3sB) * 2;
 
     // Half 3 what is not a win but counts or flanked four and your turn what is not almost win
-    auto half3sW = PtrMatchHalf3(WHITE);
-    auto half3sB = PtrMatchHalf3(BLACK);
+    auto half3sW = lines.half3[1];
+    auto half3sB = lines.half3[0];
     evalScore += (half3sW - half3sB);
 
-    // Future captures for available moves // TODO cW - cB * 4
+    if (Rules::captures)
+    {
+        // Future captures for available moves
+        const CaptureMap<N> &captures = capture_map();
+        evalScore += (captures.captures[1].count() - captures.captures[0].count()) * 4;
 
-    evalScore += ((int)white_captures_count - (int)black_captures_count) * 14;
+        evalScore += ((int)white_captures_count - (int)black_captures_count) * 14;
+    }
     return (evalScore);
 }
+
+# define GOMOKU_INSTANTIATE_BOARD(N, R) template class BasicBoard<N, R>;
+GOMOKU_FOR_EACH_VARIANT(GOMOKU_INSTANTIATE_BOARD)
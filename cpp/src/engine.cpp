@@ -0,0 +1,63 @@
+#include "engine.hpp"
+
+namespace {
+
+template<int N, class Rules>
+class BasicEngine : public Engine
+{
+public:
+    int size() const override { return N; }
+    const char *rules() const override { return Rules::name; }
+
+    void reset() override { game.reset(); }
+    int8_t getToken(int8_t x, int8_t y) const override { return game.getToken(x, y); }
+    bool setToken(int8_t x, int8_t y, int8_t v) override { return game.setToken(x, y, v); }
+    bool forceToken(int8_t x, int8_t y, int8_t v) override { return game.forceToken(x, y, v); }
+    bool takeBack(int8_t x, int8_t y) override { return game.takeBack(x, y); }
+    uint64_t capturedPairs(int8_t v) const override {
+        return v == BLACK_STONE ? game.board.black_captures_count : game.board.white_captures_count;
+    }
+    BoardBase::Result winner(bool lastMoveKnown) const override { return game.board.winner(lastMoveKnown); }
+    bool isFive(int8_t x, int8_t y, int8_t v) const override { return game.board.is_five(x, y, v == BLACK_STONE); }
+    int8_t toMove() const override { return game.board.move == BLACK_STONE ? WHITE_STONE : BLACK_STONE; }
+
+    bool readBoard(std::istream &in) override {
+        game.reset();
+        return static_cast<bool>(in >> game.board);
+    }
+    void writeBoard(std::ostream &out) const override { out << game.board; }
+
+    Move predictMove(int8_t v, const SearchLimits &limits) override { return game.predictMove(v, limits); }
+    std::vector<RootLine> analyze(int8_t v, int count, const SearchLimits &limits) override {
+        return game.analyze(v, count, limits);
+    }
+    const SearchStats &stats() const override { return game.stats(); }
+#ifdef GOMOKU_SEARCH_TRACE
+    bool traceTo(TraceWriter *writer) override {
+        game.board.trace = writer;
+        return true;
+    }
+#else
+    bool traceTo(TraceWriter *) override { return false; }
+#endif
+    bool useTable(TranspositionTable *table) override {
+        if (table && (table->board_size() != N || table->rules() != Rules::name))
+            return false;
+        game.board.table = table;
+        return true;
+    }
+private:
+    BasicGame<N, Rules> game;
+};
+
+}
+
+std::unique_ptr<Engine> Engine::create(int size, const std::string &rules)
+{
+# define GOMOKU_CREATE_ENGINE(N, R) \
+    if (size == N && rules == R::name) \
+        return std::unique_ptr<Engine>(new BasicEngine<N, R>());
+    GOMOKU_FOR_EACH_VARIANT(GOMOKU_CREATE_ENGINE)
+# undef GOMOKU_CREATE_ENGINE
+    return nullptr;
+}
@@ -1,43 +1,184 @@
 #include "game.hpp"
 #include <chrono>
 
-int8_t Game::getToken(int8_t x, int8_t y)
+template<int N, class Rules>
+int8_t BasicGame<N, Rules>::getToken(int8_t x, int8_t y) const
 {
-    if (board.black_board[y] & 0x40000 >> x)
+    if (board.black_board[y] & BasicBoard<N, Rules>::TOP >> x)
         return (BLACK_STONE);
-    else if (board.white_board[y] & 0x40000 >> x)
+    else if (board.white_board[y] & BasicBoard<N, Rules>::TOP >> x)
         return (WHITE_STONE);
     else
         return (EMPTY_STONE);
 }
 
-bool Game::setToken(int8_t x, int8_t y, int8_t v)
+template<int N, class Rules>
+bool BasicGame<N, Rules>::setToken(int8_t x, int8_t y, int8_t v)
 {
-    uint8_t stub;
+    return play(x, y, v, true);
+}
+
+template<int N, class Rules>
+bool BasicGame<N, Rules>::forceToken(int8_t x, int8_t y, int8_t v)
+{
+    if (v == EMPTY_STONE || getToken(x, y) != EMPTY_STONE)
+        return (false);
+    return play(x, y, v, false);
+}
 
-    if (v == BLACK_STONE)
-        return(board.place_stone_on_board(x,y,true,&stub));
-    else if (v == WHITE_STONE)
-        return(board.place_stone_on_board(x,y,false,&stub));
+template<int N, class Rules>
+bool BasicGame<N, Rules>::play(int8_t x, int8_t y, int8_t v, bool checked)
+{
+    uint8_t captures{0};
+
+    if (v == EMPTY_STONE)
+    {
+        const int8_t was = getToken(x, y);
+        if (was == EMPTY_STONE)
+            return (true);
+        board.remove_stone_from_board(x, y, was == BLACK_STONE);
+        history.clear();
+        if (listener)
+        {
+            changes.cells.assign(1, {CellChange::REMOVED, x, y, was});
+            changes.move = static_cast<int16_t>(x | y << 8);
+            changes.previous = last_move;
+        }
+    }
     else
-        return(board.remove_stone_from_board(x,y,true));
+    {
+        if (checked && !board.is_legal_move(x, y, v == BLACK_STONE))
+            return (false);
+        history.emplace_back();
+        board.make_move(x, y, v == BLACK_STONE, true, history.back());
+        captures = history.back().captures;
+        board.moveX = x;
+        board.moveY = y;
+        board.move = v;
+        const int16_t move = static_cast<int16_t>(x | y << 8);
+        if (listener)
+        {
+            changes.cells.assign(1, {CellChange::PLACED, x, y, v});
+            for (int i = 0; i < 8; ++i)
+                if (captures & 1 << i)
+                    for (int8_t k = 1; k <= 2; ++k)
+                        changes.cells.push_back({CellChange::CAPTURED, static_cast<int8_t>(x + CAPTURE_DIRS[i][0] * k),
+                                                 static_cast<int8_t>(y + CAPTURE_DIRS[i][1] * k),
+                                                 static_cast<int8_t>(v == BLACK_STONE ? WHITE_STONE : BLACK_STONE)});
+            changes.move = move;
+            changes.previous = last_move;
+        }
+        last_move = move;
+    }
+    if (listener)
+    {
+        changes.cleared = false;
+        changes.black_captures = board.black_captures_count;
+        changes.white_captures = board.white_captures_count;
+        listener(changes);
+    }
+    return (true);
 }
 
-Move Game::predictMove(int8_t v)
+template<int N, class Rules>
+bool BasicGame<N, Rules>::takeBack(int8_t x, int8_t y)
+{
+    if (history.empty() || history.back().x != x || history.back().y != y)
+        return (false);
+    const UndoRecord undo = history.back();
+    history.pop_back();
+    board.unmake_move(undo);
+    const int16_t move = static_cast<int16_t>(x | y << 8);
+    const int8_t v = undo.is_black ? BLACK_STONE : WHITE_STONE;
+    if (listener)
+    {
+        changes.cells.assign(1, {CellChange::REMOVED, x, y, v});
+        for (int i = 0; i < 8; ++i)
+            if (undo.captures & 1 << i)
+                for (int8_t k = 1; k <= 2; ++k)
+                    changes.cells.push_back({CellChange::PLACED, static_cast<int8_t>(x + CAPTURE_DIRS[i][0] * k),
+                                             static_cast<int8_t>(y + CAPTURE_DIRS[i][1] * k),
+                                             static_cast<int8_t>(undo.is_black ? WHITE_STONE : BLACK_STONE)});
+        changes.cleared = false;
+        changes.move = move;
+        changes.previous = last_move;
+        changes.black_captures = board.black_captures_count;
+        changes.white_captures = board.white_captures_count;
+        listener(changes);
+    }
+    last_move = history.empty() ? -1 : static_cast<int16_t>(history.back().x | history.back().y << 8);
+    return (true);
+}
+
+template<int N, class Rules>
+Move BasicGame<N, Rules>::predictMove(int8_t v)
 {
     int32_t move{0};
     auto start{std::chrono::high_resolution_clock::now()};
     move = v == BLACK_STONE ? board.ai_move(true) : board.ai_move(false);
     auto finish{std::chrono::high_resolution_clock::now()};
     std::chrono::duration<double> elapsed = finish - start;
-    return Move(true, (move & 0xFF), (move & 0xFF10) >> 8, v, elapsed.count());
+    Move predicted(true, (move & 0xFF), (move & 0xFF10) >> 8, v, elapsed.count());
+    predicted.stats = board.stats;
+    return predicted;
+}
+
+template<int N, class Rules>
+Move BasicGame<N, Rules>::predictMove(int8_t v, const SearchLimits &limits)
+{
+    const SearchLimits prev = board.limits;
+    board.limits = limits;
+    Move move = predictMove(v);
+    board.limits = prev;
+    return move;
 }
 
-void Game::reset()
+template<int N, class Rules>
+std::vector<RootLine> BasicGame<N, Rules>::analyze(int8_t v, int count)
+{
+    return board.analyze(v == BLACK_STONE, count);
+}
+
+template<int N, class Rules>
+std::vector<RootLine> BasicGame<N, Rules>::analyze(int8_t v, int count, const SearchLimits &limits)
+{
+    const SearchLimits prev = board.limits;
+    board.limits = limits;
+    std::vector<RootLine> lines = analyze(v, count);
+    board.limits = prev;
+    return lines;
+}
+
+template<int N, class Rules>
+const SearchStats &BasicGame<N, Rules>::stats() const
+{
+    return board.stats;
+}
+
+template<int N, class Rules>
+void BasicGame<N, Rules>::reset()
 {
     board.reset();
+    last_move = -1;
+    history.clear();
+    if (listener)
+    {
+        changes = MoveChanges();
+        changes.cleared = true;
+        listener(changes);
+    }
 }
 
-Board::Result Game::result() {
+template<int N, class Rules>
+BoardBase::Result BasicGame<N, Rules>::result() {
     return board.result;
 }
+
+template<int N, class Rules>
+void BasicGame<N, Rules>::setListener(std::function<void(const MoveChanges &)> listener)
+{
+    this->listener = std::move(listener);
+}
+
+# define GOMOKU_INSTANTIATE_GAME(N, R) template class BasicGame<N, R>;
+GOMOKU_FOR_EACH_VARIANT(GOMOKU_INSTANTIATE_GAME)
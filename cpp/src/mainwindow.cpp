@@ -3,7 +3,6 @@
 #include "mainwindow.hpp"
 #include "./ui_mainwindow.h"
 #include "Scene.hpp"
-#include "Token.hpp"
 #include "game.hpp"
 
 MainWindow::MainWindow(Game *game, QWidget *parent)
@@ -29,10 +28,16 @@ MainWindow::MainWindow(Game *game, QWidget *parent)
     connect(ui->actionShowCapture, SIGNAL(triggered(bool)), this, SLOT(onActionShowCapture()));
     connect(ui->actionShowUnderCapture, SIGNAL(triggered(bool)), this, SLOT(onActionShowUnderCapture()));
     connect(ui->actionShowTowFreeThree, SIGNAL(triggered(bool)), this, SLOT(onActionShowTowFreeThree()));
+    connect(ui->actionShowForbidden, SIGNAL(triggered(bool)), this, SLOT(onActionShowForbidden()));
     connect(ui->actionHelpWithMove, SIGNAL(triggered(bool)), this, SLOT(onActionHelpWithMove()));
+    connect(ui->actionMoveNow, SIGNAL(triggered(bool)), scene, SLOT(onMoveNow()));
+    connect(ui->actionAnalyze, SIGNAL(triggered(bool)), scene, SLOT(onAnalyze()));
 
 
     connect(scene, SIGNAL(resetted()), this, SLOT(reset()));
+    connect(scene, SIGNAL(capturesChanged()), this, SLOT(reset()));
+    connect(scene, SIGNAL(thinkingChanged(bool)), this, SLOT(onThinkingChanged(bool)));
+    connect(scene, SIGNAL(progressed(SearchProgress)), this, SLOT(onSearchProgress(SearchProgress)));
 
     ui->graphicsView->setScene(scene);
     ui->graphicsView->setMouseTracking(true);
@@ -62,7 +67,6 @@ void MainWindow::onActionRestart() {
     if (!game)
         return;
     game->reset();
-    scene->reset();
     scene->startGame();
 }
 
@@ -111,6 +115,7 @@ void MainWindow::onActionLoad() {
         y++;
     }
     scene->game->board.print();
+    scene->onLoaded();
 }
 
 void MainWindow::onActionSave() {
@@ -119,8 +124,7 @@ void MainWindow::onActionSave() {
     for (int i = 0; i < GSIZE; ++i) {
         QJsonArray row;
         for (int j = 0; j < GSIZE; ++j) {
-            auto t = scene->getToken(j, i);
-            row.append(Scene::intFromTokenColor(t->def.color));
+            row.append(Scene::intFromTokenColor(scene->getToken(j, i).color));
         }
         rows.append(row);
     }
@@ -147,6 +151,8 @@ void MainWindow::onActionDevMode() {
 }
 
 void MainWindow::SetAiTitle() {
+    const SearchStats &stats = scene->game->stats();
+    auto lineCacheProbes = stats.line_cache_hits + stats.line_cache_misses;
     ui->aiTitle->setText(QString(
                 "<html><head/><body>"
                 "<h1>Hi there!</h1>"
@@ -154,19 +160,21 @@ void MainWindow::SetAiTitle() {
                 "<p>Last Move took: %1 sec</p>"
                 "<p>Cache count: %2 </p>"
                 "<p>Cache hit count: %3 </p>"
-                "<p>Prune count: %4 </p>"
-                "<p>Node count: %5 </p>"
-                "<p>Black captures: %6 </p>"
-                "<p>White captures: %7 </p>"
-                "<p>Game in dev mode: %8 </p>"
+                "<p>Line cache hit rate: %4 % </p>"
+                "<p>Prune count: %5 </p>"
+                "<p>Node count: %6 </p>"
+                "<p>Black captures: %7 </p>"
+                "<p>White captures: %8 </p>"
+                "<p>Game in dev mode: %9 </p>"
                 "</body></html>"
         )
         .arg(
                 QString::number(scene->lastPredictedMove.tookSecond, 'g', 4),
-                QString::number(scene->game->board.hash_map.size()),
-                QString::number(scene->game->board.cache_hit_count),
-                QString::number(scene->game->board.pruned_count),
-                QString::number(scene->game->board.nodes_count),
+                QString::number(stats.tt_size),
+                QString::number(stats.tt_hits),
+                QString::number(lineCacheProbes ? 100.0 * stats.line_cache_hits / lineCacheProbes : 0, 'f', 1),
+                QString::number(stats.cutoffs),
+                QString::number(stats.nodes),
                 QString::number(scene->game->board.black_captures_count),
                 QString::number(scene->game->board.white_captures_count),
                 scene->devMode ? "<span style=\" color:#cc0000;\">True</span>" : "False"
@@ -186,104 +194,27 @@ void MainWindow::onActionPvPMode() {
     scene->reset();
 }
 
-void MainWindow::onActionShowFreeFour() {
+// Highlights the empty cells set in cells, or the stones with stones
+void MainWindow::showCells(const BitRows<GSIZE> &cells, QColor color, bool stones) {
     for (int y = 0; y < GSIZE; ++y) {
         for (int x = 0; x < GSIZE; ++x) {
-            if (game->getToken(x, y))
+            if ((game->getToken(x, y) != 0) != stones)
                 continue;
-            auto match = false;
-            for (const auto &dxy : ALL_DIRS) {
-                char flat[BOARD_SIZE];
-                Patterns::getFlat(
-                        x, y,
-                        dxy[0], dxy[1],
-                        Scene::WHITE, 5,
-                        game->board.black_board,
-                        game->board.white_board,
-                        flat
-                );
-                if (Patterns::isFourFree(Scene::WHITE, flat)) {
-                    match = true;
-                    break;
-                }
-            }
-            auto t = scene->getToken(x, y);
-            t->setDef({
-                              t->def.color,
-                              QColor(!match ? Qt::transparent : Qt::yellow),
-                              t->def.text}
-            );
-            t->update();
+            scene->setHighlight(x, y, !cells.test(x, y) ? QColor(Qt::transparent) : color);
         }
     }
-    scene->update();
+}
+
+void MainWindow::onActionShowFreeFour() {
+    showCells(game->board.threat_map().free_four[1], Qt::yellow);
 }
 
 void MainWindow::onActionShowFreeTow() {
-    for (int y = 0; y < GSIZE; ++y) {
-        for (int x = 0; x < GSIZE; ++x) {
-            if (game->getToken(x, y))
-                continue;
-            auto match = false;
-            for (const auto &dxy : ALL_DIRS) {
-                char flat[BOARD_SIZE];
-                Patterns::getFlat(
-                        x, y,
-                        dxy[0], dxy[1],
-                        Scene::WHITE, 3,
-                        game->board.black_board,
-                        game->board.white_board,
-                        flat
-                );
-                if (Patterns::isTowFree(Scene::WHITE, flat)) {
-                    match = true;
-                    break;
-                }
-            }
-            auto t = scene->getToken(x, y);
-            t->setDef({
-                              t->def.color,
-                              QColor(!match ? Qt::transparent : Qt::yellow),
-                              t->def.text}
-            );
-            t->update();
-        }
-    }
-    scene->update();
+    showCells(game->board.threat_map().free_two[1], Qt::yellow);
 }
 
 void MainWindow::onActionShowFreeThree() {
-    for (int y = 0; y < GSIZE; ++y) {
-        for (int x = 0; x < GSIZE; ++x) {
-            auto t = scene->getToken(x, y);
-            if (game->getToken(x, y))
-                continue;
-            auto match = false;
-            for (const auto &dxy : ALL_DIRS) {
-                char flat[BOARD_SIZE];
-                Patterns::getFlat(
-                        x, y,
-                        dxy[0], dxy[1],
-                        Scene::WHITE, 5,
-                        game->board.black_board,
-                        game->board.white_board,
-                        flat
-                );
-                if (Patterns::isThreeFree(Scene::WHITE, flat)) {
-                    match = true;
-                    break;
-                }
-            }
-
-            t->setDef({
-                              t->def.color,
-                              QColor(!match ? Qt::transparent : Qt::yellow),
-                              t->def.text}
-            );
-            t->update();
-        }
-    }
-    scene->update();
+    showCells(game->board.threat_map().free_three[1], Qt::yellow);
 }
 
 void MainWindow::reset() {
@@ -291,121 +222,23 @@ void MainWindow::reset() {
 }
 
 void MainWindow::onActionShowWin() {
-    for (int y = 0; y < GSIZE; ++y) {
-        for (int x = 0; x < GSIZE; ++x) {
-            auto t = scene->getToken(x, y);
-            if (!game->getToken(x, y))
-                continue;
-            auto match = game->board.PtrLocal5Match(Board::BLACK, x, y);
-            t->setDef({
-                              t->def.color,
-                              QColor(!match ? Qt::transparent : Qt::yellow),
-                              t->def.text}
-            );
-            t->update();
-        }
-    }
-    scene->update();
+    showCells(game->board.threat_map().five[0], Qt::yellow, true);
 }
 
 void MainWindow::onActionShowCapture() {
-    for (int y = 0; y < GSIZE; ++y) {
-        for (int x = 0; x < GSIZE; ++x) {
-            auto t = scene->getToken(x, y);
-            if (game->getToken(x, y))
-                continue;
-            auto match = false;
-            for (const auto &dxy : ALL_DIRS) {
-                char flat[BOARD_SIZE];
-                Patterns::getFlat(
-                        x, y,
-                        dxy[0], dxy[1],
-                        Scene::WHITE, 3,
-                        game->board.black_board,
-                        game->board.white_board,
-                        flat
-                );
-                if (Patterns::isCapture(Scene::WHITE, flat)) {
-                    match = true;
-                    break;
-                }
-            }
-
-            t->setDef({
-                              t->def.color,
-                              QColor(!match ? Qt::transparent : Qt::yellow),
-                              t->def.text}
-            );
-            t->update();
-        }
-    }
-    scene->update();
+    showCells(game->board.capture_map().captures[1], Qt::yellow);
 }
 
 void MainWindow::onActionShowUnderCapture() {
-    for (int y = 0; y < GSIZE; ++y) {
-        for (int x = 0; x < GSIZE; ++x) {
-            auto t = scene->getToken(x, y);
-            if (game->getToken(x, y))
-                continue;
-            auto match = false;
-            for (const auto &dxy : ALL_DIRS) {
-                char flat[BOARD_SIZE];
-                Patterns::getFlat(
-                        x, y,
-                        dxy[0], dxy[1],
-                        Scene::WHITE, 3,
-                        game->board.black_board,
-                        game->board.white_board,
-                        flat
-                );
-                if (Patterns::isUnderCapture(Scene::WHITE, flat)) {
-                    match = true;
-                    break;
-                }
-            }
-
-            t->setDef({
-                              t->def.color,
-                              QColor(!match ? Qt::transparent : Qt::yellow),
-                              t->def.text}
-            );
-            t->update();
-        }
-    }
-    scene->update();
+    showCells(game->board.capture_map().exposed[1], Qt::yellow);
 }
 
 void MainWindow::onActionShowTowFreeThree() {
-    for (int y = 0; y < GSIZE; ++y) {
-        for (int x = 0; x < GSIZE; ++x) {
-            auto t = scene->getToken(x, y);
-            if (game->getToken(x, y))
-                continue;
-            auto match = 0;
-            for (const auto &dxy : ALL_DIRS) {
-                char flat[BOARD_SIZE];
-                Patterns::getFlat(
-                        x, y,
-                        dxy[0], dxy[1],
-                        Scene::WHITE, 5,
-                        game->board.black_board,
-                        game->board.white_board,
-                        flat
-                );
-                if (Patterns::isThreeFree(Scene::WHITE, flat)) {
-                    match++;
-                }
-            }
-            t->setDef({
-                  t->def.color,
-                  QColor(match < 2 ? Qt::transparent : Qt::yellow),
-                  t->def.text}
-            );
-            t->update();
-        }
-    }
-    scene->update();
+    showCells(game->board.threat_map().double_three[1], Qt::yellow);
+}
+
+void MainWindow::onActionShowForbidden() {
+    showCells(game->board.forbidden_moves(false), Qt::red);
 }
 
 void MainWindow::quit() {
@@ -416,3 +249,32 @@ void MainWindow::quit() {
 void MainWindow::onActionHelpWithMove() {
     scene->onHelpMove();
 }
+
+void MainWindow::onThinkingChanged(bool thinking) {
+    // Everything that reads or changes the game waits for the search
+    for (auto action : {ui->actionRestart, ui->actionLoad, ui->actionDevMode, ui->actionShowMask,
+                        ui->actionPvPMode, ui->actionShowFreeTow, ui->actionShowFreeThree,
+                        ui->actionShowFreeFour, ui->actionShowWin, ui->actionShowCapture,
+                        ui->actionShowUnderCapture, ui->actionShowTowFreeThree,
+                        ui->actionShowForbidden, ui->actionHelpWithMove, ui->actionAnalyze})
+        action->setEnabled(!thinking);
+    ui->actionMoveNow->setEnabled(thinking);
+    if (thinking)
+        ui->statusbar->showMessage("Thinking...");
+    else {
+        ui->statusbar->clearMessage();
+        // Counters of the search just finished
+        SetAiTitle();
+    }
+}
+
+void MainWindow::onSearchProgress(SearchProgress progress) {
+    ui->statusbar->showMessage(QString("Thinking: depth %1, move %2/%3, best %4,%5 (%6), %7 knodes/s")
+        .arg(progress.depth)
+        .arg(progress.root_moves_done)
+        .arg(progress.root_moves)
+        .arg(progress.best_move & 0xFF)
+        .arg(progress.best_move >> 8)
+        .arg(progress.score)
+        .arg(progress.seconds > 0 ? static_cast<qulonglong>(progress.nodes / progress.seconds / 1000) : 0));
+}
@@ -0,0 +1,205 @@
+#include "posdb.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "engine.hpp"
+
+static_assert(sizeof(PackedPosition) == 112, "PackedPosition is part of the file format");
+static_assert(sizeof(PositionDbHeader) == 16, "PositionDbHeader is part of the file format");
+
+namespace {
+
+constexpr int CELLS = POSDB_MAX_SIZE * POSDB_MAX_SIZE;
+constexpr int MAX_CAPTURES = 32;
+
+// Keys of the format, a fixed seed rather than the board's random table
+struct KeyTable
+{
+    uint64_t stones[2][CELLS];
+    uint64_t white_to_move;
+    uint64_t captures[2][MAX_CAPTURES];
+
+    KeyTable() {
+        uint64_t state = 0x9E3779B97F4A7C15ull;
+        auto next = [&state]() {
+            // splitmix64
+            uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            return z ^ (z >> 31);
+        };
+        for (auto &color : stones)
+            for (auto &k : color)
+                k = next();
+        white_to_move = next();
+        for (auto &color : captures)
+            for (auto &k : color)
+                k = next();
+    }
+};
+
+const KeyTable &keys()
+{
+    static const KeyTable table;
+    return table;
+}
+
+bool keyLess(const PackedPosition &a, const PackedPosition &b)
+{
+    if (a.key != b.key)
+        return a.key < b.key;
+    return std::memcmp(a.cells, b.cells, POSDB_CELL_BYTES + 3) < 0;
+}
+
+}
+
+bool PackedPosition::same(const PackedPosition &other) const
+{
+    // cells, to_move and both capture counts are contiguous
+    return std::memcmp(cells, other.cells, POSDB_CELL_BYTES + 3) == 0;
+}
+
+PackedPosition pack_position(int size, const int8_t *cells, int8_t to_move, int black_captures, int white_captures)
+{
+    PackedPosition p{};
+    const KeyTable &table = keys();
+    for (int i = 0; i < size * size; ++i) {
+        const int v = cells[i];
+        if (v != BLACK_STONE && v != WHITE_STONE)
+            continue;
+        p.cells[i >> 2] |= static_cast<uint8_t>(v << ((i & 3) * 2));
+        p.key ^= table.stones[v - 1][i];
+    }
+    p.to_move = static_cast<uint8_t>(to_move);
+    p.black_captures = static_cast<uint8_t>(std::min(black_captures, MAX_CAPTURES - 1));
+    p.white_captures = static_cast<uint8_t>(std::min(white_captures, MAX_CAPTURES - 1));
+    if (to_move == WHITE_STONE)
+        p.key ^= table.white_to_move;
+    p.key ^= table.captures[0][p.black_captures] ^ table.captures[1][p.white_captures];
+    p.count = 1;
+    return p;
+}
+
+PackedPosition pack_position(const Engine &engine)
+{
+    const int size = engine.size();
+    int8_t cells[CELLS];
+    for (int y = 0; y < size; ++y)
+        for (int x = 0; x < size; ++x)
+            cells[y * size + x] = engine.getToken(x, y);
+    return pack_position(size, cells, engine.toMove(), static_cast<int>(engine.capturedPairs(BLACK_STONE)),
+                         static_cast<int>(engine.capturedPairs(WHITE_STONE)));
+}
+
+bool PositionDbBuilder::write(const std::string &path, uint64_t *unique)
+{
+    if (size < 5 || size > POSDB_MAX_SIZE)
+        return false;
+    std::sort(positions.begin(), positions.end(), keyLess);
+    size_t kept = 0;
+    for (size_t i = 0; i < positions.size(); ++i) {
+        if (kept && positions[kept - 1].key == positions[i].key && positions[kept - 1].same(positions[i]))
+            positions[kept - 1].count += positions[i].count;
+        else
+            positions[kept++] = positions[i];
+    }
+    positions.resize(kept);
+    if (unique)
+        *unique = kept;
+
+    const std::string temporary = path + ".tmp";
+    std::FILE *file = std::fopen(temporary.c_str(), "wb");
+    if (!file)
+        return false;
+    PositionDbHeader header{};
+    std::memcpy(header.magic, "GPDB", 4);
+    header.version = POSDB_VERSION;
+    header.board_size = static_cast<uint8_t>(size);
+    header.count = kept;
+    bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1
+              && std::fwrite(positions.data(), sizeof(PackedPosition), kept, file) == kept;
+    ok = std::fclose(file) == 0 && ok;
+    if (!ok || std::rename(temporary.c_str(), path.c_str())) {
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+PositionDb::~PositionDb()
+{
+    close();
+}
+
+bool PositionDb::open(const std::string &path)
+{
+    close();
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        last_error = "cannot open " + path;
+        return false;
+    }
+    struct stat st{};
+    if (fstat(fd, &st) || static_cast<size_t>(st.st_size) < sizeof(PositionDbHeader)) {
+        ::close(fd);
+        last_error = path + " is not a position database";
+        return false;
+    }
+    void *mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        last_error = "cannot map " + path;
+        return false;
+    }
+    data = static_cast<const uint8_t *>(mapped);
+    length = st.st_size;
+
+    const auto &header = *reinterpret_cast<const PositionDbHeader *>(data);
+    if (std::memcmp(header.magic, "GPDB", 4) || header.version != POSDB_VERSION
+            || header.board_size < 5 || header.board_size > POSDB_MAX_SIZE
+            || header.count != (length - sizeof(PositionDbHeader)) / sizeof(PackedPosition)
+            || (length - sizeof(PositionDbHeader)) % sizeof(PackedPosition)) {
+        close();
+        last_error = path + " is not a complete version " + std::to_string(POSDB_VERSION) + " position database";
+        return false;
+    }
+    entries = reinterpret_cast<const PackedPosition *>(data + sizeof(PositionDbHeader));
+    entries_count = header.count;
+    size = header.board_size;
+    last_error.clear();
+    return true;
+}
+
+void PositionDb::close()
+{
+    if (data)
+        munmap(const_cast<uint8_t *>(data), length);
+    data = nullptr;
+    length = 0;
+    entries = nullptr;
+    entries_count = 0;
+    size = 0;
+}
+
+std::pair<const PackedPosition *, const PackedPosition *> PositionDb::equal_range(uint64_t key) const
+{
+    const PackedPosition *first = std::lower_bound(begin(), end(), key,
+        [](const PackedPosition &p, uint64_t k) { return p.key < k; });
+    const PackedPosition *last = first;
+    while (last != end() && last->key == key)
+        ++last;
+    return {first, last};
+}
+
+const PackedPosition *PositionDb::find(const PackedPosition &position) const
+{
+    const auto range = equal_range(position.key);
+    for (const PackedPosition *p = range.first; p != range.second; ++p)
+        if (p->same(position))
+            return p;
+    return nullptr;
+}
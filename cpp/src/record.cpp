@@ -0,0 +1,273 @@
+#include "record.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+// Stored as indexes, never reorder
+const char *const RULES[] = {ProCaptures::name, Freestyle::name, StandardGomoku::name, RenjuLike::name};
+constexpr int RULES_COUNT = sizeof(RULES) / sizeof(*RULES);
+
+int rulesIndex(const std::string &name)
+{
+    for (int i = 0; i < RULES_COUNT; ++i)
+        if (name == RULES[i])
+            return i;
+    return -1;
+}
+
+size_t columnsBytes(int moves, uint8_t flags)
+{
+    return (flags & RECORD_NODES ? moves * sizeof(uint64_t) : 0)
+           + (flags & RECORD_TIME ? moves * sizeof(uint32_t) : 0)
+           + (flags & RECORD_SCORE ? moves * sizeof(int32_t) : 0);
+}
+
+size_t gameBytes(int moves, uint8_t flags)
+{
+    const size_t bytes = sizeof(RecordGameHeader) + columnsBytes(moves, flags) + (moves * 9 + 7) / 8;
+    return (bytes + 7) & ~size_t(7);
+}
+
+uint8_t flagsOf(const GameRecord &game)
+{
+    return (game.nodes.empty() ? 0 : RECORD_NODES) | (game.seconds.empty() ? 0 : RECORD_TIME)
+           | (game.scores.empty() ? 0 : RECORD_SCORE);
+}
+
+template<class T>
+void append(std::vector<uint8_t> &out, const T &value)
+{
+    const uint8_t *p = reinterpret_cast<const uint8_t *>(&value);
+    out.insert(out.end(), p, p + sizeof(T));
+}
+
+}
+
+size_t record_game_bytes(const GameRecord &game)
+{
+    const size_t moves = game.moves.size();
+    if (game.size < 5 || game.size > RECORD_MAX_SIZE || rulesIndex(game.rules) < 0 || moves > UINT16_MAX
+            || (!game.seconds.empty() && game.seconds.size() != moves)
+            || (!game.scores.empty() && game.scores.size() != moves)
+            || (!game.nodes.empty() && game.nodes.size() != moves))
+        return 0;
+    for (int16_t move : game.moves)
+        if ((move & 0xFF) >= game.size || (move >> 8) >= game.size || move < 0)
+            return 0;
+    return gameBytes(static_cast<int>(moves), flagsOf(game));
+}
+
+const char *RecordView::rules() const
+{
+    return RULES[header().rules];
+}
+
+const uint64_t *RecordView::nodes() const
+{
+    if (!(header().flags & RECORD_NODES))
+        return nullptr;
+    return reinterpret_cast<const uint64_t *>(data + sizeof(RecordGameHeader));
+}
+
+const uint32_t *RecordView::micros() const
+{
+    if (!(header().flags & RECORD_TIME))
+        return nullptr;
+    return reinterpret_cast<const uint32_t *>(data + sizeof(RecordGameHeader)
+                                              + columnsBytes(moves(), header().flags & RECORD_NODES));
+}
+
+const int32_t *RecordView::scores() const
+{
+    if (!(header().flags & RECORD_SCORE))
+        return nullptr;
+    return reinterpret_cast<const int32_t *>(data + sizeof(RecordGameHeader)
+                                             + columnsBytes(moves(), header().flags & (RECORD_NODES | RECORD_TIME)));
+}
+
+const uint8_t *RecordView::packed() const
+{
+    return data + sizeof(RecordGameHeader) + columnsBytes(moves(), header().flags);
+}
+
+GameRecord RecordView::decode() const
+{
+    GameRecord game;
+    game.size = size();
+    game.rules = rules();
+    game.result = result();
+    game.moves.resize(moves());
+    for (int i = 0; i < moves(); ++i)
+        game.moves[i] = move(i);
+    if (const uint64_t *n = nodes())
+        game.nodes.assign(n, n + moves());
+    if (const uint32_t *t = micros())
+        for (int i = 0; i < moves(); ++i)
+            game.seconds.push_back(t[i] / 1e6);
+    if (const int32_t *s = scores())
+        game.scores.assign(s, s + moves());
+    return game;
+}
+
+RecordReader::~RecordReader()
+{
+    close();
+}
+
+bool RecordReader::open(const std::string &path)
+{
+    close();
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        last_error = "cannot open " + path;
+        return false;
+    }
+    struct stat st{};
+    if (fstat(fd, &st) || static_cast<size_t>(st.st_size) < sizeof(RecordFileHeader)) {
+        ::close(fd);
+        last_error = path + " is not a game record file";
+        return false;
+    }
+    void *mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        last_error = "cannot map " + path;
+        return false;
+    }
+    data = static_cast<const uint8_t *>(mapped);
+    length = st.st_size;
+    madvise(mapped, length, MADV_SEQUENTIAL);
+
+    const auto &header = *reinterpret_cast<const RecordFileHeader *>(data);
+    if (std::memcmp(header.magic, "GREC", 4) || header.version != RECORD_VERSION) {
+        close();
+        last_error = path + " is not a version " + std::to_string(RECORD_VERSION) + " game record file";
+        return false;
+    }
+    rewind();
+    return true;
+}
+
+void RecordReader::close()
+{
+    if (data)
+        munmap(const_cast<uint8_t *>(data), length);
+    data = nullptr;
+    length = 0;
+    offset = 0;
+}
+
+void RecordReader::rewind()
+{
+    offset = sizeof(RecordFileHeader);
+    last_error.clear();
+}
+
+bool RecordReader::next(RecordView &game)
+{
+    if (!data || offset >= length)
+        return false;
+    if (length - offset < sizeof(RecordGameHeader)) {
+        last_error = "truncated game at byte " + std::to_string(offset);
+        return false;
+    }
+    const auto &header = *reinterpret_cast<const RecordGameHeader *>(data + offset);
+    if (header.bytes > length - offset) {
+        last_error = "truncated game at byte " + std::to_string(offset);
+        return false;
+    }
+    if (header.bytes != gameBytes(header.moves, header.flags)
+            || header.board_size < 5 || header.board_size > RECORD_MAX_SIZE || header.rules >= RULES_COUNT
+            || header.result > BoardBase::DRAW) {
+        last_error = "damaged game at byte " + std::to_string(offset);
+        return false;
+    }
+    game.data = data + offset;
+    offset += header.bytes;
+    return true;
+}
+
+RecordWriter::~RecordWriter()
+{
+    close();
+}
+
+bool RecordWriter::open(const std::string &path)
+{
+    close();
+    file = std::fopen(path.c_str(), "ab+");
+    if (!file)
+        return false;
+    std::fseek(file, 0, SEEK_END);
+    const long size = std::ftell(file);
+    if (size == 0) {
+        RecordFileHeader header{};
+        std::memcpy(header.magic, "GREC", 4);
+        header.version = RECORD_VERSION;
+        if (std::fwrite(&header, sizeof(header), 1, file) == 1 && std::fflush(file) == 0)
+            return true;
+    } else {
+        // Appending after a partly written game would hide every later one from readers
+        RecordFileHeader header{};
+        std::rewind(file);
+        if (size % 8 == 0 && std::fread(&header, sizeof(header), 1, file) == 1
+                && !std::memcmp(header.magic, "GREC", 4) && header.version == RECORD_VERSION)
+            return true;
+    }
+    std::fclose(file);
+    file = nullptr;
+    return false;
+}
+
+void RecordWriter::close()
+{
+    if (file)
+        std::fclose(file);
+    file = nullptr;
+}
+
+bool RecordWriter::write(const GameRecord &game)
+{
+    const size_t bytes = record_game_bytes(game);
+    if (!file || !bytes)
+        return false;
+    const int moves = static_cast<int>(game.moves.size());
+    buffer.clear();
+    buffer.reserve(bytes);
+
+    RecordGameHeader header{};
+    header.bytes = static_cast<uint32_t>(bytes);
+    header.moves = static_cast<uint16_t>(moves);
+    header.board_size = static_cast<uint8_t>(game.size);
+    header.rules = static_cast<uint8_t>(rulesIndex(game.rules));
+    header.flags = flagsOf(game);
+    header.result = static_cast<uint8_t>(game.result);
+    append(buffer, header);
+    for (uint64_t n : game.nodes)
+        append(buffer, n);
+    for (double s : game.seconds)
+        append(buffer, static_cast<uint32_t>(std::min(std::max(s, 0.0) * 1e6 + 0.5, double(UINT32_MAX))));
+    for (int32_t s : game.scores)
+        append(buffer, s);
+
+    const size_t packed = buffer.size();
+    buffer.resize(bytes, 0);
+    for (int i = 0; i < moves; ++i) {
+        const unsigned cell = (game.moves[i] >> 8) * game.size + (game.moves[i] & 0xFF);
+        const unsigned bit = i * 9;
+        buffer[packed + (bit >> 3)] |= static_cast<uint8_t>(cell << (bit & 7));
+        buffer[packed + (bit >> 3) + 1] |= static_cast<uint8_t>(cell >> (8 - (bit & 7)));
+    }
+    // One write per game, a reader never sees half of one unless the process dies inside fwrite
+    return std::fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size();
+}
+
+bool RecordWriter::flush()
+{
+    return file && std::fflush(file) == 0;
+}
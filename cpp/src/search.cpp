@@ -0,0 +1,43 @@
+#include "search.hpp"
+#include <cmath>
+#include <sstream>
+
+double SearchStats::effective_branching_factor() const
+{
+    for (size_t ply = plies.size(); ply-- > 1;)
+        if (plies[ply].nodes)
+            return std::pow(static_cast<double>(plies[ply].nodes), 1.0 / ply);
+    return 0;
+}
+
+double SearchStats::first_move_cutoff_rate() const
+{
+    return cutoffs ? static_cast<double>(first_move_cutoffs) / cutoffs : 0;
+}
+
+std::string SearchStats::to_json() const
+{
+    std::ostringstream out;
+    out << "{\"nodes\":" << nodes << ",\"seconds\":" << seconds
+        << ",\"nps\":" << (seconds > 0 ? static_cast<uint64_t>(nodes / seconds) : 0)
+        << ",\"score\":" << score
+        << ",\"ebf\":" << effective_branching_factor()
+        << ",\"cutoffs\":" << cutoffs << ",\"first_move_cutoff_rate\":" << first_move_cutoff_rate()
+        << ",\"eval_calls\":" << eval_calls
+        << ",\"tt\":{\"probes\":" << tt_probes << ",\"hits\":" << tt_hits << ",\"stores\":" << tt_stores
+        << ",\"size\":" << tt_size << "}"
+        << ",\"line_cache\":{\"hits\":" << line_cache_hits << ",\"misses\":" << line_cache_misses << "}"
+        << ",\"plies\":[";
+    for (size_t i = 0; i < plies.size(); ++i)
+        out << (i ? "," : "") << "{\"nodes\":" << plies[i].nodes << ",\"cutoffs\":" << plies[i].cutoffs
+            << ",\"first_move_cutoffs\":" << plies[i].first_move_cutoffs << "}";
+    out << "],\"iterations\":[";
+    for (size_t i = 0; i < iterations.size(); ++i)
+        out << (i ? "," : "") << "{\"depth\":" << iterations[i].depth << ",\"nodes\":" << iterations[i].nodes
+            << ",\"seconds\":" << iterations[i].seconds << "}";
+    out << "],\"pv\":[";
+    for (size_t i = 0; i < pv.size(); ++i)
+        out << (i ? "," : "") << "[" << (pv[i] & 0xFF) << "," << (pv[i] >> 8) << "]";
+    out << "]}";
+    return out.str();
+}
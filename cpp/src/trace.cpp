@@ -0,0 +1,79 @@
+#include "trace.hpp"
+#include <cstring>
+
+constexpr size_t TraceWriter::BUFFER_RECORDS;
+
+TraceWriter::~TraceWriter()
+{
+    close();
+}
+
+bool TraceWriter::open(const std::string &path, int board_size)
+{
+    close();
+    file = std::fopen(path.c_str(), "wb");
+    if (!file)
+        return false;
+    TraceHeader header{};
+    std::memcpy(header.magic, "GTRC", 4);
+    header.version = TRACE_VERSION;
+    header.record_size = sizeof(TraceRecord);
+    header.board_size = static_cast<uint16_t>(board_size);
+    std::fwrite(&header, sizeof(header), 1, file);
+
+    for (auto &buffer : buffers)
+        buffer.resize(BUFFER_RECORDS);
+    active = 0;
+    filled = 0;
+    pending = 0;
+    stopping = false;
+    writer = std::thread(&TraceWriter::run, this);
+    return true;
+}
+
+void TraceWriter::close()
+{
+    if (!file)
+        return;
+    flush();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    changed.notify_all();
+    writer.join();
+    std::fclose(file);
+    file = nullptr;
+}
+
+// Hands the active buffer to the writer thread, waiting only if it is still busy with the other one
+void TraceWriter::flush()
+{
+    if (!filled)
+        return;
+    std::unique_lock<std::mutex> lock(mutex);
+    changed.wait(lock, [this] { return pending == 0; });
+    pending = filled;
+    active ^= 1;
+    filled = 0;
+    lock.unlock();
+    changed.notify_all();
+}
+
+void TraceWriter::run()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;)
+    {
+        changed.wait(lock, [this] { return pending || stopping; });
+        if (!pending)
+            return;
+        const TraceRecord *records = buffers[active ^ 1].data();
+        const size_t count = pending;
+        lock.unlock();
+        std::fwrite(records, sizeof(TraceRecord), count, file);
+        lock.lock();
+        pending = 0;
+        changed.notify_all();
+    }
+}
@@ -0,0 +1,216 @@
+#include "tt.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "board.hpp"
+
+static_assert(sizeof(TableHeader) == 64, "TableHeader is part of the file format");
+static_assert(sizeof(TableEntry) == 16, "TableEntry is part of the file format");
+
+namespace {
+
+// Big enough to stream, small enough for the kernel to keep up with
+constexpr size_t IO_CHUNK = size_t(64) << 20;
+constexpr uint64_t FNV_OFFSET = 0xCBF29CE484222325ull;
+constexpr uint64_t FNV_PRIME = 0x100000001B3ull;
+
+template<int N>
+uint64_t fingerprint()
+{
+    uint64_t sum{FNV_OFFSET};
+    for (uint64_t key : ZobristKeys<N>::table().keys)
+        sum = (sum ^ key) * FNV_PRIME;
+    return sum;
+}
+
+// 0 when no engine is built for size and rules
+uint64_t keys_fingerprint(int size, const std::string &rules)
+{
+# define GOMOKU_KEYS_FINGERPRINT(N, R) \
+    if (size == N && rules == R::name) \
+        return fingerprint<N>();
+    GOMOKU_FOR_EACH_VARIANT(GOMOKU_KEYS_FINGERPRINT)
+# undef GOMOKU_KEYS_FINGERPRINT
+    return 0;
+}
+
+// FNV-1a over the words front to back, used counts the entries holding a score
+uint64_t checksum(const TableEntry *entries, uint64_t count, uint64_t &used)
+{
+    uint64_t sum{FNV_OFFSET};
+    used = 0;
+    for (uint64_t i = 0; i < count; ++i) {
+        const uint64_t data = entries[i].data.load(std::memory_order_relaxed);
+        sum = (sum ^ entries[i].check.load(std::memory_order_relaxed)) * FNV_PRIME;
+        sum = (sum ^ data) * FNV_PRIME;
+        used += data != 0;
+    }
+    return sum;
+}
+
+bool write_all(int fd, const void *from, size_t bytes)
+{
+    const char *at = static_cast<const char *>(from);
+    while (bytes) {
+        const ssize_t written = ::write(fd, at, std::min(bytes, IO_CHUNK));
+        if (written <= 0)
+            return false;
+        at += written;
+        bytes -= written;
+    }
+    return true;
+}
+
+}
+
+TranspositionTable::~TranspositionTable()
+{
+    close();
+}
+
+void TranspositionTable::attach(int size, const std::string &rules, void *mapped, size_t bytes, uint64_t capacity)
+{
+    base = static_cast<uint8_t *>(mapped);
+    length = bytes;
+    entries = reinterpret_cast<TableEntry *>(base + bytes - capacity * sizeof(TableEntry));
+    entries_count = capacity;
+    mask = (capacity - 1) & ~uint64_t(TT_BUCKET - 1);
+    this->size = size;
+    rules_name = rules;
+    last_error.clear();
+}
+
+bool TranspositionTable::create(int size, const std::string &rules, uint64_t bytes)
+{
+    close();
+    if (!keys_fingerprint(size, rules)) {
+        last_error = "no engine for size " + std::to_string(size) + " and rules " + rules;
+        return false;
+    }
+    uint64_t capacity = TT_BUCKET;
+    while (capacity * 2 * sizeof(TableEntry) <= bytes)
+        capacity *= 2;
+    const size_t table_bytes = capacity * sizeof(TableEntry);
+    // Pages are only backed once a search writes to them
+    void *mapped = mmap(nullptr, table_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (mapped == MAP_FAILED) {
+        last_error = "cannot map " + std::to_string(table_bytes) + " bytes";
+        return false;
+    }
+#ifdef MADV_HUGEPAGE
+    madvise(mapped, table_bytes, MADV_HUGEPAGE);
+#endif
+    attach(size, rules, mapped, table_bytes, capacity);
+    return true;
+}
+
+bool TranspositionTable::load(const std::string &path)
+{
+    close();
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        last_error = "cannot open " + path;
+        return false;
+    }
+    TableHeader header{};
+    struct stat st{};
+    const bool is_table = !fstat(fd, &st)
+            && pread(fd, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header))
+            && !std::memcmp(header.magic, "GTTF", 4);
+    const std::string rules(header.rules, strnlen(header.rules, sizeof(header.rules)));
+    const uint64_t capacity = header.capacity;
+    std::string why;
+    if (!is_table)
+        why = " is not a transposition table";
+    else if (header.version != TT_VERSION)
+        why = " is a version " + std::to_string(header.version) + " table, not " + std::to_string(TT_VERSION);
+    else if (header.eval_version != EVAL_VERSION)
+        why = " holds scores of Eval version " + std::to_string(header.eval_version) + ", not " + std::to_string(EVAL_VERSION);
+    else if (!keys_fingerprint(header.board_size, rules))
+        why = " is for size " + std::to_string(header.board_size) + " and rules " + rules + ", which no engine plays";
+    else if (header.keys != keys_fingerprint(header.board_size, rules))
+        why = " was saved with other Zobrist keys";
+    else if (capacity < TT_BUCKET || (capacity & (capacity - 1))
+             || static_cast<uint64_t>(st.st_size) != sizeof(header) + capacity * sizeof(TableEntry))
+        why = " is truncated or damaged";
+    if (!why.empty()) {
+        ::close(fd);
+        last_error = path + why;
+        return false;
+    }
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    // Private, searches write to copies of the pages and the file stays as saved
+    void *mapped = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        last_error = "cannot map " + path;
+        return false;
+    }
+    madvise(mapped, st.st_size, MADV_SEQUENTIAL);
+    attach(header.board_size, rules, mapped, st.st_size, capacity);
+    uint64_t used;
+    if (checksum(entries, entries_count, used) != header.checksum || used != header.used) {
+        close();
+        last_error = path + " fails its checksum";
+        return false;
+    }
+    // Probes jump around the table from here on
+    madvise(mapped, st.st_size, MADV_RANDOM);
+    used_count.store(used, std::memory_order_relaxed);
+    return true;
+}
+
+bool TranspositionTable::save(const std::string &path) const
+{
+    if (!entries) {
+        last_error = "no table to save";
+        return false;
+    }
+    TableHeader header{};
+    std::memcpy(header.magic, "GTTF", 4);
+    header.version = TT_VERSION;
+    header.eval_version = EVAL_VERSION;
+    header.board_size = static_cast<uint8_t>(size);
+    // The header is zeroed, so a name cut to fit keeps its terminator
+    std::memcpy(header.rules, rules_name.data(), std::min(rules_name.size(), sizeof(header.rules) - 1));
+    header.keys = keys_fingerprint(size, rules_name);
+    header.capacity = entries_count;
+    uint64_t used;
+    header.checksum = checksum(entries, entries_count, used);
+    header.used = used;
+
+    const std::string temporary = path + ".tmp";
+    const int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        last_error = "cannot write " + temporary;
+        return false;
+    }
+    bool ok = write_all(fd, &header, sizeof(header))
+              && write_all(fd, entries, entries_count * sizeof(TableEntry))
+              && fsync(fd) == 0;
+    ok = ::close(fd) == 0 && ok;
+    if (!ok || std::rename(temporary.c_str(), path.c_str())) {
+        std::remove(temporary.c_str());
+        last_error = "cannot write " + path;
+        return false;
+    }
+    return true;
+}
+
+void TranspositionTable::close()
+{
+    if (base)
+        munmap(base, length);
+    base = nullptr;
+    length = 0;
+    entries = nullptr;
+    entries_count = 0;
+    mask = 0;
+    used_count.store(0, std::memory_order_relaxed);
+    size = 0;
+    rules_name.clear();
+}
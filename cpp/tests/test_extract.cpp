@@ -1,12 +1,10 @@
 #include <iostream>
 #include <bitset>
-#include <chrono>
 #include <string>
 #include <cstring>
 
 #define LEN 5
 #define MASK 0b10000
-#define REPORT(M) std::cout << M << " " << std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count() << " microseconds" << std::endl;
 using namespace std;
 uint32_t getColumn(const uint32_t b[LEN], uint32_t n)
 {
@@ -145,16 +143,9 @@ int main() {
         std::cout << item;
     std::cout << std::endl;
 
-    auto start = std::chrono::high_resolution_clock::now();
-    for (int i = 0; i < 100000; ++i) {
-        char flat2 [LEN] = {'0','0','0','0','0'};
-        getFlat(1, 1, -1, 1, 2,  2, bb, bw, flat2);
-        (void)strstr(flat2, "020");
-    }
     for (const auto &item : FPT[3]){
         cout << "FPT[3] = " << item << endl;
     }
-    REPORT("getColumn")
 
     char n[7] = "0110";
     char s[25] = "[000000000011000000000]";
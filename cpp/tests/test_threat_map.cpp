@@ -0,0 +1,55 @@
+#include <gtest/gtest.h>
+#include "board.hpp"
+
+namespace {
+
+// Stones as x | y << 8, the first list for one color and the second for the other
+const std::vector<int16_t> FIRST = {7 | 7 << 8, 8 | 7 << 8, 10 | 10 << 8, 10 | 11 << 8, 3 | 3 << 8, 4 | 4 << 8};
+const std::vector<int16_t> SECOND = {12 | 3 << 8, 12 | 5 << 8, 2 | 14 << 8};
+
+template<class Board>
+void setup(Board &board, bool first_is_black) {
+    UndoRecord undo;
+    for (int16_t m : FIRST)
+        board.make_move(m & 0xFF, m >> 8, first_is_black, false, undo);
+    for (int16_t m : SECOND)
+        board.make_move(m & 0xFF, m >> 8, !first_is_black, false, undo);
+}
+
+template<int N>
+bool same(const BitRows<N> &a, const BitRows<N> &b) {
+    for (int y = 0; y < N; ++y)
+        if (a.row[y] != b.row[y])
+            return false;
+    return true;
+}
+
+// With colors swapped on the board, black's maps become white's and the other way round
+template<class Board>
+void expectMirrored() {
+    Board normal, swapped;
+    setup(normal, true);
+    setup(swapped, false);
+    const auto &a = normal.threat_map();
+    const auto &b = swapped.threat_map();
+    EXPECT_TRUE(a.free_two[0].any());
+    EXPECT_TRUE(a.free_three[0].any());
+    for (int c = 0; c < 2; ++c) {
+        EXPECT_TRUE(same(a.free_two[c], b.free_two[1 - c])) << "free_two " << c;
+        EXPECT_TRUE(same(a.free_three[c], b.free_three[1 - c])) << "free_three " << c;
+        EXPECT_TRUE(same(a.double_three[c], b.double_three[1 - c])) << "double_three " << c;
+        EXPECT_TRUE(same(a.free_four[c], b.free_four[1 - c])) << "free_four " << c;
+        EXPECT_TRUE(same(a.win[c], b.win[1 - c])) << "win " << c;
+        EXPECT_TRUE(same(a.five[c], b.five[1 - c])) << "five " << c;
+    }
+}
+
+}
+
+TEST(ThreatMap, ColorsMirrorProCaptures) {
+    expectMirrored<BasicBoard<19, ProCaptures>>();
+}
+
+TEST(ThreatMap, ColorsMirrorFreestyle15) {
+    expectMirrored<BasicBoard<15, Freestyle>>();
+}
@@ -0,0 +1,344 @@
+//
+// Searches many saved boards at once, one engine per worker thread, results streamed as JSON lines.
+// Usage: batch_analyze INPUT [-o FILE] [--threads N] [--depth N] [--time S] [--multipv K]
+//                      [--size N] [--rules NAME] [--to-move black|white] [--tt FILE [--tt-mb MB]]
+// INPUT is a directory of .json boards as saved by the GUI or a JSON lines file with one such board
+// per line. A board is an array of rows of 0 empty, 1 black, 2 white. Without --to-move the side
+// with fewer stones moves, black on a tie. Capture counts are not saved with boards and start at 0.
+// With --tt every worker shares one transposition table, loaded from FILE when it exists and created
+// with MB megabytes otherwise, and saved back to FILE at the end so the next run starts warm.
+//
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <dirent.h>
+#include <sys/stat.h>
+#include "engine.hpp"
+
+namespace {
+
+struct Settings
+{
+    std::string input;
+    std::string output;
+    int threads{static_cast<int>(std::max(1u, std::thread::hardware_concurrency()))};
+    int size{BOARD_SIZE};
+    std::string rules{ProCaptures::name};
+    int multiPv{1};
+    int8_t toMove{EMPTY_STONE};
+    SearchLimits limits;
+    std::string table;
+    uint64_t tableMb{1024};
+};
+
+// Hands out boards to the workers in input order, from the files of a directory or the lines of one file
+class Source
+{
+public:
+    bool open(const std::string &path) {
+        struct stat st{};
+        if (stat(path.c_str(), &st))
+            return false;
+        if (!S_ISDIR(st.st_mode)) {
+            lines.open(path);
+            name = path;
+            return lines.is_open();
+        }
+        DIR *dir = opendir(path.c_str());
+        if (!dir)
+            return false;
+        while (dirent *entry = readdir(dir)) {
+            const std::string file = entry->d_name;
+            if (file.size() > 5 && file.compare(file.size() - 5, 5, ".json") == 0)
+                files.push_back(path + "/" + file);
+        }
+        closedir(dir);
+        std::sort(files.begin(), files.end());
+        return true;
+    }
+
+    // Thread safe, false when the input is exhausted
+    bool next(std::string &label, std::string &text) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (lines.is_open()) {
+            while (std::getline(lines, text)) {
+                ++lineNumber;
+                if (text.find_first_not_of(" \t\r") != std::string::npos) {
+                    label = name + ":" + std::to_string(lineNumber);
+                    return true;
+                }
+            }
+            return false;
+        }
+        if (nextFile >= files.size())
+            return false;
+        label = files[nextFile++];
+        std::ifstream in(label);
+        std::stringstream buffer;
+        buffer << in.rdbuf();
+        text = buffer.str();
+        return true;
+    }
+
+private:
+    std::mutex mutex;
+    std::ifstream lines;
+    std::string name;
+    size_t lineNumber{0};
+    std::vector<std::string> files;
+    size_t nextFile{0};
+};
+
+// Reads [[..],[..],..], size rows of size cells, into cells[y * size + x]
+bool parseBoard(const std::string &text, int size, std::vector<int8_t> &cells)
+{
+    cells.clear();
+    size_t i = 0;
+    auto skip = [&]() {
+        while (i < text.size() && std::isspace(static_cast<unsigned char>(text[i])))
+            ++i;
+    };
+    auto expect = [&](char c) {
+        skip();
+        if (i >= text.size() || text[i] != c)
+            return false;
+        ++i;
+        return true;
+    };
+    if (!expect('['))
+        return false;
+    for (int y = 0; y < size; ++y) {
+        if ((y && !expect(',')) || !expect('['))
+            return false;
+        for (int x = 0; x < size; ++x) {
+            if (x && !expect(','))
+                return false;
+            skip();
+            if (i >= text.size() || text[i] < '0' || text[i] > '2')
+                return false;
+            cells.push_back(static_cast<int8_t>(text[i++] - '0'));
+        }
+        if (!expect(']'))
+            return false;
+    }
+    if (!expect(']'))
+        return false;
+    skip();
+    return i == text.size();
+}
+
+// The text format of the board's operator>>, rows of x from the last, columns of y
+std::string boardText(const std::vector<int8_t> &cells, int size, int8_t lastMove)
+{
+    std::string text = "0 0 " + std::to_string(lastMove) + "\n";
+    for (int x = size - 1; x >= 0; --x) {
+        for (int y = 0; y < size; ++y) {
+            const int8_t v = cells[y * size + x];
+            text += v == BLACK_STONE ? 'O' : v == WHITE_STONE ? 'X' : '_';
+        }
+        text += '\n';
+    }
+    return text;
+}
+
+std::string jsonMove(int16_t move)
+{
+    return "[" + std::to_string(move & 0xFF) + "," + std::to_string(move >> 8) + "]";
+}
+
+std::string jsonString(const std::string &s)
+{
+    std::string out = "\"";
+    for (char c : s) {
+        if (c == '"' || c == '\\')
+            out += '\\';
+        out += c;
+    }
+    return out + "\"";
+}
+
+// One result line, "error" set instead of the search fields when the board could not be searched
+std::string analyzeBoard(Engine &engine, const Settings &settings, const std::string &label, const std::string &text,
+                         uint64_t &nodes, bool &failed)
+{
+    failed = true;
+    std::vector<int8_t> cells;
+    if (!parseBoard(text, settings.size, cells))
+        return "{\"source\":" + jsonString(label) + ",\"error\":\"not a "
+               + std::to_string(settings.size) + "x" + std::to_string(settings.size) + " board\"}";
+
+    int8_t toMove = settings.toMove;
+    if (toMove == EMPTY_STONE) {
+        const auto black = std::count(cells.begin(), cells.end(), BLACK_STONE);
+        const auto white = std::count(cells.begin(), cells.end(), WHITE_STONE);
+        toMove = white < black ? WHITE_STONE : BLACK_STONE;
+    }
+    std::istringstream in(boardText(cells, settings.size, toMove == BLACK_STONE ? WHITE_STONE : BLACK_STONE));
+    engine.readBoard(in);
+
+    std::ostringstream out;
+    out << "{\"source\":" << jsonString(label) << ",\"to_move\":\"" << (toMove == BLACK_STONE ? "black" : "white")
+        << "\"";
+    // A parsed board has no last move to look through
+    if (engine.winner(false) != BoardBase::NO_RESULT) {
+        out << ",\"error\":\"game already over\"}";
+        return out.str();
+    }
+    const std::vector<RootLine> lines = engine.analyze(toMove, settings.multiPv, settings.limits);
+    const SearchStats &stats = engine.stats();
+    nodes = stats.nodes;
+    if (lines.empty()) {
+        out << ",\"error\":\"no legal move\"}";
+        return out.str();
+    }
+    failed = false;
+    out << ",\"move\":" << jsonMove(lines.front().move) << ",\"score\":" << lines.front().score << ",\"lines\":[";
+    for (size_t i = 0; i < lines.size(); ++i) {
+        out << (i ? "," : "") << "{\"move\":" << jsonMove(lines[i].move) << ",\"score\":" << lines[i].score
+            << ",\"pv\":[";
+        for (size_t j = 0; j < lines[i].pv.size(); ++j)
+            out << (j ? "," : "") << jsonMove(lines[i].pv[j]);
+        out << "]}";
+    }
+    out << "],\"stats\":" << stats.to_json() << "}";
+    return out.str();
+}
+
+int usage(const char *argv0)
+{
+    std::cerr << "usage: " << argv0 << " INPUT [-o FILE] [--threads N] [--depth N] [--time S] [--multipv K]\n"
+                 "       [--size N] [--rules pro-captures|freestyle|standard|renju] [--to-move black|white]\n"
+                 "       [--tt FILE [--tt-mb MB]]\n"
+                 "INPUT is a directory of .json boards or a file with one board per line, --time 0 for no limit"
+              << std::endl;
+    return 1;
+}
+
+}
+
+int main(int argc, char **argv)
+{
+    Settings settings;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if ((arg == "-o" || arg == "--output") && i + 1 < argc)
+            settings.output = argv[++i];
+        else if (arg == "--threads" && i + 1 < argc)
+            settings.threads = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--depth" && i + 1 < argc)
+            settings.limits.depth = std::atoi(argv[++i]);
+        else if (arg == "--time" && i + 1 < argc)
+            settings.limits.seconds = std::atof(argv[++i]);
+        else if (arg == "--multipv" && i + 1 < argc)
+            settings.multiPv = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--size" && i + 1 < argc)
+            settings.size = std::atoi(argv[++i]);
+        else if (arg == "--rules" && i + 1 < argc)
+            settings.rules = argv[++i];
+        else if (arg == "--to-move" && i + 1 < argc) {
+            const std::string color = argv[++i];
+            if (color != "black" && color != "white")
+                return usage(argv[0]);
+            settings.toMove = color == "black" ? BLACK_STONE : WHITE_STONE;
+        } else if (arg == "--tt" && i + 1 < argc)
+            settings.table = argv[++i];
+        else if (arg == "--tt-mb" && i + 1 < argc)
+            settings.tableMb = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg[0] != '-' && settings.input.empty())
+            settings.input = arg;
+        else
+            return usage(argv[0]);
+    }
+    if (settings.input.empty())
+        return usage(argv[0]);
+    if (settings.limits.seconds <= 0)
+        settings.limits.seconds = std::numeric_limits<double>::infinity();
+    if (!Engine::create(settings.size, settings.rules)) {
+        std::cerr << "unsupported size " << settings.size << " or rules " << settings.rules << std::endl;
+        return 1;
+    }
+
+    Source source;
+    if (!source.open(settings.input)) {
+        std::cerr << "cannot read " << settings.input << std::endl;
+        return 1;
+    }
+    std::ofstream file;
+    if (!settings.output.empty()) {
+        file.open(settings.output);
+        if (!file) {
+            std::cerr << "cannot write " << settings.output << std::endl;
+            return 1;
+        }
+    }
+    std::ostream &out = settings.output.empty() ? std::cout : file;
+
+    TranspositionTable table;
+    if (!settings.table.empty()) {
+        struct stat st{};
+        const bool loaded = !stat(settings.table.c_str(), &st);
+        if (loaded ? !table.load(settings.table) : !table.create(settings.size, settings.rules, settings.tableMb << 20)) {
+            std::cerr << table.error() << std::endl;
+            return 1;
+        }
+        if (table.board_size() != settings.size || table.rules() != settings.rules) {
+            std::cerr << settings.table << " is for size " << table.board_size() << " and rules " << table.rules()
+                      << std::endl;
+            return 1;
+        }
+        std::cerr << (loaded ? "loaded " : "created ") << settings.table << " with " << table.used() << " of "
+                  << table.capacity() << " entries" << std::endl;
+    }
+
+    std::mutex mutex;
+    uint64_t boards{0}, errors{0}, totalNodes{0};
+    const auto start = std::chrono::steady_clock::now();
+
+    auto worker = [&]() {
+        std::unique_ptr<Engine> engine = Engine::create(settings.size, settings.rules);
+        if (table.is_open())
+            engine->useTable(&table);
+        std::string label, text;
+        while (source.next(label, text)) {
+            uint64_t nodes{0};
+            bool failed;
+            const std::string result = analyzeBoard(*engine, settings, label, text, nodes, failed);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            out << result << std::endl;
+            ++boards;
+            errors += failed;
+            totalNodes += nodes;
+        }
+    };
+    std::vector<std::thread> threads;
+    for (int i = 0; i < settings.threads; ++i)
+        threads.emplace_back(worker);
+    for (auto &t : threads)
+        t.join();
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cerr << "boards " << boards << " errors " << errors << " nodes " << totalNodes << " time " << seconds
+              << "s boards/s " << (seconds > 0 ? boards / seconds : 0) << std::endl;
+    if (table.is_open()) {
+        if (!table.save(settings.table)) {
+            std::cerr << table.error() << std::endl;
+            return 1;
+        }
+        std::cerr << "saved " << settings.table << " with " << table.used() << " entries" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,370 @@
+//
+// Converts between binary game records (include/record.hpp) and JSON lines.
+// Usage: game_record info FILE
+//        game_record to-json FILE [--final]
+//        game_record from-json INPUT FILE
+// to-json writes one {"size","rules","result","moves",["seconds","scores","nodes"]} object per game,
+// with --final the final positions as the GUI saves them instead. from-json reads such objects, or
+// final positions for which the stones are replayed alternately, black first, and the replay checked.
+//
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "engine.hpp"
+#include "record.hpp"
+
+namespace {
+
+const char *const RESULTS[] = {"none", "white", "black", "draw"};
+
+// Just enough JSON for these files, numbers are kept as text
+struct Json
+{
+    enum Type { NONE, NUMBER, STRING, ARRAY, OBJECT } type{NONE};
+    std::string text;
+    std::vector<Json> items;        // array items or object values
+    std::vector<std::string> names; // object keys
+
+    const Json *field(const std::string &name) const {
+        for (size_t i = 0; i < names.size(); ++i)
+            if (names[i] == name)
+                return &items[i];
+        return nullptr;
+    }
+};
+
+class JsonParser
+{
+public:
+    explicit JsonParser(const std::string &text) : text(text) {}
+
+    bool parse(Json &value) {
+        return parseValue(value) && (skip(), i == text.size());
+    }
+
+private:
+    const std::string &text;
+    size_t i{0};
+
+    void skip() {
+        while (i < text.size() && std::isspace(static_cast<unsigned char>(text[i])))
+            ++i;
+    }
+    bool parseString(std::string &out) {
+        if (text[i++] != '"')
+            return false;
+        for (; i < text.size() && text[i] != '"'; ++i) {
+            if (text[i] == '\\' && ++i >= text.size())
+                return false;
+            out += text[i];
+        }
+        return i++ < text.size();
+    }
+    bool parseValue(Json &value) {
+        skip();
+        if (i >= text.size())
+            return false;
+        const char c = text[i];
+        if (c == '"') {
+            value.type = Json::STRING;
+            return parseString(value.text);
+        }
+        if (c == '[' || c == '{') {
+            value.type = c == '[' ? Json::ARRAY : Json::OBJECT;
+            const char close = c == '[' ? ']' : '}';
+            ++i;
+            skip();
+            if (i < text.size() && text[i] == close)
+                return ++i, true;
+            for (;;) {
+                if (value.type == Json::OBJECT) {
+                    value.names.emplace_back();
+                    skip();
+                    if (i >= text.size() || !parseString(value.names.back()))
+                        return false;
+                    skip();
+                    if (i >= text.size() || text[i++] != ':')
+                        return false;
+                }
+                value.items.emplace_back();
+                if (!parseValue(value.items.back()))
+                    return false;
+                skip();
+                if (i >= text.size())
+                    return false;
+                if (text[i] == close)
+                    return ++i, true;
+                if (text[i++] != ',')
+                    return false;
+            }
+        }
+        const size_t start = i;
+        while (i < text.size() && (std::isalnum(static_cast<unsigned char>(text[i])) || std::strchr("+-.", text[i])))
+            ++i;
+        value.type = Json::NUMBER;
+        value.text = text.substr(start, i - start);
+        return i > start;
+    }
+};
+
+std::string jsonRecord(const GameRecord &game)
+{
+    std::ostringstream out;
+    out << "{\"size\":" << game.size << ",\"rules\":\"" << game.rules << "\",\"result\":\""
+        << RESULTS[game.result] << "\",\"moves\":[";
+    for (size_t i = 0; i < game.moves.size(); ++i)
+        out << (i ? "," : "") << "[" << (game.moves[i] & 0xFF) << "," << (game.moves[i] >> 8) << "]";
+    out << "]";
+    if (!game.seconds.empty()) {
+        // Enough digits for the stored microseconds
+        out << std::setprecision(10) << ",\"seconds\":[";
+        for (size_t i = 0; i < game.seconds.size(); ++i)
+            out << (i ? "," : "") << game.seconds[i];
+        out << "]";
+    }
+    if (!game.scores.empty()) {
+        out << ",\"scores\":[";
+        for (size_t i = 0; i < game.scores.size(); ++i)
+            out << (i ? "," : "") << game.scores[i];
+        out << "]";
+    }
+    if (!game.nodes.empty()) {
+        out << ",\"nodes\":[";
+        for (size_t i = 0; i < game.nodes.size(); ++i)
+            out << (i ? "," : "") << game.nodes[i];
+        out << "]";
+    }
+    out << "}";
+    return out.str();
+}
+
+// Plays the moves with captures, false at the first illegal one
+bool replay(const GameRecord &game, std::unique_ptr<Engine> &engine)
+{
+    engine = Engine::create(game.size, game.rules);
+    if (!engine)
+        return false;
+    for (size_t i = 0; i < game.moves.size(); ++i) {
+        const int8_t x = game.moves[i] & 0xFF, y = game.moves[i] >> 8;
+        if (engine->getToken(x, y) || !engine->setToken(x, y, i % 2 ? WHITE_STONE : BLACK_STONE))
+            return false;
+    }
+    return true;
+}
+
+std::string jsonFinal(const GameRecord &game)
+{
+    std::unique_ptr<Engine> engine;
+    if (!replay(game, engine))
+        return "{\"error\":\"illegal move\"}";
+    std::string out = "[";
+    for (int y = 0; y < game.size; ++y) {
+        out += y ? ",[" : "[";
+        for (int x = 0; x < game.size; ++x) {
+            out += x ? "," : "";
+            out += std::to_string(engine->getToken(x, y));
+        }
+        out += "]";
+    }
+    return out + "]";
+}
+
+template<class T, class Convert>
+bool readColumn(const Json *column, std::vector<T> &out, Convert convert)
+{
+    if (!column)
+        return true;
+    if (column->type != Json::ARRAY)
+        return false;
+    for (const Json &item : column->items) {
+        if (item.type != Json::NUMBER)
+            return false;
+        out.push_back(convert(item.text));
+    }
+    return true;
+}
+
+bool recordFromObject(const Json &json, GameRecord &game)
+{
+    if (const Json *size = json.field("size"))
+        game.size = std::atoi(size->text.c_str());
+    if (const Json *rules = json.field("rules"))
+        game.rules = rules->text;
+    if (const Json *result = json.field("result")) {
+        const auto it = std::find_if(std::begin(RESULTS), std::end(RESULTS),
+                                     [&](const char *name) { return result->text == name; });
+        if (it == std::end(RESULTS))
+            return false;
+        game.result = static_cast<BoardBase::Result>(it - std::begin(RESULTS));
+    }
+    const Json *moves = json.field("moves");
+    if (!moves || moves->type != Json::ARRAY)
+        return false;
+    for (const Json &move : moves->items) {
+        if (move.type != Json::ARRAY || move.items.size() != 2)
+            return false;
+        game.moves.push_back(static_cast<int16_t>(std::atoi(move.items[0].text.c_str())
+                                                  | std::atoi(move.items[1].text.c_str()) << 8));
+    }
+    return readColumn(json.field("seconds"), game.seconds, [](const std::string &s) { return std::atof(s.c_str()); })
+           && readColumn(json.field("scores"), game.scores,
+                         [](const std::string &s) { return static_cast<int32_t>(std::atol(s.c_str())); })
+           && readColumn(json.field("nodes"), game.nodes,
+                         [](const std::string &s) { return std::strtoull(s.c_str(), nullptr, 10); });
+}
+
+// A final position has no move order, black and white stones are interleaved and the replay must end there
+bool recordFromBoard(const Json &json, GameRecord &game, std::string &error)
+{
+    game.size = static_cast<int>(json.items.size());
+    std::vector<int16_t> stones[2];
+    for (int y = 0; y < game.size; ++y) {
+        const Json &row = json.items[y];
+        if (row.type != Json::ARRAY || static_cast<int>(row.items.size()) != game.size)
+            return error = "not a square board", false;
+        for (int x = 0; x < game.size; ++x) {
+            const int v = std::atoi(row.items[x].text.c_str());
+            if (v == BLACK_STONE || v == WHITE_STONE)
+                stones[v == BLACK_STONE ? 0 : 1].push_back(static_cast<int16_t>(x | y << 8));
+        }
+    }
+    if (stones[0].size() != stones[1].size() && stones[0].size() != stones[1].size() + 1)
+        return error = "stone counts do not alternate", false;
+    for (size_t i = 0; i < stones[0].size(); ++i) {
+        game.moves.push_back(stones[0][i]);
+        if (i < stones[1].size())
+            game.moves.push_back(stones[1][i]);
+    }
+    std::unique_ptr<Engine> engine;
+    if (!replay(game, engine))
+        return error = "the stones can not be replayed in order", false;
+    for (int y = 0; y < game.size; ++y)
+        for (int x = 0; x < game.size; ++x)
+            if (engine->getToken(x, y) != std::atoi(json.items[y].items[x].text.c_str()))
+                return error = "the replay captures stones of the position", false;
+    // The replay order is made up, the five may not run through its last stone
+    game.result = engine->winner(false);
+    return true;
+}
+
+int info(const std::string &path)
+{
+    RecordReader reader;
+    if (!reader.open(path)) {
+        std::cerr << reader.error() << std::endl;
+        return 1;
+    }
+    const auto start = std::chrono::steady_clock::now();
+    uint64_t games{0}, moves{0}, results[4]{}, checksum{0};
+    RecordView game;
+    while (reader.next(game)) {
+        ++games;
+        moves += game.moves();
+        ++results[game.result()];
+        for (int i = 0; i < game.moves(); ++i)
+            checksum += game.move(i);
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "games " << games << " moves " << moves << " black " << results[BoardBase::BLACK_WIN]
+              << " white " << results[BoardBase::WHITE_WIN] << " draw " << results[BoardBase::DRAW]
+              << " unfinished " << results[BoardBase::NO_RESULT] << std::endl;
+    std::cout << "decoded in " << seconds << "s, " << static_cast<uint64_t>(seconds > 0 ? games / seconds : 0)
+              << " games/s, checksum " << checksum << std::endl;
+    if (!reader.error().empty()) {
+        std::cerr << reader.error() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+int toJson(const std::string &path, bool final)
+{
+    RecordReader reader;
+    if (!reader.open(path)) {
+        std::cerr << reader.error() << std::endl;
+        return 1;
+    }
+    RecordView game;
+    while (reader.next(game))
+        std::cout << (final ? jsonFinal(game.decode()) : jsonRecord(game.decode())) << "\n";
+    if (!reader.error().empty()) {
+        std::cerr << reader.error() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+int fromJson(const std::string &input, const std::string &output)
+{
+    std::ifstream in(input);
+    if (!in) {
+        std::cerr << "cannot read " << input << std::endl;
+        return 1;
+    }
+    RecordWriter writer;
+    if (!writer.open(output)) {
+        std::cerr << "cannot append to " << output << std::endl;
+        return 1;
+    }
+    std::string line;
+    int number{0}, written{0}, failed{0};
+    while (std::getline(in, line)) {
+        ++number;
+        if (line.find_first_not_of(" \t\r") == std::string::npos)
+            continue;
+        Json json;
+        GameRecord game;
+        std::string error = "not a game";
+        bool ok = JsonParser(line).parse(json);
+        if (ok && json.type == Json::OBJECT)
+            ok = recordFromObject(json, game);
+        else if (ok && json.type == Json::ARRAY)
+            ok = recordFromBoard(json, game, error);
+        else
+            ok = false;
+        if (ok && !writer.write(game)) {
+            ok = false;
+            error = "does not fit the record format";
+        }
+        if (!ok) {
+            std::cerr << input << ":" << number << ": " << error << std::endl;
+            ++failed;
+        }
+        written += ok;
+    }
+    std::cerr << "games " << written << " skipped " << failed << std::endl;
+    return writer.flush() ? 0 : 1;
+}
+
+int usage(const char *argv0)
+{
+    std::cerr << "usage: " << argv0 << " info FILE\n"
+                 "       " << argv0 << " to-json FILE [--final]\n"
+                 "       " << argv0 << " from-json INPUT FILE" << std::endl;
+    return 1;
+}
+
+}
+
+int main(int argc, char **argv)
+{
+    const std::string command = argc > 1 ? argv[1] : "";
+    if (command == "info" && argc == 3)
+        return info(argv[2]);
+    if (command == "to-json" && (argc == 3 || (argc == 4 && std::string(argv[3]) == "--final")))
+        return toJson(argv[2], argc == 4);
+    if (command == "from-json" && argc == 4)
+        return fromJson(argv[2], argv[3]);
+    return usage(argv[0]);
+}
@@ -0,0 +1,307 @@
+//
+// Piskvork (Gomocup) protocol front end of the engine, talks over stdin/stdout.
+// Usage: gomoku_cli [--rules NAME] [--depth N] [--stats] [--trace FILE]
+//        gomoku_cli bench [DEPTH]   searches the built-in positions, prints the node signature and speed
+// Without --rules the variant follows INFO rule, pro-captures until a manager sends one.
+//
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "bench.hpp"
+#include "engine.hpp"
+#include "trace.hpp"
+
+namespace {
+
+constexpr int BENCH_DEPTH = 2;
+
+// INFO rule bits
+constexpr int RULE_EXACT_FIVE = 1;
+constexpr int RULE_RENJU = 4;
+
+// Share of the turn time given to the search, the rest covers the root moves
+// finished after the cutoff and the manager round trip
+constexpr double TURN_TIME_SHARE = 0.8;
+// Share of max_memory given to the search caches
+constexpr double MEMORY_SHARE = 0.75;
+
+class Piskvork
+{
+public:
+    Piskvork(const std::string &rules, int depth, bool jsonStats, TraceWriter *trace, const std::string &tracePath)
+        : rules(rules), fixedRules(!rules.empty()), jsonStats(jsonStats), trace(trace), tracePath(tracePath) {
+        if (!fixedRules)
+            this->rules = ProCaptures::name;
+        limits.depth = depth;
+    }
+
+    // false on END
+    bool command(const std::string &line) {
+        std::istringstream in(line);
+        std::string cmd;
+        in >> cmd;
+        std::transform(cmd.begin(), cmd.end(), cmd.begin(), ::toupper);
+
+        if (cmd.empty())
+            return true;
+        if (cmd == "END")
+            return false;
+        if (cmd == "START")
+            start(in);
+        else if (cmd == "RESTART")
+            restart();
+        else if (cmd == "BEGIN")
+            begin();
+        else if (cmd == "TURN")
+            turn(in);
+        else if (cmd == "BOARD")
+            board();
+        else if (cmd == "TAKEBACK")
+            takeback(in);
+        else if (cmd == "INFO")
+            info(in);
+        else if (cmd == "ABOUT")
+            std::cout << "name=\"gomoku\", version=\"0.1\", author=\"gomoku\", country=\"\"" << std::endl;
+        else if (cmd == "RECTSTART")
+            std::cout << "ERROR rectangular boards are not supported" << std::endl;
+        else
+            std::cout << "UNKNOWN " << cmd << std::endl;
+        return true;
+    }
+
+private:
+    std::unique_ptr<Engine> engine;
+    std::string rules;
+    bool fixedRules;
+    bool jsonStats;
+    TraceWriter *trace;
+    std::string tracePath;
+    int traceSize{BOARD_SIZE};      // board size in the trace header
+    int size{BOARD_SIZE};
+    int8_t own{EMPTY_STONE};
+    SearchLimits limits;
+    double turnSeconds{SearchLimits().seconds};
+    double timeLeft{-1};
+
+    static int8_t opponent(int8_t v) {
+        return v == BLACK_STONE ? WHITE_STONE : BLACK_STONE;
+    }
+    static bool readMove(std::istream &in, int &x, int &y) {
+        std::string s;
+        in >> s;
+        return std::sscanf(s.c_str(), "%d,%d", &x, &y) == 2;
+    }
+    bool onBoard(int x, int y) const {
+        return engine && x >= 0 && y >= 0 && x < size && y < size;
+    }
+
+    void create(int n) {
+        engine = Engine::create(n, rules);
+        if (engine && trace)
+            engine->traceTo(trace);
+    }
+
+    void start(std::istream &in) {
+        int n{0};
+        in >> n;
+        create(n);
+        if (!engine) {
+            std::cout << "ERROR unsupported size " << n << std::endl;
+            return;
+        }
+        size = n;
+        own = EMPTY_STONE;
+        // A trace holds boards of one size, another size starts the file over with its own header
+        if (trace && n != traceSize) {
+            traceSize = n;
+            if (!trace->open(tracePath, n)) {
+                std::cout << "DEBUG cannot write " << tracePath << ", tracing stops" << std::endl;
+                engine->traceTo(nullptr);
+                trace = nullptr;
+            }
+        }
+        std::cout << "OK" << std::endl;
+    }
+    void restart() {
+        if (!engine) {
+            std::cout << "ERROR no START yet" << std::endl;
+            return;
+        }
+        engine->reset();
+        own = EMPTY_STONE;
+        std::cout << "OK" << std::endl;
+    }
+    void begin() {
+        if (!engine) {
+            std::cout << "ERROR no START yet" << std::endl;
+            return;
+        }
+        own = BLACK_STONE;
+        play();
+    }
+    void turn(std::istream &in) {
+        int x, y;
+        if (!readMove(in, x, y) || !onBoard(x, y) || engine->getToken(x, y)) {
+            std::cout << "ERROR bad TURN" << std::endl;
+            return;
+        }
+        if (own == EMPTY_STONE)
+            own = WHITE_STONE;
+        // The manager judges the opponent's moves, ours may forbid what its rules allow
+        engine->forceToken(x, y, opponent(own));
+        play();
+    }
+    // Stones come in the order they were played, 1 ours and 2 the opponent's
+    void board() {
+        std::vector<std::array<int, 3>> stones;
+        std::string line;
+        while (std::getline(std::cin, line) && line.compare(0, 4, "DONE") != 0) {
+            std::array<int, 3> s{};
+            if (std::sscanf(line.c_str(), "%d,%d,%d", &s[0], &s[1], &s[2]) == 3)
+                stones.push_back(s);
+        }
+        if (!engine) {
+            std::cout << "ERROR no START yet" << std::endl;
+            return;
+        }
+        const long ours = std::count_if(stones.begin(), stones.end(), [](const std::array<int, 3> &s) { return s[2] == 1; });
+        // Black moves first, so with even counts it is black to move
+        own = ours * 2 == static_cast<long>(stones.size()) ? BLACK_STONE : WHITE_STONE;
+        engine->reset();
+        // The manager's record, forced in whatever our rules say so both boards agree
+        for (const auto &s : stones)
+            if (onBoard(s[0], s[1]))
+                engine->forceToken(s[0], s[1], s[2] == 1 ? own : opponent(own));
+        play();
+    }
+    void takeback(std::istream &in) {
+        int x, y;
+        if (!readMove(in, x, y) || !onBoard(x, y)) {
+            std::cout << "ERROR bad TAKEBACK" << std::endl;
+            return;
+        }
+        if (!engine->takeBack(x, y)) {
+            std::cout << "ERROR " << x << "," << y << " is not the last move" << std::endl;
+            return;
+        }
+        std::cout << "OK" << std::endl;
+    }
+    void info(std::istream &in) {
+        std::string key;
+        long long value{0};
+        in >> key >> value;
+        if (key == "timeout_turn")
+            turnSeconds = value / 1000.0;
+        else if (key == "time_left")
+            timeLeft = value / 1000.0;
+        else if (key == "max_memory")
+            limits.memory = static_cast<uint64_t>(value * MEMORY_SHARE);
+        else if (key == "rule" && !fixedRules) {
+            const char *next = value & RULE_RENJU ? RenjuLike::name
+                               : value & RULE_EXACT_FIVE ? StandardGomoku::name
+                               : Freestyle::name;
+            if (rules != next) {
+                rules = next;
+                if (engine)
+                    create(size);
+            }
+        }
+    }
+
+    void play() {
+        SearchLimits turnLimits = limits;
+        double budget = turnSeconds;
+        // Assume the game needs about 10 more moves of ours when the match clock runs
+        if (timeLeft >= 0)
+            budget = std::min(budget, timeLeft / 10);
+        turnLimits.seconds = std::max(0.01, budget * TURN_TIME_SHARE);
+
+        Move move = engine->predictMove(own, turnLimits);
+        if (engine->getToken(move.x, move.y) || !engine->setToken(move.x, move.y, own)) {
+            // No candidate found, take any legal cell
+            move.valid = false;
+            for (int y = 0; y < size && !move.valid; ++y)
+                for (int x = 0; x < size && !move.valid; ++x)
+                    if (!engine->getToken(x, y) && engine->setToken(x, y, own)) {
+                        move.x = x;
+                        move.y = y;
+                        move.valid = true;
+                    }
+        }
+        if (trace)
+            trace->flush();
+        const SearchStats &stats = engine->stats();
+        std::cout << "MESSAGE nodes " << stats.nodes << " time " << stats.seconds << "s" << std::endl;
+        if (jsonStats)
+            std::cout << "DEBUG " << stats.to_json() << std::endl;
+        std::cout << int(move.x) << "," << int(move.y) << std::endl;
+    }
+};
+
+int bench(int depth)
+{
+    const BenchResult result = runBench(depth, &std::cerr);
+    std::cout << "positions " << result.positions << " depth " << depth << std::endl;
+    std::cout << "nodes " << result.nodes << std::endl;
+    std::cout << "nps " << static_cast<uint64_t>(result.seconds > 0 ? result.nodes / result.seconds : 0) << std::endl;
+    return 0;
+}
+
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 1 && !std::strcmp(argv[1], "bench"))
+        return bench(argc > 2 ? std::atoi(argv[2]) : BENCH_DEPTH);
+
+    std::string rules;
+    int depth = SearchLimits().depth;
+    bool jsonStats = false;
+    std::string tracePath;
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--rules") && i + 1 < argc)
+            rules = argv[++i];
+        else if (!std::strcmp(argv[i], "--depth") && i + 1 < argc)
+            depth = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--stats"))
+            jsonStats = true;
+        else if (!std::strcmp(argv[i], "--trace") && i + 1 < argc)
+            tracePath = argv[++i];
+        else {
+            std::cerr << "usage: " << argv[0] <<  " [--rules pro-captures|freestyle|standard|renju] [--depth N] [--stats] [--trace FILE]" << std::endl;
+            return 1;
+        }
+    }
+    if (!rules.empty() && !Engine::create(BOARD_SIZE, rules)) {
+        std::cerr << "unknown rules " << rules << std::endl;
+        return 1;
+    }
+
+    TraceWriter trace;
+    if (!tracePath.empty()) {
+        if (!Engine::create()->traceTo(&trace)) {
+            std::cerr << "--trace needs a build with -DGOMOKU_SEARCH_TRACE=ON" << std::endl;
+            return 1;
+        }
+        if (!trace.open(tracePath, BOARD_SIZE)) {
+            std::cerr << "cannot write " << tracePath << std::endl;
+            return 1;
+        }
+    }
+
+    Piskvork protocol(rules, depth, jsonStats, trace.is_open() ? &trace : nullptr, tracePath);
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        line.erase(line.find_last_not_of("\r\n ") + 1);
+        if (!protocol.command(line))
+            break;
+    }
+    return 0;
+}
@@ -0,0 +1,293 @@
+//
+// Microbenchmarks of the board primitives on a fixed corpus of positions.
+// Every benchmark is warmed up, then repeated; the summary is per call, in nanoseconds.
+// Usage: microbench [--reps R] [--warmup W] [--filter NAME] [--json FILE|-]
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "board.hpp"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int CORPUS_SIZE = 32;
+constexpr unsigned CORPUS_SEED = 20210609;
+// Moves tried on every position by the make/unmake and Eval benchmarks
+constexpr int MOVES_PER_POSITION = 16;
+
+// Keeps results alive so the compiler cannot drop the measured calls
+volatile int64_t sink;
+
+struct Position
+{
+    std::unique_ptr<Board> board{new Board()};
+    bool is_black{true};
+    std::vector<int16_t> moves;   // empty candidate cells
+    std::vector<int16_t> stones;  // cells with a stone, for the five checks
+};
+
+// Random games of 8 to 60 stones around the center, the same on every run and machine
+std::vector<Position> makeCorpus()
+{
+    std::mt19937 rng(CORPUS_SEED);
+    std::vector<Position> corpus(CORPUS_SIZE);
+    for (int i = 0; i < CORPUS_SIZE; ++i) {
+        Position &p = corpus[i];
+        const int stones = 8 + i * 52 / CORPUS_SIZE;
+        for (int placed = 0, tries = 0; placed < stones && tries < 10000; ++tries) {
+            std::vector<int16_t> candidates;
+            for (int y = 0; y < BOARD_SIZE; ++y)
+                for (int x = 0; x < BOARD_SIZE; ++x)
+                    if (p.board->move_map[y * BOARD_SIZE + x] && p.board->getToken(x, y) == BoardBase::EMPTY)
+                        candidates.push_back(static_cast<int16_t>(x | y << 8));
+            const int16_t m = candidates[rng() % candidates.size()];
+            uint8_t captures{0};
+            if (p.board->place_stone_on_board(m & 0xFF, m >> 8, p.is_black, &captures)) {
+                if (p.board->is_five(m & 0xFF, m >> 8, p.is_black)
+                        || p.board->black_captures_count >= 5 || p.board->white_captures_count >= 5) {
+                    p.board->remove_stone_from_board(m & 0xFF, m >> 8, p.is_black, &captures);
+                    continue;
+                }
+                p.is_black = !p.is_black;
+                ++placed;
+            }
+        }
+        for (int y = 0; y < BOARD_SIZE && static_cast<int>(p.moves.size()) < MOVES_PER_POSITION; ++y)
+            for (int x = 0; x < BOARD_SIZE && static_cast<int>(p.moves.size()) < MOVES_PER_POSITION; ++x)
+                if (p.board->move_map[y * BOARD_SIZE + x] && p.board->getToken(x, y) == BoardBase::EMPTY)
+                    p.moves.push_back(static_cast<int16_t>(x | y << 8));
+        for (int y = 0; y < BOARD_SIZE && static_cast<int>(p.stones.size()) < MOVES_PER_POSITION; ++y)
+            for (int x = 0; x < BOARD_SIZE && static_cast<int>(p.stones.size()) < MOVES_PER_POSITION; ++x)
+                if (p.board->getToken(x, y) != BoardBase::EMPTY)
+                    p.stones.push_back(static_cast<int16_t>(x | y << 8));
+    }
+    return corpus;
+}
+
+// One repetition, returns the nanoseconds spent in the measured calls and how many calls there were
+using Run = std::function<void(std::vector<Position> &, double &ns, uint64_t &calls)>;
+
+struct Benchmark
+{
+    const char *name;
+    Run run;
+};
+
+struct Summary
+{
+    std::string name;
+    uint64_t calls;
+    double min, median, mean, stddev, max;   // ns per call over the repetitions
+};
+
+double since(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+}
+
+// Moves of every position are played one after another and taken back in reverse,
+// placing and removing are timed apart
+void makeUnmake(std::vector<Position> &corpus, double &ns, uint64_t &calls, bool timePlace)
+{
+    for (Position &p : corpus) {
+        Board &board = *p.board;
+        uint8_t captures[MOVES_PER_POSITION]{};
+        bool placed[MOVES_PER_POSITION]{};
+        bool is_black = p.is_black;
+        auto start = Clock::now();
+        for (size_t i = 0; i < p.moves.size(); ++i, is_black = !is_black)
+            placed[i] = board.place_stone_on_board(p.moves[i] & 0xFF, p.moves[i] >> 8, is_black, &captures[i]);
+        if (timePlace) {
+            ns += since(start);
+            calls += p.moves.size();
+        }
+        start = Clock::now();
+        for (size_t i = p.moves.size(); i-- > 0;)
+            if (placed[i])
+                board.remove_stone_from_board(p.moves[i] & 0xFF, p.moves[i] >> 8, (i % 2 == 0) == p.is_black, &captures[i]);
+        if (!timePlace) {
+            ns += since(start);
+            calls += std::count(placed, placed + p.moves.size(), true);
+        }
+    }
+}
+
+const Benchmark BENCHMARKS[] = {
+        {"place_stone_on_board", [](std::vector<Position> &corpus, double &ns, uint64_t &calls) {
+            makeUnmake(corpus, ns, calls, true);
+        }},
+        {"remove_stone_from_board", [](std::vector<Position> &corpus, double &ns, uint64_t &calls) {
+            makeUnmake(corpus, ns, calls, false);
+        }},
+        // After every move like in the search, so only the lines through the move are rescored
+        {"Eval", [](std::vector<Position> &corpus, double &ns, uint64_t &calls) {
+            for (Position &p : corpus)
+                for (int16_t m : p.moves) {
+                    uint8_t captures{0};
+                    if (!p.board->place_stone_on_board(m & 0xFF, m >> 8, p.is_black, &captures))
+                        continue;
+                    const auto start = Clock::now();
+                    sink = p.board->Eval();
+                    ns += since(start);
+                    ++calls;
+                    p.board->remove_stone_from_board(m & 0xFF, m >> 8, p.is_black, &captures);
+                }
+        }},
+        {"PtrGlobalMatch", [](std::vector<Position> &corpus, double &ns, uint64_t &calls) {
+            const auto start = Clock::now();
+            int64_t count{0};
+            for (Position &p : corpus) {
+                const Board &b = *p.board;
+                count += b.PtrGlobalMatch(b.rows, bFree3_1) + b.PtrGlobalMatch(b.columns, bFree3_1)
+                         + b.PtrGlobalMatch(b.up, bFree3_1, true) + b.PtrGlobalMatch(b.down, bFree3_1, true);
+            }
+            sink = count;
+            ns += since(start);
+            calls += corpus.size() * 4;
+        }},
+        {"is_five", [](std::vector<Position> &corpus, double &ns, uint64_t &calls) {
+            const auto start = Clock::now();
+            int64_t count{0};
+            for (Position &p : corpus)
+                for (int16_t s : p.stones)
+                    count += p.board->is_five(s & 0xFF, s >> 8, p.board->black_board[s >> 8] & (Board::TOP >> (s & 0xFF)));
+            sink = count;
+            ns += since(start);
+            for (Position &p : corpus)
+                calls += p.stones.size();
+        }},
+        // The 4 directions through every candidate, like the double three check
+        {"Patterns::getFlat", [](std::vector<Position> &corpus, double &ns, uint64_t &calls) {
+            static const int DIRS[4][2] = {{1, 0}, {0, 1}, {1, 1}, {1, -1}};
+            const auto start = Clock::now();
+            int64_t count{0};
+            for (Position &p : corpus)
+                for (int16_t m : p.moves)
+                    for (const auto &d : DIRS) {
+                        char flat[BOARD_SIZE + 1]{};
+                        std::memset(flat, 'x', BOARD_SIZE);
+                        Patterns::getFlat(m & 0xFF, m >> 8, d[0], d[1], p.is_black ? BLACK_STONE : WHITE_STONE, 5,
+                                          p.board->black_board, p.board->white_board, flat);
+                        count += flat[BOARD_SIZE / 2 + 1];
+                    }
+            sink = count;
+            ns += since(start);
+            for (Position &p : corpus)
+                calls += p.moves.size() * 4;
+        }},
+        {"get_hash", [](std::vector<Position> &corpus, double &ns, uint64_t &calls) {
+            const auto start = Clock::now();
+            uint64_t hash{0};
+            for (Position &p : corpus)
+                hash ^= p.board->get_hash();
+            sink = static_cast<int64_t>(hash);
+            ns += since(start);
+            calls += corpus.size();
+        }},
+};
+
+Summary measure(const Benchmark &bench, std::vector<Position> &corpus, int warmup, int reps)
+{
+    std::vector<double> perCall;
+    uint64_t calls{0};
+    for (int r = 0; r < warmup + reps; ++r) {
+        double ns{0};
+        uint64_t n{0};
+        bench.run(corpus, ns, n);
+        if (r >= warmup && n) {
+            perCall.push_back(ns / n);
+            calls = n;
+        }
+    }
+    Summary s{bench.name, calls, 0, 0, 0, 0, 0};
+    if (perCall.empty())
+        return s;
+    std::sort(perCall.begin(), perCall.end());
+    s.min = perCall.front();
+    s.max = perCall.back();
+    s.median = perCall[perCall.size() / 2];
+    for (double v : perCall)
+        s.mean += v / perCall.size();
+    for (double v : perCall)
+        s.stddev += (v - s.mean) * (v - s.mean) / perCall.size();
+    s.stddev = std::sqrt(s.stddev);
+    return s;
+}
+
+void writeJson(std::ostream &out, const std::vector<Summary> &results, int warmup, int reps)
+{
+    out << "{\n  \"board_size\": " << BOARD_SIZE << ",\n  \"corpus\": " << CORPUS_SIZE
+        << ",\n  \"warmup\": " << warmup << ",\n  \"reps\": " << reps << ",\n  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Summary &s = results[i];
+        out << "    {\"name\": \"" << s.name << "\", \"calls\": " << s.calls << ", \"unit\": \"ns\", \"min\": " << s.min
+            << ", \"median\": " << s.median << ", \"mean\": " << s.mean << ", \"stddev\": " << s.stddev
+            << ", \"max\": " << s.max << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+}
+
+int usage(const char *argv0)
+{
+    std::cerr << "usage: " << argv0 << " [--reps R] [--warmup W] [--filter NAME] [--json FILE|-]" << std::endl;
+    return 1;
+}
+
+}
+
+int main(int argc, char **argv)
+{
+    int reps{20}, warmup{3};
+    std::string filter, json;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--reps" && hasValue)
+            reps = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--warmup" && hasValue)
+            warmup = std::max(0, std::atoi(argv[++i]));
+        else if (arg == "--filter" && hasValue)
+            filter = argv[++i];
+        else if (arg == "--json" && hasValue)
+            json = argv[++i];
+        else
+            return usage(argv[0]);
+    }
+
+    std::vector<Position> corpus = makeCorpus();
+    std::vector<Summary> results;
+    for (const Benchmark &bench : BENCHMARKS) {
+        if (!filter.empty() && std::string(bench.name).find(filter) == std::string::npos)
+            continue;
+        results.push_back(measure(bench, corpus, warmup, reps));
+        const Summary &s = results.back();
+        if (json != "-")
+            std::printf("%-24s %8llu calls  min %9.1f  median %9.1f  mean %9.1f  stddev %7.1f  max %9.1f ns\n",
+                        s.name.c_str(), static_cast<unsigned long long>(s.calls), s.min, s.median, s.mean, s.stddev, s.max);
+    }
+
+    if (json == "-")
+        writeJson(std::cout, results, warmup, reps);
+    else if (!json.empty()) {
+        std::ofstream out(json);
+        if (!out) {
+            std::cerr << "cannot write " << json << std::endl;
+            return 1;
+        }
+        writeJson(out, results, warmup, reps);
+    }
+    return 0;
+}
@@ -0,0 +1,289 @@
+//
+// Counts move sequences to a depth the way the search plays them, generate_moves and make_move / unmake_move,
+// checking after every unmake that the whole BoardState came back and that its representations agree.
+// With --place the moves are instead the legal empty cells next to a stone, played through
+// place_stone_on_board / remove_stone_from_board like Game. A finished game is played through.
+// Usage: perft [--depth D] [--size 15|19] [--rules NAME] [--threads N] [--position "x,y x,y ..."] [--place] [--no-check]
+//
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "board.hpp"
+
+namespace {
+
+// Stones in playing order, black first
+const char *const POSITIONS[] = {
+        "7,7",
+        "7,7 8,8 6,8 8,6",
+        // black captures 7,7 8,7 by playing 9,7
+        "6,7 7,7 3,3 8,7",
+        "7,7 7,8 8,8 6,6 8,7 8,6 9,7 6,8 10,7",
+        // black open twos next to each other, several double threes to refuse
+        "6,6 11,11 7,6 11,3 6,8 3,11 7,9 3,3",
+};
+
+struct Settings
+{
+    int depth{3};
+    int size{BOARD_SIZE};
+    std::string rules{ProCaptures::name};
+    int threads{static_cast<int>(std::max(1u, std::thread::hardware_concurrency()))};
+    std::vector<std::string> positions;
+    bool place{false};
+    bool check{true};
+};
+
+// First failed check of any thread, with the moves that led to it
+struct Failure
+{
+    std::atomic<bool> failed{false};
+    std::mutex mutex;
+    std::string message;
+
+    void report(const std::string &what, const std::vector<int16_t> &path) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (failed)
+            return;
+        std::ostringstream out;
+        out << what << " after";
+        for (int16_t m : path)
+            out << " " << (m & 0xFF) << "," << (m >> 8);
+        message = out.str();
+        failed = true;
+    }
+};
+
+template<int N, class Rules>
+struct Perft
+{
+    using Board = BasicBoard<N, Rules>;
+    using State = typename Board::State;
+
+    // unmake_move restores all of it, field by field so padding is left out
+    static bool same(const State &a, const State &b) {
+        return std::equal(a.black_board, a.black_board + N, b.black_board)
+               && std::equal(a.white_board, a.white_board + N, b.white_board)
+               && a.hash == b.hash
+               && a.start_x == b.start_x && a.start_y == b.start_y && a.end_x == b.end_x && a.end_y == b.end_y
+               && a.black_captures_count == b.black_captures_count && a.white_captures_count == b.white_captures_count
+               && std::equal(a.move_map, a.move_map + N * N, b.move_map)
+               && a.moveX == b.moveX && a.moveY == b.moveY && a.move == b.move && a.result == b.result
+               && a.lastMoveIsCapture == b.lastMoveIsCapture
+               && a.line_keys == b.line_keys
+               && !std::memcmp(&a.rows, &b.rows, sizeof(a.rows)) && !std::memcmp(&a.columns, &b.columns, sizeof(a.columns))
+               && !std::memcmp(&a.down, &b.down, sizeof(a.down)) && !std::memcmp(&a.up, &b.up, sizeof(a.up));
+    }
+
+    // What remove_stone_from_board has to restore, the search box only ever grows there
+    struct Snapshot
+    {
+        uint64_t hash;
+        uint64_t captures[2];
+        typename Board::Row black[N], white[N];
+
+        explicit Snapshot(const Board &board) : hash(board.position_hash()),
+                captures{board.black_captures_count, board.white_captures_count} {
+            std::copy(board.black_board, board.black_board + N, black);
+            std::copy(board.white_board, board.white_board + N, white);
+        }
+        bool operator==(const Snapshot &o) const {
+            return hash == o.hash && captures[0] == o.captures[0] && captures[1] == o.captures[1]
+                   && std::equal(black, black + N, o.black) && std::equal(white, white + N, o.white);
+        }
+    };
+
+    const Settings &settings;
+    Failure &failure;
+
+    // false when a stone of the position cannot be played
+    static bool setup(Board &board, const std::string &position, bool &is_black) {
+        std::istringstream in(position);
+        std::string move;
+        is_black = true;
+        while (in >> move) {
+            int x, y;
+            uint8_t captures{0};
+            if (std::sscanf(move.c_str(), "%d,%d", &x, &y) != 2 || x < 0 || y < 0 || x >= N || y >= N
+                    || board.getToken(x, y) != BoardBase::EMPTY || !board.place_stone_on_board(x, y, is_black, &captures))
+                return false;
+            is_black = !is_black;
+        }
+        return true;
+    }
+
+    // The moves of the search, captures first and only those played with captures like minimax does;
+    // with --place every empty cell next to a stone
+    std::vector<int16_t> candidates(const Board &board, bool is_black, int &captures_count) const {
+        std::vector<int16_t> moves;
+        if (!settings.place) {
+            int16_t generated[N * N];
+            const int count = board.generate_moves(is_black, generated, &captures_count);
+            return std::vector<int16_t>(generated, generated + count);
+        }
+        captures_count = 0;
+        for (int y = 0; y < N; ++y)
+            for (int x = 0; x < N; ++x)
+                if (board.move_map[y * N + x] && !((board.black_board[y] | board.white_board[y]) & (Board::TOP >> x)))
+                    moves.push_back(static_cast<int16_t>(x | y << 8));
+        return moves;
+    }
+
+    void check(const Board &board, bool restored, const char *what, const std::vector<int16_t> &path) {
+        if (!settings.check || failure.failed)
+            return;
+        std::string error;
+        if (!restored)
+            failure.report(what, path);
+        else if (!board.check_invariants(&error))
+            failure.report(error, path);
+    }
+
+    // Plays m, counts below it and takes it back, 0 with nothing counted when m is illegal
+    uint64_t step(Board &board, int16_t m, bool captures, int depth, bool is_black, std::vector<int16_t> &path) {
+        const int8_t x = m & 0xFF, y = m >> 8;
+        uint64_t nodes;
+        if (!settings.place) {
+            const State before = board.state();
+            UndoRecord undo;
+            board.make_move(x, y, is_black, captures, undo);
+            path.push_back(m);
+            nodes = depth == 1 ? 1 : count(board, depth - 1, !is_black, path);
+            board.unmake_move(undo);
+            check(board, !settings.check || same(board.state(), before), "unmake_move did not restore the BoardState", path);
+        } else {
+            const Snapshot before(board);
+            uint8_t captured{0};
+            if (!board.place_stone_on_board(x, y, is_black, &captured))
+                return 0;
+            path.push_back(m);
+            nodes = depth == 1 ? 1 : count(board, depth - 1, !is_black, path);
+            board.remove_stone_from_board(x, y, is_black, &captured);
+            check(board, Snapshot(board) == before, "unmake did not restore hash, bitboards or capture counts", path);
+        }
+        path.pop_back();
+        return nodes;
+    }
+
+    uint64_t count(Board &board, int depth, bool is_black, std::vector<int16_t> &path) {
+        int captures_count;
+        const std::vector<int16_t> moves = candidates(board, is_black, captures_count);
+        uint64_t nodes{0};
+        for (size_t i = 0; i < moves.size(); ++i) {
+            if (failure.failed)
+                break;
+            nodes += step(board, moves[i], static_cast<int>(i) < captures_count, depth, is_black, path);
+        }
+        return nodes;
+    }
+
+    // Root moves are shared out between the threads, each with its own board
+    uint64_t run(const std::string &position, int depth) {
+        Board root;
+        bool is_black;
+        if (!setup(root, position, is_black)) {
+            failure.report("illegal position \"" + position + "\"", {});
+            return 0;
+        }
+        int captures_count;
+        const std::vector<int16_t> moves = candidates(root, is_black, captures_count);
+        std::atomic<size_t> next{0};
+        std::atomic<uint64_t> total{0};
+        auto worker = [&]() {
+            Board board;
+            bool black;
+            setup(board, position, black);
+            std::vector<int16_t> path;
+            for (size_t i = next++; i < moves.size() && !failure.failed; i = next++)
+                total += step(board, moves[i], static_cast<int>(i) < captures_count, depth, black, path);
+        };
+        std::vector<std::thread> threads;
+        for (int i = 0; i < settings.threads; ++i)
+            threads.emplace_back(worker);
+        for (auto &t : threads)
+            t.join();
+        return total;
+    }
+};
+
+template<int N, class Rules>
+int run(const Settings &settings)
+{
+    Failure failure;
+    Perft<N, Rules> perft{settings, failure};
+    uint64_t all{0};
+    double seconds{0};
+    for (size_t p = 0; p < settings.positions.size(); ++p)
+        for (int depth = 1; depth <= settings.depth; ++depth) {
+            const auto start = std::chrono::steady_clock::now();
+            const uint64_t nodes = perft.run(settings.positions[p], depth);
+            const double took = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            if (failure.failed) {
+                std::printf("FAILED position %zu depth %d: %s\n", p, depth, failure.message.c_str());
+                return 1;
+            }
+            all += nodes;
+            seconds += took;
+            std::printf("position %zu depth %d nodes %llu time %.3fs nps %.0f\n", p, depth,
+                        static_cast<unsigned long long>(nodes), took, took > 0 ? nodes / took : 0);
+            std::fflush(stdout);
+        }
+    std::printf("total nodes %llu time %.3fs nps %.0f%s%s\n", static_cast<unsigned long long>(all), seconds,
+                seconds > 0 ? all / seconds : 0, settings.place ? " (place/remove)" : "",
+                settings.check ? " (with checks)" : "");
+    return 0;
+}
+
+int usage(const char *argv0)
+{
+    std::cerr << "usage: " << argv0 << " [--depth D] [--size 15|19] [--rules NAME] [--threads N]"
+                                       " [--position \"x,y x,y ...\"] [--place] [--no-check]" << std::endl;
+    return 1;
+}
+
+}
+
+int main(int argc, char **argv)
+{
+    Settings settings;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--depth" && hasValue)
+            settings.depth = std::atoi(argv[++i]);
+        else if (arg == "--size" && hasValue)
+            settings.size = std::atoi(argv[++i]);
+        else if (arg == "--rules" && hasValue)
+            settings.rules = argv[++i];
+        else if (arg == "--threads" && hasValue)
+            settings.threads = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--position" && hasValue)
+            settings.positions.push_back(argv[++i]);
+        else if (arg == "--place")
+            settings.place = true;
+        else if (arg == "--no-check")
+            settings.check = false;
+        else
+            return usage(argv[0]);
+    }
+    if (settings.positions.empty())
+        settings.positions.assign(std::begin(POSITIONS), std::end(POSITIONS));
+
+# define GOMOKU_RUN_PERFT(N, R) \
+    if (settings.size == N && settings.rules == R::name) \
+        return run<N, R>(settings);
+    GOMOKU_FOR_EACH_VARIANT(GOMOKU_RUN_PERFT)
+# undef GOMOKU_RUN_PERFT
+    std::cerr << "unsupported size " << settings.size << " or rules " << settings.rules << std::endl;
+    return 1;
+}
@@ -0,0 +1,176 @@
+//
+// Builds and queries position databases (include/posdb.hpp) from binary game records.
+// Usage: posdb build DB RECORDS... [--size N]
+//        posdb info DB [--top N]
+//        posdb lookup DB RECORDS...
+// build adds every position of every game, the one before each move with that move's player to move
+// and the final one. lookup replays games the same way and counts the positions already in the database.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "engine.hpp"
+#include "posdb.hpp"
+#include "record.hpp"
+
+namespace {
+
+// Calls visit for each position of each game of the records of this board size, false on unreadable files
+template<class Visit>
+bool forEachPosition(const std::vector<std::string> &paths, int size, uint64_t &skipped, Visit visit)
+{
+    for (const std::string &path : paths) {
+        RecordReader reader;
+        if (!reader.open(path)) {
+            std::cerr << reader.error() << std::endl;
+            return false;
+        }
+        RecordView game;
+        while (reader.next(game)) {
+            if (game.size() != size) {
+                ++skipped;
+                continue;
+            }
+            std::unique_ptr<Engine> engine = Engine::create(game.size(), game.rules());
+            bool legal = engine != nullptr;
+            for (int i = 0; legal && i < game.moves(); ++i) {
+                visit(pack_position(*engine));
+                const int16_t move = game.move(i);
+                const int8_t x = move & 0xFF, y = move >> 8;
+                legal = !engine->getToken(x, y) && engine->setToken(x, y, i % 2 ? WHITE_STONE : BLACK_STONE);
+            }
+            if (legal)
+                visit(pack_position(*engine));
+            else
+                ++skipped;
+        }
+        if (!reader.error().empty()) {
+            std::cerr << path << ": " << reader.error() << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+double since(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int build(const std::string &path, const std::vector<std::string> &records, int size)
+{
+    const auto start = std::chrono::steady_clock::now();
+    PositionDbBuilder builder(size);
+    uint64_t skipped{0};
+    if (!forEachPosition(records, size, skipped, [&](const PackedPosition &p) { builder.add(p); }))
+        return 1;
+    const size_t added = builder.added();
+    uint64_t unique{0};
+    if (!builder.write(path, &unique)) {
+        std::cerr << "cannot write " << path << std::endl;
+        return 1;
+    }
+    std::cout << "positions " << added << " unique " << unique << " games skipped " << skipped
+              << " in " << since(start) << "s" << std::endl;
+    return 0;
+}
+
+int info(const std::string &path, int top)
+{
+    PositionDb db;
+    if (!db.open(path)) {
+        std::cerr << db.error() << std::endl;
+        return 1;
+    }
+    uint64_t total{0}, collisions{0};
+    for (const PackedPosition *p = db.begin(); p != db.end(); ++p) {
+        total += p->count;
+        collisions += p != db.begin() && p[-1].key == p->key;
+    }
+    std::cout << "size " << db.board_size() << " positions " << db.count() << " added " << total
+              << " key collisions " << collisions << std::endl;
+
+    std::vector<const PackedPosition *> seen;
+    for (const PackedPosition *p = db.begin(); p != db.end(); ++p)
+        seen.push_back(p);
+    top = static_cast<int>(std::min<size_t>(top, seen.size()));
+    std::partial_sort(seen.begin(), seen.begin() + top, seen.end(),
+                      [](const PackedPosition *a, const PackedPosition *b) { return a->count > b->count; });
+    for (int i = 0; i < top; ++i) {
+        const PackedPosition &p = *seen[i];
+        int stones{0};
+        for (int y = 0; y < db.board_size(); ++y)
+            for (int x = 0; x < db.board_size(); ++x)
+                stones += p.cell(x, y, db.board_size()) != EMPTY_STONE;
+        std::cout << std::hex << p.key << std::dec << " count " << p.count << " stones " << stones
+                  << " to move " << (p.to_move == BLACK_STONE ? "black" : "white") << " captures "
+                  << int(p.black_captures) << ":" << int(p.white_captures) << std::endl;
+    }
+    return 0;
+}
+
+int lookup(const std::string &path, const std::vector<std::string> &records)
+{
+    PositionDb db;
+    if (!db.open(path)) {
+        std::cerr << db.error() << std::endl;
+        return 1;
+    }
+    std::vector<PackedPosition> positions;
+    uint64_t skipped{0};
+    if (!forEachPosition(records, db.board_size(), skipped, [&](const PackedPosition &p) { positions.push_back(p); }))
+        return 1;
+    // Timed apart from the replay, which costs far more than the lookups
+    const auto start = std::chrono::steady_clock::now();
+    uint64_t hits{0};
+    for (const PackedPosition &p : positions)
+        hits += db.find(p) != nullptr;
+    const double seconds = since(start);
+    std::cout << "positions " << positions.size() << " seen " << hits << " new " << positions.size() - hits
+              << " games skipped " << skipped << std::endl;
+    std::cout << "looked up in " << seconds << "s, "
+              << static_cast<uint64_t>(seconds > 0 ? positions.size() / seconds : 0) << " lookups/s" << std::endl;
+    return 0;
+}
+
+int usage(const char *argv0)
+{
+    std::cerr << "usage: " << argv0 << " build DB RECORDS... [--size N]\n"
+                 "       " << argv0 << " info DB [--top N]\n"
+                 "       " << argv0 << " lookup DB RECORDS..." << std::endl;
+    return 1;
+}
+
+}
+
+int main(int argc, char **argv)
+{
+    const std::string command = argc > 1 ? argv[1] : "";
+    std::vector<std::string> files;
+    int size{BOARD_SIZE}, top{0};
+    for (int i = 2; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--size" && i + 1 < argc)
+            size = std::atoi(argv[++i]);
+        else if (arg == "--top" && i + 1 < argc)
+            top = std::atoi(argv[++i]);
+        else
+            files.push_back(arg);
+    }
+    if (files.empty())
+        return usage(argv[0]);
+    const std::string db = files.front();
+    files.erase(files.begin());
+    if (command == "build" && !files.empty())
+        return build(db, files, size);
+    if (command == "info" && files.empty())
+        return info(db, std::max(top, 0));
+    if (command == "lookup" && !files.empty())
+        return lookup(db, files);
+    return usage(argv[0]);
+}
@@ -0,0 +1,447 @@
+//
+// Self-play tournament between two engine configurations, or against another build speaking Piskvork.
+// Games run concurrently, one referee board per game, every random opening is played with both colors.
+// Usage: tournament --a depth=3,time=0.49 --b cmd=/path/to/old/gomoku_cli,time=0.49 [options]
+//
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "engine.hpp"
+#include "record.hpp"
+
+namespace {
+
+struct Stone
+{
+    int8_t x;
+    int8_t y;
+};
+
+// One side of the match, "depth=3,time=0.49,memory=0" or "cmd=<piskvork engine>,time=0.49"
+struct Side
+{
+    std::string name;
+    std::string cmd;
+    SearchLimits limits;
+
+    static bool parse(const std::string &name, const std::string &spec, Side &side) {
+        side.name = name;
+        std::istringstream in(spec);
+        std::string item;
+        while (std::getline(in, item, ',')) {
+            const auto eq = item.find('=');
+            if (eq == std::string::npos)
+                return false;
+            const std::string key = item.substr(0, eq), value = item.substr(eq + 1);
+            if (key == "depth")
+                side.limits.depth = std::atoi(value.c_str());
+            else if (key == "time")
+                side.limits.seconds = std::atof(value.c_str());
+            else if (key == "memory")
+                side.limits.memory = std::strtoull(value.c_str(), nullptr, 10);
+            else if (key == "cmd")
+                side.cmd = value;
+            else
+                return false;
+        }
+        return true;
+    }
+};
+
+struct Settings
+{
+    Side a, b;
+    int games{100};
+    int threads{static_cast<int>(std::max(1u, std::thread::hardware_concurrency()))};
+    int size{BOARD_SIZE};
+    std::string rules{ProCaptures::name};
+    int openingStones{4};
+    int openingRadius{3};
+    unsigned seed{1};
+    double elo0{0}, elo1{5}, alpha{0.05}, beta{0.05};
+    std::string record;
+};
+
+// A side seen from one game, told the whole game so far on every turn
+class Player
+{
+public:
+    virtual ~Player() = default;
+    // false if the player failed to answer
+    virtual bool think(const std::vector<Stone> &history, int8_t color, Stone &move, uint64_t &nodes) = 0;
+};
+
+class EnginePlayer : public Player
+{
+public:
+    EnginePlayer(const Settings &settings, const Side &side)
+        : engine(Engine::create(settings.size, settings.rules)), limits(side.limits) {}
+
+    bool think(const std::vector<Stone> &history, int8_t color, Stone &move, uint64_t &nodes) override {
+        // Black plays the even plies
+        for (; seen < history.size(); ++seen)
+            engine->setToken(history[seen].x, history[seen].y, seen % 2 ? WHITE_STONE : BLACK_STONE);
+        const Move m = engine->predictMove(color, limits);
+        move = Stone{m.x, m.y};
+        nodes = engine->stats().nodes;
+        engine->setToken(m.x, m.y, color);
+        ++seen;
+        return true;
+    }
+private:
+    std::unique_ptr<Engine> engine;
+    SearchLimits limits;
+    size_t seen{0};
+};
+
+// External engine over pipes, BOARD with the game so far on the first turn and TURN afterwards
+class PiskvorkPlayer : public Player
+{
+public:
+    PiskvorkPlayer(const Settings &settings, const Side &side) {
+        int in[2], out[2];
+        if (pipe2(in, O_CLOEXEC) || pipe2(out, O_CLOEXEC))
+            return;
+        pid = fork();
+        if (pid == 0) {
+            dup2(in[0], STDIN_FILENO);
+            dup2(out[1], STDOUT_FILENO);
+            execl("/bin/sh", "sh", "-c", side.cmd.c_str(), static_cast<char *>(nullptr));
+            _exit(127);
+        }
+        close(in[0]);
+        close(out[1]);
+        to = fdopen(in[1], "w");
+        from = fdopen(out[0], "r");
+        std::fprintf(to, "INFO timeout_turn %d\n", static_cast<int>(side.limits.seconds * 1000));
+        if (side.limits.memory)
+            std::fprintf(to, "INFO max_memory %llu\n", static_cast<unsigned long long>(side.limits.memory));
+        std::fprintf(to, "START %d\n", settings.size);
+        std::fflush(to);
+        std::string line;
+        ready = readLine(line) && line.compare(0, 2, "OK") == 0;
+    }
+    ~PiskvorkPlayer() override {
+        if (to) {
+            std::fprintf(to, "END\n");
+            std::fclose(to);
+        }
+        if (from)
+            std::fclose(from);
+        if (pid > 0)
+            waitpid(pid, nullptr, 0);
+    }
+
+    bool think(const std::vector<Stone> &history, int8_t color, Stone &move, uint64_t &nodes) override {
+        if (!ready)
+            return false;
+        if (seen == 0) {
+            std::fprintf(to, "BOARD\n");
+            for (size_t i = 0; i < history.size(); ++i)
+                std::fprintf(to, "%d,%d,%d\n", history[i].x, history[i].y, (i % 2 ? WHITE_STONE : BLACK_STONE) == color ? 1 : 2);
+            std::fprintf(to, "DONE\n");
+        } else
+            std::fprintf(to, "TURN %d,%d\n", history.back().x, history.back().y);
+        std::fflush(to);
+        seen = history.size() + 1;
+
+        nodes = 0;
+        std::string line;
+        while (readLine(line)) {
+            unsigned long long n;
+            int x, y;
+            char tail;
+            if (std::sscanf(line.c_str(), "MESSAGE nodes %llu", &n) == 1)
+                nodes = n;
+            else if (std::sscanf(line.c_str(), "%d,%d%c", &x, &y, &tail) == 2) {
+                move = Stone{static_cast<int8_t>(x), static_cast<int8_t>(y)};
+                return true;
+            }
+        }
+        return false;
+    }
+private:
+    pid_t pid{-1};
+    FILE *to{nullptr};
+    FILE *from{nullptr};
+    bool ready{false};
+    size_t seen{0};
+
+    bool readLine(std::string &line) {
+        char buf[512];
+        if (!from || !std::fgets(buf, sizeof(buf), from))
+            return false;
+        line = buf;
+        line.erase(line.find_last_not_of("\r\n ") + 1);
+        return true;
+    }
+};
+
+std::unique_ptr<Player> makePlayer(const Settings &settings, const Side &side)
+{
+    if (side.cmd.empty())
+        return std::unique_ptr<Player>(new EnginePlayer(settings, side));
+    return std::unique_ptr<Player>(new PiskvorkPlayer(settings, side));
+}
+
+// Per side, over all games
+struct SideLog
+{
+    std::vector<double> latencies;
+    uint64_t nodes{0};
+    double seconds{0};
+};
+
+struct Tally
+{
+    int wins{0}, draws{0}, losses{0};   // from A's point of view
+    SideLog sides[2];
+
+    int games() const { return wins + draws + losses; }
+    double score() const { return games() ? (wins + 0.5 * draws) / games() : 0.5; }
+    // Variance of the per-game score
+    double variance() const {
+        const double s = score();
+        return games() ? (wins * (1 - s) * (1 - s) + draws * (0.5 - s) * (0.5 - s) + losses * s * s) / games() : 0;
+    }
+};
+
+double eloFromScore(double s)
+{
+    s = std::min(std::max(s, 1e-6), 1 - 1e-6);
+    return -400 * std::log10(1 / s - 1);
+}
+
+double scoreFromElo(double elo)
+{
+    return 1 / (1 + std::pow(10, -elo / 400));
+}
+
+// Log likelihood ratio of elo1 against elo0, normal approximation of the trinomial
+double sprtLLR(const Tally &t, double elo0, double elo1)
+{
+    const double var = t.variance();
+    if (t.games() < 2 || var <= 0)
+        return 0;
+    const double s0 = scoreFromElo(elo0), s1 = scoreFromElo(elo1);
+    return t.games() * (s1 - s0) * (2 * t.score() - s0 - s1) / (2 * var);
+}
+
+double percentile(std::vector<double> v, double p)
+{
+    if (v.empty())
+        return 0;
+    std::sort(v.begin(), v.end());
+    return v[std::min(v.size() - 1, static_cast<size_t>(p * v.size()))];
+}
+
+// Random stones around the center, legal for the color to play them
+std::vector<Stone> randomOpening(const Settings &settings, unsigned pair)
+{
+    std::mt19937 rng(settings.seed * 7919 + pair);
+    std::uniform_int_distribution<int> offset(-settings.openingRadius, settings.openingRadius);
+    auto board = Engine::create(settings.size, settings.rules);
+    std::vector<Stone> stones;
+    for (int tries = 0; static_cast<int>(stones.size()) < settings.openingStones && tries < 1000; ++tries) {
+        const Stone s{static_cast<int8_t>(settings.size / 2 + offset(rng)), static_cast<int8_t>(settings.size / 2 + offset(rng))};
+        if (!board->getToken(s.x, s.y) && board->setToken(s.x, s.y, stones.size() % 2 ? WHITE_STONE : BLACK_STONE)) {
+            if (board->winner() != BoardBase::NO_RESULT)
+                return stones;
+            stones.push_back(s);
+        }
+    }
+    return stones;
+}
+
+// Plays one game, 1 if A wins, 0 for a draw, -1 if B wins; record gets the moves with their time and nodes
+int playGame(const Settings &settings, int game, SideLog logs[2], GameRecord &record)
+{
+    const bool aIsBlack = game % 2 == 0;
+    std::unique_ptr<Player> players[2] = {makePlayer(settings, settings.a), makePlayer(settings, settings.b)};
+    auto referee = Engine::create(settings.size, settings.rules);
+    std::vector<Stone> history = randomOpening(settings, game / 2);
+    for (size_t i = 0; i < history.size(); ++i)
+        referee->setToken(history[i].x, history[i].y, i % 2 ? WHITE_STONE : BLACK_STONE);
+    record.size = settings.size;
+    record.rules = settings.rules;
+    for (const Stone &s : history) {
+        record.moves.push_back(static_cast<int16_t>(s.x | s.y << 8));
+        record.seconds.push_back(0);
+        record.nodes.push_back(0);
+    }
+
+    while (static_cast<int>(history.size()) < settings.size * settings.size) {
+        const int8_t color = history.size() % 2 ? WHITE_STONE : BLACK_STONE;
+        const int side = (color == BLACK_STONE) == aIsBlack ? 0 : 1;
+        const int sign = side == 0 ? 1 : -1;
+        Stone move{};
+        uint64_t nodes{0};
+        auto start = std::chrono::steady_clock::now();
+        const bool answered = players[side]->think(history, color, move, nodes);
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        logs[side].latencies.push_back(seconds);
+        logs[side].nodes += nodes;
+        logs[side].seconds += seconds;
+
+        // A silent engine, a move off the board or onto a stone, or a forbidden move loses
+        if (!answered || move.x < 0 || move.y < 0 || move.x >= settings.size || move.y >= settings.size
+                || referee->getToken(move.x, move.y) || !referee->setToken(move.x, move.y, color)) {
+            record.result = color == BLACK_STONE ? BoardBase::WHITE_WIN : BoardBase::BLACK_WIN;
+            return -sign;
+        }
+        history.push_back(move);
+        record.moves.push_back(static_cast<int16_t>(move.x | move.y << 8));
+        record.seconds.push_back(seconds);
+        record.nodes.push_back(nodes);
+        const BoardBase::Result result = referee->winner();
+        record.result = result;
+        if (result == BoardBase::DRAW)
+            return 0;
+        if (result != BoardBase::NO_RESULT)
+            return (result == BoardBase::BLACK_WIN) == (color == BLACK_STONE) ? sign : -sign;
+    }
+    record.result = BoardBase::DRAW;
+    return 0;
+}
+
+void report(const Settings &settings, const Tally &t)
+{
+    const double s = t.score(), margin = 1.96 * std::sqrt(t.variance() / std::max(1, t.games()));
+    const double elo = eloFromScore(s);
+    std::printf("games %d  A %s  B %s  +%d =%d -%d  score %.3f\n",
+                t.games(), settings.a.name.c_str(), settings.b.name.c_str(), t.wins, t.draws, t.losses, s);
+    std::printf("elo A-B %+.1f  95%% [%+.1f, %+.1f]\n", elo, eloFromScore(s - margin), eloFromScore(s + margin));
+    std::printf("sprt elo0 %.1f elo1 %.1f  llr %.2f  bounds [%.2f, %.2f]\n", settings.elo0, settings.elo1,
+                sprtLLR(t, settings.elo0, settings.elo1),
+                std::log(settings.beta / (1 - settings.alpha)), std::log((1 - settings.beta) / settings.alpha));
+    for (int side = 0; side < 2; ++side) {
+        const SideLog &log = t.sides[side];
+        std::printf("%s  moves %zu  latency p50 %.3fs p90 %.3fs p99 %.3fs max %.3fs  nps %.0f\n",
+                    side ? "B" : "A", log.latencies.size(),
+                    percentile(log.latencies, 0.5), percentile(log.latencies, 0.9), percentile(log.latencies, 0.99),
+                    percentile(log.latencies, 1), log.seconds > 0 ? log.nodes / log.seconds : 0);
+    }
+}
+
+int usage(const char *argv0)
+{
+    std::cerr << "usage: " << argv0 << " --a SIDE --b SIDE [--games N] [--threads N] [--size 15|19] [--rules NAME]\n"
+                 "       [--opening STONES] [--seed N] [--sprt ELO0 ELO1 ALPHA BETA] [--record FILE]\n"
+                 "SIDE is depth=N,time=SECONDS,memory=BYTES for this build, or cmd=COMMAND,time=SECONDS for a Piskvork engine"
+              << std::endl;
+    return 1;
+}
+
+}
+
+int main(int argc, char **argv)
+{
+    Settings settings;
+    Side::parse("default", "", settings.a);
+    Side::parse("default", "", settings.b);
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if ((arg == "--a" || arg == "--b") && hasValue) {
+            if (!Side::parse(argv[i + 1], argv[i + 1], arg == "--a" ? settings.a : settings.b))
+                return usage(argv[0]);
+            ++i;
+        } else if (arg == "--games" && hasValue)
+            settings.games = std::atoi(argv[++i]);
+        else if (arg == "--threads" && hasValue)
+            settings.threads = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--size" && hasValue)
+            settings.size = std::atoi(argv[++i]);
+        else if (arg == "--rules" && hasValue)
+            settings.rules = argv[++i];
+        else if (arg == "--opening" && hasValue)
+            settings.openingStones = std::atoi(argv[++i]);
+        else if (arg == "--seed" && hasValue)
+            settings.seed = std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--sprt" && i + 4 < argc) {
+            settings.elo0 = std::atof(argv[++i]);
+            settings.elo1 = std::atof(argv[++i]);
+            settings.alpha = std::atof(argv[++i]);
+            settings.beta = std::atof(argv[++i]);
+        } else if (arg == "--record" && i + 1 < argc)
+            settings.record = argv[++i];
+        else
+            return usage(argv[0]);
+    }
+    if (!Engine::create(settings.size, settings.rules)) {
+        std::cerr << "unsupported size " << settings.size << " or rules " << settings.rules << std::endl;
+        return 1;
+    }
+    // A Piskvork engine that dies must not take the runner with it
+    signal(SIGPIPE, SIG_IGN);
+
+    const double lower = std::log(settings.beta / (1 - settings.alpha));
+    const double upper = std::log((1 - settings.beta) / settings.alpha);
+    std::atomic<int> next{0};
+    std::atomic<bool> stop{false};
+    std::mutex mutex;
+    Tally tally;
+    RecordWriter records;
+    if (!settings.record.empty() && !records.open(settings.record)) {
+        std::cerr << "cannot append games to " << settings.record << std::endl;
+        return 1;
+    }
+
+    auto worker = [&]() {
+        for (int game = next++; game < settings.games && !stop; game = next++) {
+            SideLog logs[2];
+            GameRecord record;
+            const int outcome = playGame(settings, game, logs, record);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!settings.record.empty())
+                records.write(record);
+            tally.wins += outcome > 0;
+            tally.draws += outcome == 0;
+            tally.losses += outcome < 0;
+            for (int side = 0; side < 2; ++side) {
+                SideLog &log = tally.sides[side];
+                log.latencies.insert(log.latencies.end(), logs[side].latencies.begin(), logs[side].latencies.end());
+                log.nodes += logs[side].nodes;
+                log.seconds += logs[side].seconds;
+            }
+            const double llr = sprtLLR(tally, settings.elo0, settings.elo1);
+            std::printf("game %d  A %s  %s  llr %.2f\n", game, game % 2 ? "white" : "black",
+                        outcome > 0 ? "1-0" : outcome < 0 ? "0-1" : "1/2", llr);
+            std::fflush(stdout);
+            if (llr <= lower || llr >= upper)
+                stop = true;
+        }
+    };
+    std::vector<std::thread> threads;
+    for (int i = 0; i < settings.threads; ++i)
+        threads.emplace_back(worker);
+    for (auto &t : threads)
+        t.join();
+
+    report(settings, tally);
+    const double llr = sprtLLR(tally, settings.elo0, settings.elo1);
+    if (llr >= upper)
+        std::printf("sprt: H1 accepted, A is stronger by at least %.1f elo\n", settings.elo1);
+    else if (llr <= lower)
+        std::printf("sprt: H0 accepted, A is not stronger by %.1f elo\n", settings.elo1);
+    else
+        std::printf("sprt: no verdict after %d games\n", tally.games());
+    return 0;
+}
@@ -0,0 +1,176 @@
+//
+// Reads search traces written with GOMOKU_SEARCH_TRACE, see include/trace.hpp.
+// Usage: trace_reader FILE summary
+//        trace_reader FILE tree [SEARCH [NODE [DEPTH]]]
+//
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+#include "trace.hpp"
+
+namespace {
+
+const char *const REASONS[] = {"depth", "time", "five", "capture-win", "cutoff", "all-moves", "root"};
+constexpr int REASONS_COUNT = sizeof(REASONS) / sizeof(*REASONS);
+
+std::string scoreText(int32_t score)
+{
+    if (score == std::numeric_limits<int32_t>::min())
+        return "-inf";
+    if (score == std::numeric_limits<int32_t>::max())
+        return "+inf";
+    return std::to_string(score);
+}
+
+int reasonOf(const TraceRecord &r)
+{
+    return std::min<int>(r.flags & TRACE_REASON_MASK, REASONS_COUNT - 1);
+}
+
+struct Summary
+{
+    uint64_t searches{0};
+    uint64_t nodes{0};
+    uint64_t ttHits{0};
+    uint64_t reasons[REASONS_COUNT]{};
+    std::vector<uint64_t> plies;
+
+    void add(const std::vector<TraceRecord> &search) {
+        const TraceRecord &root = search.back();
+        uint64_t reasons[REASONS_COUNT]{}, hits{0};
+        int maxPly{0};
+        for (const TraceRecord &r : search) {
+            ++reasons[reasonOf(r)];
+            hits += (r.flags & TRACE_TT_HIT) != 0;
+            maxPly = std::max<int>(maxPly, r.ply);
+            if (plies.size() <= r.ply)
+                plies.resize(r.ply + 1);
+            ++plies[r.ply];
+        }
+        const uint64_t interior = reasons[TRACE_CUTOFF] + reasons[TRACE_ALL_MOVES];
+        std::printf("search %llu: nodes %zu best %d,%d score %s max ply %d cutoffs %llu/%llu tt hits %llu\n",
+                    static_cast<unsigned long long>(searches), search.size() - 1, root.move & 0xFF, root.move >> 8,
+                    scoreText(root.score).c_str(), maxPly, static_cast<unsigned long long>(reasons[TRACE_CUTOFF]),
+                    static_cast<unsigned long long>(interior), static_cast<unsigned long long>(hits));
+        ++searches;
+        nodes += search.size() - 1;
+        ttHits += hits;
+        for (int i = 0; i < REASONS_COUNT; ++i)
+            this->reasons[i] += reasons[i];
+    }
+    void print() const {
+        std::printf("searches %llu nodes %llu tt hits %llu\n", static_cast<unsigned long long>(searches),
+                    static_cast<unsigned long long>(nodes), static_cast<unsigned long long>(ttHits));
+        for (int i = 0; i < REASONS_COUNT; ++i)
+            if (reasons[i])
+                std::printf("  %-12s %llu\n", REASONS[i], static_cast<unsigned long long>(reasons[i]));
+        for (size_t ply = 0; ply < plies.size(); ++ply)
+            std::printf("  ply %-3zu %llu nodes\n", ply, static_cast<unsigned long long>(plies[ply]));
+    }
+};
+
+// Ids of a search are 0..n-1, children are listed in the order they were searched
+void printTree(const std::vector<TraceRecord> &search, uint32_t node, int depth)
+{
+    std::vector<const TraceRecord *> byId(search.size(), nullptr);
+    std::vector<std::vector<uint32_t>> children(search.size());
+    for (const TraceRecord &r : search)
+        if (r.id < search.size())
+            byId[r.id] = &r;
+    for (const TraceRecord &r : search)
+        if (r.parent < search.size())
+            children[r.parent].push_back(r.id);
+    for (auto &c : children)
+        std::sort(c.begin(), c.end());
+    if (node >= search.size() || !byId[node]) {
+        std::cerr << "no node " << node << " in this search" << std::endl;
+        return;
+    }
+
+    struct Item { uint32_t id; int level; };
+    std::vector<Item> stack{{node, 0}};
+    while (!stack.empty()) {
+        const Item item = stack.back();
+        stack.pop_back();
+        const TraceRecord &r = *byId[item.id];
+        std::printf("%*s#%u ply %u %d,%d score %s [%s, %s] %s%s%s\n", item.level * 2, "", r.id, r.ply,
+                    r.move & 0xFF, r.move >> 8, scoreText(r.score).c_str(), scoreText(r.alpha).c_str(),
+                    scoreText(r.beta).c_str(), REASONS[reasonOf(r)], r.flags & TRACE_TT_HIT ? " tt" : "",
+                    r.flags & TRACE_MAXIMIZER ? " max" : " min");
+        if (item.level >= depth)
+            continue;
+        const auto &c = children[item.id];
+        for (auto it = c.rbegin(); it != c.rend(); ++it)
+            stack.push_back({*it, item.level + 1});
+    }
+}
+
+int usage(const char *argv0)
+{
+    std::cerr << "usage: " << argv0 << " FILE summary\n"
+                 "       " << argv0 << " FILE tree [SEARCH [NODE [DEPTH]]]" << std::endl;
+    return 1;
+}
+
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+        return usage(argv[0]);
+    const bool tree = !std::strcmp(argv[2], "tree");
+    if (!tree && std::strcmp(argv[2], "summary"))
+        return usage(argv[0]);
+    const uint64_t wanted = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 0;
+    const uint32_t node = argc > 4 ? std::strtoul(argv[4], nullptr, 10) : 0;
+    const int depth = argc > 5 ? std::atoi(argv[5]) : 1;
+
+    std::FILE *file = std::fopen(argv[1], "rb");
+    if (!file) {
+        std::cerr << "cannot open " << argv[1] << std::endl;
+        return 1;
+    }
+    TraceHeader header{};
+    if (std::fread(&header, sizeof(header), 1, file) != 1 || std::memcmp(header.magic, "GTRC", 4)
+            || header.version != TRACE_VERSION || header.record_size != sizeof(TraceRecord)) {
+        std::cerr << argv[1] << " is not a version " << TRACE_VERSION << " search trace" << std::endl;
+        std::fclose(file);
+        return 1;
+    }
+
+    Summary summary;
+    std::vector<TraceRecord> search;
+    std::vector<TraceRecord> chunk(TraceWriter::BUFFER_RECORDS);
+    uint64_t searchIndex{0};
+    size_t read;
+    bool done{false};
+    while (!done && (read = std::fread(chunk.data(), sizeof(TraceRecord), chunk.size(), file)) > 0)
+        for (size_t i = 0; i < read && !done; ++i) {
+            search.push_back(chunk[i]);
+            if ((chunk[i].flags & TRACE_REASON_MASK) != TRACE_ROOT)
+                continue;
+            if (!tree)
+                summary.add(search);
+            else if (searchIndex == wanted) {
+                printTree(search, node, depth);
+                done = true;
+            }
+            ++searchIndex;
+            search.clear();
+        }
+    std::fclose(file);
+
+    if (!tree)
+        summary.print();
+    else if (!done) {
+        std::cerr << "the trace has " << searchIndex << " complete searches" << std::endl;
+        return 1;
+    }
+    return 0;
+}